@@ -0,0 +1,521 @@
+/*
+ ============================================================================
+ Name        : hev-fsh-acl.c
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Fsh forwarder port access list
+ ============================================================================
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include "hev-memory-allocator.h"
+
+#include "hev-fsh-acl.h"
+
+typedef struct _HevFshAclRange HevFshAclRange;
+typedef struct _HevFshAclNode HevFshAclNode;
+typedef struct _HevFshAclEntry HevFshAclEntry;
+
+struct _HevFshAclRange
+{
+    unsigned int lo;
+    unsigned int hi;
+    int action;
+};
+
+/* Binary trie over the address bits, one node per bit of a prefix. */
+struct _HevFshAclNode
+{
+    HevFshAclNode *child[2];
+    HevFshAclRange *ranges;
+    unsigned int count;
+};
+
+struct _HevFshAclEntry
+{
+    HevFshAclEntry *next;
+    unsigned int hash;
+    unsigned int port;
+    int type;
+    int action;
+    unsigned char addr[16];
+};
+
+struct _HevFshAcl
+{
+    HevFshAclEntry **buckets;
+    unsigned int mask;
+    unsigned int count;
+
+    HevFshAclNode *root[2];
+    int action;
+};
+
+HevFshAcl *
+hev_fsh_acl_new (int action)
+{
+    HevFshAcl *self;
+
+    self = hev_malloc0 (sizeof (HevFshAcl));
+    if (!self)
+        return NULL;
+
+    self->action = action;
+
+    return self;
+}
+
+static void
+hev_fsh_acl_node_free (HevFshAclNode *node)
+{
+    if (!node)
+        return;
+
+    hev_fsh_acl_node_free (node->child[0]);
+    hev_fsh_acl_node_free (node->child[1]);
+    hev_free (node->ranges);
+    hev_free (node);
+}
+
+void
+hev_fsh_acl_destroy (HevFshAcl *self)
+{
+    unsigned int i;
+
+    for (i = 0; self->buckets && i <= self->mask; i++) {
+        HevFshAclEntry *iter = self->buckets[i];
+
+        while (iter) {
+            HevFshAclEntry *entry = iter;
+
+            iter = iter->next;
+            hev_free (entry);
+        }
+    }
+
+    hev_fsh_acl_node_free (self->root[0]);
+    hev_fsh_acl_node_free (self->root[1]);
+    hev_free (self->buckets);
+    hev_free (self);
+}
+
+static unsigned int
+hev_fsh_acl_hash (int type, const unsigned char *addr, unsigned int port)
+{
+    unsigned int hash = 2166136261u;
+    int i, len = (type == 4) ? 4 : 16;
+
+    for (i = 0; i < len; i++)
+        hash = (hash ^ addr[i]) * 16777619u;
+    hash = (hash ^ (port & 0xff)) * 16777619u;
+    hash = (hash ^ (port >> 8)) * 16777619u;
+
+    return hash;
+}
+
+static int
+hev_fsh_acl_grow (HevFshAcl *self)
+{
+    HevFshAclEntry **buckets;
+    unsigned int size;
+    unsigned int i;
+
+    size = self->buckets ? (self->mask + 1) * 2 : 16;
+    buckets = hev_calloc (size, sizeof (HevFshAclEntry *));
+    if (!buckets)
+        return -1;
+
+    for (i = 0; self->buckets && i <= self->mask; i++) {
+        HevFshAclEntry *iter = self->buckets[i];
+
+        while (iter) {
+            HevFshAclEntry *entry = iter;
+            unsigned int j = entry->hash & (size - 1);
+
+            iter = iter->next;
+            entry->next = buckets[j];
+            buckets[j] = entry;
+        }
+    }
+
+    hev_free (self->buckets);
+    self->buckets = buckets;
+    self->mask = size - 1;
+
+    return 0;
+}
+
+static int
+hev_fsh_acl_add_exact (HevFshAcl *self, int type, const unsigned char *addr,
+                       unsigned int port, int action)
+{
+    HevFshAclEntry *entry;
+    unsigned int hash;
+    int len = (type == 4) ? 4 : 16;
+
+    hash = hev_fsh_acl_hash (type, addr, port);
+    if (self->buckets) {
+        entry = self->buckets[hash & self->mask];
+        for (; entry; entry = entry->next) {
+            if (entry->type == type && entry->port == port &&
+                memcmp (entry->addr, addr, len) == 0) {
+                entry->action = action;
+                return 0;
+            }
+        }
+    }
+
+    if (self->count >= (self->buckets ? self->mask + 1 : 0))
+        if (hev_fsh_acl_grow (self) < 0)
+            return -1;
+
+    entry = hev_malloc0 (sizeof (HevFshAclEntry));
+    if (!entry)
+        return -1;
+
+    entry->hash = hash;
+    entry->port = port;
+    entry->type = type;
+    entry->action = action;
+    memcpy (entry->addr, addr, len);
+
+    entry->next = self->buckets[hash & self->mask];
+    self->buckets[hash & self->mask] = entry;
+    self->count++;
+
+    return 0;
+}
+
+static void
+hev_fsh_acl_node_insert (HevFshAclNode *node, unsigned int lo,
+                         unsigned int hi, int action)
+{
+    HevFshAclRange *ranges = node->ranges;
+    unsigned int i;
+
+    for (i = node->count; i > 0 && ranges[i - 1].lo > lo; i--)
+        ranges[i] = ranges[i - 1];
+
+    ranges[i].lo = lo;
+    ranges[i].hi = hi;
+    ranges[i].action = action;
+    node->count++;
+}
+
+static int
+hev_fsh_acl_node_add_range (HevFshAclNode *node, unsigned int lo,
+                            unsigned int hi, int action)
+{
+    const int pool = HEV_FSH_ACL_POOL (0xf);
+    HevFshAclRange *ranges;
+    HevFshAclRange tail = { 0 };
+    unsigned int i;
+
+    /*
+     * Keep ranges sorted and disjoint so lookup is a binary search: merge
+     * overlapping or adjacent ranges of the same action, refuse overlaps
+     * with a different verdict. The pool depth is not part of the verdict:
+     * where only that differs, the later rule's depth holds for its ports.
+     */
+    for (i = 0; i < node->count; i++) {
+        HevFshAclRange *r = &node->ranges[i];
+
+        if (r->lo <= hi && r->hi >= lo &&
+            (r->action & ~pool) != (action & ~pool))
+            return -1;
+    }
+
+    /* room for the new range and the tail of one it splits */
+    ranges = hev_realloc (node->ranges,
+                          sizeof (HevFshAclRange) * (node->count + 2));
+    if (!ranges)
+        return -1;
+    node->ranges = ranges;
+
+    for (i = 0; i < node->count; i++) {
+        HevFshAclRange *r = &node->ranges[i];
+
+        if (r->hi + 1 < lo)
+            continue;
+        if (r->lo > hi + 1)
+            break;
+
+        if (r->action != action) {
+            if (r->lo > hi || r->hi < lo)
+                continue;
+
+            if (r->lo < lo && r->hi > hi) {
+                tail.lo = hi + 1;
+                tail.hi = r->hi;
+                tail.action = r->action;
+                r->hi = lo - 1;
+            } else if (r->lo < lo) {
+                r->hi = lo - 1;
+            } else if (r->hi > hi) {
+                r->lo = hi + 1;
+            } else {
+                node->count--;
+                memmove (r, r + 1,
+                         sizeof (HevFshAclRange) * (node->count - i));
+                i--;
+            }
+            continue;
+        }
+
+        lo = (r->lo < lo) ? r->lo : lo;
+        hi = (r->hi > hi) ? r->hi : hi;
+        node->count--;
+        memmove (r, r + 1, sizeof (HevFshAclRange) * (node->count - i));
+        i--;
+    }
+
+    hev_fsh_acl_node_insert (node, lo, hi, action);
+    if (tail.lo)
+        hev_fsh_acl_node_insert (node, tail.lo, tail.hi, tail.action);
+
+    return 0;
+}
+
+static int
+hev_fsh_acl_add_prefix (HevFshAcl *self, int type, const unsigned char *addr,
+                        unsigned int prefix, unsigned int lo, unsigned int hi,
+                        int action)
+{
+    HevFshAclNode **pnode = &self->root[type == 6];
+    unsigned int i;
+
+    for (i = 0;; i++) {
+        if (!*pnode) {
+            *pnode = hev_malloc0 (sizeof (HevFshAclNode));
+            if (!*pnode)
+                return -1;
+        }
+
+        if (i == prefix)
+            break;
+
+        pnode = &(*pnode)->child[(addr[i >> 3] >> (7 - (i & 7))) & 1];
+    }
+
+    return hev_fsh_acl_node_add_range (*pnode, lo, hi, action);
+}
+
+static int
+hev_fsh_acl_insert (HevFshAcl *self, int type, const unsigned char *addr,
+                    unsigned int prefix, unsigned int lo, unsigned int hi,
+                    int action)
+{
+    unsigned int bits = (type == 4) ? 32 : 128;
+
+    if (prefix == bits && lo == hi)
+        return hev_fsh_acl_add_exact (self, type, addr, lo, action);
+
+    return hev_fsh_acl_add_prefix (self, type, addr, prefix, lo, hi, action);
+}
+
+int
+hev_fsh_acl_add (HevFshAcl *self, int type, const void *addr,
+                 unsigned int prefix, unsigned int port_lo,
+                 unsigned int port_hi, int action)
+{
+    const unsigned char *a = addr;
+    unsigned char m[16] = { 0 };
+    int res;
+
+    if (port_lo > port_hi || port_hi > 65535)
+        return -1;
+
+    switch (type) {
+    case 4:
+        if (prefix > 32)
+            return -1;
+        res = hev_fsh_acl_insert (self, 4, a, prefix, port_lo, port_hi,
+                                  action);
+        if (res < 0)
+            return -1;
+        m[10] = 0xff;
+        m[11] = 0xff;
+        memcpy (&m[12], a, 4);
+        return hev_fsh_acl_insert (self, 6, m, prefix + 96, port_lo, port_hi,
+                                   action);
+    case 6:
+        if (prefix > 128)
+            return -1;
+        res = hev_fsh_acl_insert (self, 6, a, prefix, port_lo, port_hi,
+                                  action);
+        if (res < 0)
+            return -1;
+        if (prefix < 96 || !IN6_IS_ADDR_V4MAPPED ((struct in6_addr *)a))
+            return 0;
+        return hev_fsh_acl_insert (self, 4, &a[12], prefix - 96, port_lo,
+                                   port_hi, action);
+    }
+
+    return -1;
+}
+
+static int
+parse_number (const char *str, unsigned int max, unsigned int *val)
+{
+    unsigned long v;
+    char *end;
+
+    if (*str < '0' || *str > '9')
+        return -1;
+
+    v = strtoul (str, &end, 10);
+    if (*end != '\0' || v > max)
+        return -1;
+
+    *val = v;
+    return 0;
+}
+
+int
+hev_fsh_acl_add_rule (HevFshAcl *self, const char *str, int action)
+{
+    unsigned char addr[16];
+    unsigned int prefix;
+    unsigned int lo, hi;
+    char *host, *ports, *p;
+    char b[128];
+    int type;
+    size_t len;
+
+    len = strcspn (str, ",");
+    if (len >= sizeof (b))
+        return -1;
+    memcpy (b, str, len);
+    b[len] = '\0';
+
+    if (b[0] == '[') {
+        host = &b[1];
+        p = strchr (host, ']');
+        if (!p || p[1] != ':')
+            return -1;
+        *p = '\0';
+        ports = &p[2];
+    } else {
+        host = b;
+        p = strchr (host, ':');
+        if (!p)
+            return -1;
+        *p = '\0';
+        ports = &p[1];
+    }
+
+    p = strchr (host, '/');
+    if (p)
+        *p++ = '\0';
+
+    if (inet_pton (AF_INET, host, addr) == 1)
+        type = 4;
+    else if (inet_pton (AF_INET6, host, addr) == 1)
+        type = 6;
+    else
+        return -1;
+
+    prefix = (type == 4) ? 32 : 128;
+    if (p && parse_number (p, prefix, &prefix) < 0)
+        return -1;
+
+    p = strchr (ports, '+');
+    if (p) {
+        unsigned int depth = 2;
+
+        *p++ = '\0';
+        if (!(action & HEV_FSH_ACL_ALLOW))
+            return -1;
+        if (*p && (parse_number (p, 15, &depth) < 0 || !depth))
+            return -1;
+        action |= HEV_FSH_ACL_POOL (depth);
+    }
+
+    if (strcmp (ports, "*") == 0) {
+        lo = 0;
+        hi = 65535;
+    } else {
+        p = strchr (ports, '-');
+        if (p)
+            *p++ = '\0';
+        if (parse_number (ports, 65535, &lo) < 0)
+            return -1;
+        hi = lo;
+        if (p && parse_number (p, 65535, &hi) < 0)
+            return -1;
+    }
+
+    return hev_fsh_acl_add (self, type, addr, prefix, lo, hi, action);
+}
+
+static HevFshAclRange *
+hev_fsh_acl_node_find (HevFshAclNode *node, unsigned int port)
+{
+    unsigned int l = 0, h = node->count;
+
+    while (l < h) {
+        unsigned int m = (l + h) / 2;
+        HevFshAclRange *r = &node->ranges[m];
+
+        if (port < r->lo)
+            h = m;
+        else if (port > r->hi)
+            l = m + 1;
+        else
+            return r;
+    }
+
+    return NULL;
+}
+
+int
+hev_fsh_acl_lookup (HevFshAcl *self, int type, const void *addr,
+                    unsigned int port)
+{
+    const unsigned char *a = addr;
+    HevFshAclRange *best = NULL;
+    HevFshAclNode *node;
+    unsigned int bits;
+    unsigned int i;
+
+    if (type != 4 && type != 6)
+        return 0;
+
+    if (self->count) {
+        HevFshAclEntry *entry;
+        unsigned int hash;
+
+        hash = hev_fsh_acl_hash (type, a, port);
+        entry = self->buckets[hash & self->mask];
+        for (; entry; entry = entry->next) {
+            if (entry->hash == hash && entry->type == type &&
+                entry->port == port &&
+                memcmp (entry->addr, a, (type == 4) ? 4 : 16) == 0)
+                return entry->action;
+        }
+    }
+
+    bits = (type == 4) ? 32 : 128;
+    node = self->root[type == 6];
+    for (i = 0; node; i++) {
+        if (node->count) {
+            HevFshAclRange *r = hev_fsh_acl_node_find (node, port);
+            if (r)
+                best = r;
+        }
+
+        if (i == bits)
+            break;
+
+        node = node->child[(a[i >> 3] >> (7 - (i & 7))) & 1];
+    }
+
+    if (best)
+        return best->action;
+
+    return self->action;
+}
@@ -0,0 +1,41 @@
+/*
+ ============================================================================
+ Name        : hev-fsh-acl.h
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Fsh forwarder port access list
+ ============================================================================
+ */
+
+#ifndef __HEV_FSH_ACL_H__
+#define __HEV_FSH_ACL_H__
+
+#define HEV_FSH_ACL_ALLOW (1 << 0)
+#define HEV_FSH_ACL_POOL(depth) ((depth) << 4)
+#define HEV_FSH_ACL_POOL_DEPTH(action) (((action) >> 4) & 0xf)
+
+typedef struct _HevFshAcl HevFshAcl;
+
+/*
+ * Rules are ADDR[/LEN]:PORTS[+[N]] or [ADDR6[/LEN]]:PORTS[+[N]], where PORTS
+ * is a port, a LO-HI range or '*', and a '+' on an allow rule keeps N (2 by
+ * default) upstream connections ready for its targets. Lookup order: an
+ * exact ADDR:PORT rule, then the longest matching prefix that has a range
+ * holding the port, then the default action. IPv4 rules also match their
+ * v4-mapped IPv6 form.
+ */
+HevFshAcl *hev_fsh_acl_new (int action);
+void hev_fsh_acl_destroy (HevFshAcl *self);
+
+/* Parses one rule, up to ',' or the end of str. */
+int hev_fsh_acl_add_rule (HevFshAcl *self, const char *str, int action);
+
+int hev_fsh_acl_add (HevFshAcl *self, int type, const void *addr,
+                     unsigned int prefix, unsigned int port_lo,
+                     unsigned int port_hi, int action);
+
+/* port is in host byte order. */
+int hev_fsh_acl_lookup (HevFshAcl *self, int type, const void *addr,
+                        unsigned int port);
+
+#endif /* __HEV_FSH_ACL_H__ */
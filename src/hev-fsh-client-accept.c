@@ -52,20 +52,29 @@ hev_fsh_client_accept_send_accept (HevFshClientAccept *self)
     if (res <= 0)
         return -1;
 
+    res = hev_fsh_client_base_recv_hello (base);
+    if (res < 0)
+        return -1;
+
     res = hev_fsh_client_base_encrypt (base);
     if (res < 0)
         return -1;
 
+    res = hev_fsh_client_base_compress (base);
+    if (res < 0)
+        return -1;
+
     return 0;
 }
 
 int
-hev_fsh_client_accept_construct (HevFshClientAccept *self, HevFshConfig *config,
+hev_fsh_client_accept_construct (HevFshClientAccept *self,
+                                 HevFshConfig *config, HevFshContext *context,
                                  HevFshToken token)
 {
     int res;
 
-    res = hev_fsh_client_base_construct (&self->base, config);
+    res = hev_fsh_client_base_construct (&self->base, config, context);
     if (res < 0)
         return res;
 
@@ -40,7 +40,8 @@ struct _HevFshClientAcceptClass
 HevObjectClass *hev_fsh_client_accept_class (void);
 
 int hev_fsh_client_accept_construct (HevFshClientAccept *self,
-                                     HevFshConfig *config, HevFshToken token);
+                                     HevFshConfig *config,
+                                     HevFshContext *context, HevFshToken token);
 
 int hev_fsh_client_accept_send_accept (HevFshClientAccept *self);
 
@@ -13,10 +13,16 @@
 #include <unistd.h>
 #include <string.h>
 #include <signal.h>
+#include <netinet/tcp.h>
 
 #ifdef __linux__
 #include <linux-tls.h>
-#include <netinet/tcp.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#elif defined(__aarch64__) && defined(__linux__)
+#include <sys/auxv.h>
 #endif
 
 #include <hev-task.h>
@@ -25,7 +31,13 @@
 #include <hev-memory-allocator.h>
 
 #include "hev-logger.h"
+#include "hev-hkdf.h"
 #include "hev-random.h"
+#include "hev-task-io-us.h"
+#include "hev-task-io-lz4.h"
+#include "hev-task-io-tls.h"
+#include "hev-task-io-uring.h"
+#include "hev-fsh-protocol.h"
 
 #include "hev-fsh-client-base.h"
 
@@ -37,14 +49,24 @@
 #define TCP_ULP 31
 #endif
 
+#ifndef IPPROTO_MPTCP
+#define IPPROTO_MPTCP 262
+#endif
+
 static int
-hev_fsh_client_base_socket (HevFshClientBase *self, int family)
+hev_fsh_client_base_socket (HevFshClientBase *self, int family, int mptcp)
 {
     int flags;
     int res;
-    int fd;
+    int fd = -1;
 
-    fd = hev_task_io_socket_socket (family, SOCK_STREAM, IPPROTO_TCP);
+#ifdef __linux__
+    /* no MPTCP in the kernel (or disabled by sysctl): plain TCP */
+    if (mptcp)
+        fd = hev_task_io_socket_socket (family, SOCK_STREAM, IPPROTO_MPTCP);
+#endif
+    if (fd < 0)
+        fd = hev_task_io_socket_socket (family, SOCK_STREAM, IPPROTO_TCP);
     if (fd < 0)
         return -1;
 
@@ -81,7 +103,7 @@ hev_fsh_client_base_listen (HevFshClientBase *self)
         return -1;
     }
 
-    fd = hev_fsh_client_base_socket (self, addr->sa_family);
+    fd = hev_fsh_client_base_socket (self, addr->sa_family, 0);
     if (fd < 0)
         return -1;
 
@@ -117,6 +139,7 @@ hev_fsh_client_base_connect (HevFshClientBase *self)
     struct sockaddr *addr;
     socklen_t addr_len;
     const char *cc;
+    int mptcp;
     int res;
     int fd;
 
@@ -126,7 +149,8 @@ hev_fsh_client_base_connect (HevFshClientBase *self)
         return -1;
     }
 
-    fd = hev_fsh_client_base_socket (self, addr->sa_family);
+    mptcp = hev_fsh_config_get_mptcp (self->config);
+    fd = hev_fsh_client_base_socket (self, addr->sa_family, mptcp);
     if (fd < 0)
         return -1;
 
@@ -139,6 +163,15 @@ hev_fsh_client_base_connect (HevFshClientBase *self)
 #endif
     }
 
+    if (self->nodelay) {
+        int one = 1;
+
+        /* interactive: batching is the pump's job, not Nagle's */
+        res = setsockopt (fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof (one));
+        if (res < 0)
+            LOG_W ("%p fsh client base tcp nodelay", self);
+    }
+
     hev_task_add_fd (hev_task_self (), fd, POLLIN | POLLOUT);
 
     res = hev_task_io_socket_connect (fd, addr, addr_len, io_yielder, self);
@@ -148,62 +181,488 @@ hev_fsh_client_base_connect (HevFshClientBase *self)
         return -1;
     }
 
+    /* a reconnect: the new socket has no TLS ULP yet */
+    self->ktls = 0;
     self->fd = fd;
 
     return 0;
 }
 
-int
-hev_fsh_client_base_encrypt (HevFshClientBase *self)
+#ifdef __linux__
+static int
+hev_fsh_client_base_ulp (HevFshClientBase *self)
+{
+    int res;
+
+    if (!self->ktls) {
+        res = setsockopt (self->fd, SOL_TCP, TCP_ULP, "tls", sizeof ("tls"));
+        self->ktls = (res < 0) ? -1 : 1;
+    }
+
+    return self->ktls > 0;
+}
+#endif
+
+static int
+hev_fsh_client_base_has_aes (void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int a, b, c, d;
+
+    if (!__get_cpuid (1, &a, &b, &c, &d))
+        return 0;
+
+    return !!(c & bit_AES);
+#elif defined(__aarch64__) && defined(__linux__)
+    return !!(getauxval (AT_HWCAP) & HWCAP_AES);
+#else
+    return 0;
+#endif
+}
+
+static int
+hev_fsh_client_base_prefer (int ciphers)
+{
+    int aes = hev_fsh_client_base_has_aes ();
+
+    /* AES-GCM in software is several times slower than ChaCha20 */
+    if (!aes && (ciphers & HEV_FSH_CONFIG_CIPHER_CHACHA20_POLY1305))
+        return HEV_FSH_CONFIG_CIPHER_CHACHA20_POLY1305;
+    if (ciphers & HEV_FSH_CONFIG_CIPHER_AES_256_GCM)
+        return HEV_FSH_CONFIG_CIPHER_AES_256_GCM;
+    if (ciphers & HEV_FSH_CONFIG_CIPHER_AES_128_GCM)
+        return HEV_FSH_CONFIG_CIPHER_AES_128_GCM;
+
+    return HEV_FSH_CONFIG_CIPHER_CHACHA20_POLY1305;
+}
+
+static int
+hev_fsh_client_base_ciphers (HevFshClientBase *self, int ciphers)
 {
 #ifdef __linux__
-    struct tls12_crypto_info_aes_gcm_128 ci;
+    int us = HEV_FSH_CONFIG_CIPHER_CHACHA20_POLY1305;
+
+    if (hev_fsh_client_base_ulp (self))
+        return ciphers;
+
+    /* without kTLS, only offer what the user-space records can do */
+    if (hev_task_io_tls_supported (TLS_CIPHER_AES_GCM_128))
+        us |= HEV_FSH_CONFIG_CIPHER_AES_128_GCM;
+    if (hev_task_io_tls_supported (TLS_CIPHER_AES_GCM_256))
+        us |= HEV_FSH_CONFIG_CIPHER_AES_256_GCM;
+    if (ciphers & us)
+        return ciphers & us;
+#endif
+
+    return ciphers;
+}
+
+static int
+hev_fsh_client_base_select (HevFshMessageHello *local,
+                            HevFshMessageHello *remote)
+{
+    int ciphers = local->ciphers & remote->ciphers;
+
+    if (!ciphers)
+        return 0;
+
+    /* a peer without AES instructions gets its way */
+    if ((ciphers & HEV_FSH_CONFIG_CIPHER_CHACHA20_POLY1305) &&
+        (local->cipher == HEV_FSH_CONFIG_CIPHER_CHACHA20_POLY1305 ||
+         remote->cipher == HEV_FSH_CONFIG_CIPHER_CHACHA20_POLY1305))
+        return HEV_FSH_CONFIG_CIPHER_CHACHA20_POLY1305;
+    if (ciphers & local->cipher)
+        return local->cipher;
+    if (ciphers & remote->cipher)
+        return remote->cipher;
+
+    return hev_fsh_client_base_prefer (ciphers);
+}
+
+static void
+hev_fsh_client_base_hello_init (HevFshClientBase *self,
+                                HevFshMessageHello *hello)
+{
     HevFshConfigKey *key;
-    int res;
 
-    LOG_D ("%p fsh client base encrypt", self);
+    memset (hello, 0, sizeof (HevFshMessageHello));
+    memcpy (hello->magic, HEV_FSH_HELLO_MAGIC, sizeof (hello->magic));
+    hello->ver = HEV_FSH_HELLO_VERSION;
 
     key = hev_fsh_config_get_key (self->config);
-    if (!key)
+    if (key && key->ciphers) {
+        hello->ciphers = hev_fsh_client_base_ciphers (self, key->ciphers);
+        hello->cipher = hev_fsh_client_base_prefer (hello->ciphers);
+        hello->flags |= HEV_FSH_HELLO_F_TLS13;
+    }
+
+    if (hev_fsh_config_get_compress (self->config))
+        hello->flags |= HEV_FSH_HELLO_F_LZ4;
+
+    /* session type specific, on both ends */
+    hello->flags |= self->offer;
+}
+
+int
+hev_fsh_client_base_hello_needed (HevFshClientBase *self)
+{
+    HevFshConfigKey *key;
+
+    key = hev_fsh_config_get_key (self->config);
+    if (key && key->ciphers)
+        return 1;
+
+    return hev_fsh_config_get_compress (self->config);
+}
+
+int
+hev_fsh_client_base_send_hello (HevFshClientBase *self)
+{
+    HevFshMessageHello hello;
+    HevFshMessageHello peer;
+    int res;
+
+    hev_fsh_client_base_hello_init (self, &hello);
+
+    /* nothing to negotiate: stay byte-compatible with old forwarders */
+    if (!hello.ciphers && !hello.flags)
         return 0;
 
-    ci.info.version = TLS_1_2_VERSION;
-    ci.info.cipher_type = TLS_CIPHER_AES_GCM_128;
-    hev_random_get_bytes (ci.iv, TLS_CIPHER_AES_GCM_128_IV_SIZE);
-    memcpy (ci.key, key->key, TLS_CIPHER_AES_GCM_128_KEY_SIZE);
-    memcpy (ci.salt, key->salt, TLS_CIPHER_AES_GCM_128_SALT_SIZE);
-    memset (ci.rec_seq, 0, TLS_CIPHER_AES_GCM_128_REC_SEQ_SIZE);
+    LOG_D ("%p fsh client base send hello", self);
 
-    res = hev_task_io_socket_send (self->fd, ci.iv, sizeof (ci.iv), MSG_WAITALL,
-                                   io_yielder, self);
+    res = hev_task_io_socket_send (self->fd, &hello, sizeof (hello),
+                                   MSG_WAITALL, io_yielder, self);
     if (res <= 0)
         return -1;
 
-    res = setsockopt (self->fd, SOL_TCP, TCP_ULP, "tls", sizeof ("tls"));
-    if (res < 0) {
-        LOG_E ("%p fsh client base tls (modprobe tls)", self);
+    res = hev_task_io_socket_recv (self->fd, &peer, sizeof (peer),
+                                   MSG_WAITALL, io_yielder, self);
+    if (res != sizeof (peer))
+        return -1;
+
+    if (memcmp (peer.magic, hello.magic, sizeof (peer.magic)) != 0) {
+        LOG_E ("%p fsh client base hello", self);
         return -1;
     }
 
-    res = setsockopt (self->fd, SOL_TLS, TLS_TX, &ci, sizeof (ci));
-    if (res < 0)
+    if (hello.ciphers && !(peer.cipher & hello.ciphers)) {
+        LOG_E ("%p fsh client base no common cipher", self);
+        return -1;
+    }
+
+    self->cipher = peer.cipher;
+    self->flags = peer.flags & hello.flags;
+
+    return 0;
+}
+
+int
+hev_fsh_client_base_recv_hello (HevFshClientBase *self)
+{
+    HevFshMessageHello hello;
+    HevFshMessageHello peer;
+    int res;
+
+    /* the magic may arrive split: wait for all of it before deciding */
+    for (;;) {
+        res = hev_task_io_socket_recv (self->fd, &peer, sizeof (peer.magic),
+                                       MSG_PEEK, io_yielder, self);
+        if (res <= 0)
+            return -1;
+        if (res == sizeof (peer.magic))
+            break;
+        if (memcmp (peer.magic, HEV_FSH_HELLO_MAGIC, res) != 0)
+            return 0;
+        if (io_yielder (HEV_TASK_WAITIO, self) < 0)
+            return -1;
+    }
+
+    if (memcmp (peer.magic, HEV_FSH_HELLO_MAGIC, sizeof (peer.magic)) != 0)
+        return 0;
+
+    LOG_D ("%p fsh client base recv hello", self);
+
+    res = hev_task_io_socket_recv (self->fd, &peer, sizeof (peer),
+                                   MSG_WAITALL, io_yielder, self);
+    if (res != sizeof (peer))
         return -1;
 
-    res = hev_task_io_socket_recv (self->fd, ci.iv, sizeof (ci.iv), MSG_WAITALL,
+    hev_fsh_client_base_hello_init (self, &hello);
+    hello.cipher = hev_fsh_client_base_select (&hello, &peer);
+    /* compression is the connector's call */
+    hello.flags |= HEV_FSH_HELLO_F_LZ4;
+    hello.flags &= peer.flags;
+
+    res = hev_task_io_socket_send (self->fd, &hello, sizeof (hello),
+                                   MSG_WAITALL, io_yielder, self);
+    if (res <= 0)
+        return -1;
+
+    if (peer.ciphers && !hello.cipher) {
+        LOG_E ("%p fsh client base no common cipher", self);
+        return -1;
+    }
+
+    self->cipher = hello.cipher;
+    self->flags = hello.flags;
+
+    return 0;
+}
+
+#ifdef __linux__
+typedef union _HevFshClientBaseCryptoInfo HevFshClientBaseCryptoInfo;
+
+union _HevFshClientBaseCryptoInfo
+{
+    struct tls_crypto_info info;
+    struct tls12_crypto_info_aes_gcm_128 aes128;
+    struct tls12_crypto_info_aes_gcm_256 aes256;
+    struct tls12_crypto_info_chacha20_poly1305 chacha;
+};
+
+static size_t
+hev_fsh_client_base_crypto_info (HevFshClientBaseCryptoInfo *ci, int cipher,
+                                 int version, const unsigned char *key,
+                                 const unsigned char *salt,
+                                 const unsigned char *iv)
+{
+    memset (ci, 0, sizeof (HevFshClientBaseCryptoInfo));
+    ci->info.version = version;
+
+    switch (cipher) {
+    case HEV_FSH_CONFIG_CIPHER_AES_256_GCM:
+        ci->info.cipher_type = TLS_CIPHER_AES_GCM_256;
+        memcpy (ci->aes256.key, key, TLS_CIPHER_AES_GCM_256_KEY_SIZE);
+        memcpy (ci->aes256.salt, salt, TLS_CIPHER_AES_GCM_256_SALT_SIZE);
+        memcpy (ci->aes256.iv, iv, TLS_CIPHER_AES_GCM_256_IV_SIZE);
+        return sizeof (ci->aes256);
+    case HEV_FSH_CONFIG_CIPHER_CHACHA20_POLY1305:
+        ci->info.cipher_type = TLS_CIPHER_CHACHA20_POLY1305;
+        memcpy (ci->chacha.key, key, TLS_CIPHER_CHACHA20_POLY1305_KEY_SIZE);
+        memcpy (ci->chacha.iv, iv, TLS_CIPHER_CHACHA20_POLY1305_IV_SIZE);
+        return sizeof (ci->chacha);
+    default:
+        ci->info.cipher_type = TLS_CIPHER_AES_GCM_128;
+        memcpy (ci->aes128.key, key, TLS_CIPHER_AES_GCM_128_KEY_SIZE);
+        memcpy (ci->aes128.salt, salt, TLS_CIPHER_AES_GCM_128_SALT_SIZE);
+        memcpy (ci->aes128.iv, iv, TLS_CIPHER_AES_GCM_128_IV_SIZE);
+        return sizeof (ci->aes128);
+    }
+}
+
+static int
+hev_fsh_client_base_encrypt_install (HevFshClientBase *self,
+                                     HevFshClientBaseCryptoInfo *tx,
+                                     HevFshClientBaseCryptoInfo *rx,
+                                     size_t size)
+{
+    HevTask *task = hev_task_self ();
+    int one = 1;
+    int fd;
+
+    if (hev_fsh_client_base_ulp (self) &&
+        setsockopt (self->fd, SOL_TLS, TLS_TX, tx, size) == 0) {
+        if (setsockopt (self->fd, SOL_TLS, TLS_RX, rx, size) < 0)
+            return -1;
+
+        /* kTLS never pads on TX; lets RX skip the padding scan (Linux 6.0+) */
+        if (tx->info.version == TLS_1_3_VERSION)
+            setsockopt (self->fd, SOL_TLS, TLS_RX_EXPECT_NO_PAD, &one,
+                        sizeof (one));
+
+        /* spliced pages are never written again: NIC offload may skip a copy */
+        setsockopt (self->fd, SOL_TLS, TLS_TX_ZEROCOPY_RO, &one, sizeof (one));
+        return 0;
+    }
+
+    /* no kTLS (modprobe tls), or too old for the cipher: same records */
+    LOG_D ("%p fsh client base user-space tls", self);
+
+    hev_task_del_fd (task, self->fd);
+    fd = hev_task_io_tls_start (self->fd, tx, rx,
+                                HEV_FSH_CONFIG_TASK_STACK_SIZE,
+                                HEV_FSH_IO (self)->timeout);
+    if (fd < 0) {
+        hev_task_add_fd (task, self->fd, POLLIN | POLLOUT);
+        LOG_E ("%p fsh client base tls cipher %d", self, self->cipher);
+        return -1;
+    }
+
+    self->fd = fd;
+    hev_task_add_fd (task, self->fd, POLLIN | POLLOUT);
+
+    return 0;
+}
+
+static int
+hev_fsh_client_base_encrypt_tls12 (HevFshClientBase *self,
+                                   HevFshConfigKey *key)
+{
+    HevFshClientBaseCryptoInfo tx, rx;
+    unsigned char iv[12];
+    size_t iv_size;
+    size_t size;
+    int res;
+
+    if (self->cipher == HEV_FSH_CONFIG_CIPHER_CHACHA20_POLY1305)
+        iv_size = TLS_CIPHER_CHACHA20_POLY1305_IV_SIZE;
+    else
+        iv_size = TLS_CIPHER_AES_GCM_128_IV_SIZE;
+
+    hev_random_get_bytes (iv, iv_size);
+
+    res = hev_task_io_socket_send (self->fd, iv, iv_size, MSG_WAITALL,
                                    io_yielder, self);
-    if (res != sizeof (ci.iv))
+    if (res <= 0)
         return -1;
 
-    res = setsockopt (self->fd, SOL_TLS, TLS_RX, &ci, sizeof (ci));
-    if (res < 0)
+    size = hev_fsh_client_base_crypto_info (&tx, self->cipher, TLS_1_2_VERSION,
+                                            key->key, key->salt, iv);
+
+    res = hev_task_io_socket_recv (self->fd, iv, iv_size, MSG_WAITALL,
+                                   io_yielder, self);
+    if (res != iv_size)
         return -1;
 
+    hev_fsh_client_base_crypto_info (&rx, self->cipher, TLS_1_2_VERSION,
+                                     key->key, key->salt, iv);
+
+    return hev_fsh_client_base_encrypt_install (self, &tx, &rx, size);
+}
+
+static int
+hev_fsh_client_base_encrypt_tls13 (HevFshClientBase *self,
+                                   HevFshConfigKey *key)
+{
+    HevFshClientBaseCryptoInfo tx, rx;
+    unsigned char nonce[2][16];
+    unsigned char okm[2][48];
+    unsigned char salt[32];
+    unsigned char ikm[36];
+    unsigned char info[12];
+    unsigned char *k;
+    size_t size;
+    int res;
+    int side;
+    int i;
+
+    hev_random_get_bytes (nonce[0], sizeof (nonce[0]));
+
+    res = hev_task_io_socket_send (self->fd, nonce[0], sizeof (nonce[0]),
+                                   MSG_WAITALL, io_yielder, self);
+    if (res <= 0)
+        return -1;
+
+    res = hev_task_io_socket_recv (self->fd, nonce[1], sizeof (nonce[1]),
+                                   MSG_WAITALL, io_yielder, self);
+    if (res != sizeof (nonce[1]))
+        return -1;
+
+    /* both ends sort the nonces the same way, so no role is needed */
+    res = memcmp (nonce[0], nonce[1], sizeof (nonce[0]));
+    if (res == 0)
+        return -1;
+    side = res < 0 ? 0 : 1;
+    memcpy (salt, nonce[side], sizeof (nonce[side]));
+    memcpy (salt + sizeof (nonce[side]), nonce[!side], sizeof (nonce[!side]));
+
+    memcpy (ikm, key->key, sizeof (key->key));
+    memcpy (ikm + sizeof (key->key), key->salt, sizeof (key->salt));
+
+    /* okm[0] keys the lower nonce's side, okm[1] the other: key salt iv */
+    memcpy (info, "fsh tls13 ", 10);
+    info[11] = self->cipher;
+    for (i = 0; i < 2; i++) {
+        info[10] = i ? 'H' : 'L';
+        hev_hkdf_sha256 (salt, sizeof (salt), ikm, sizeof (ikm), info,
+                         sizeof (info), okm[i], sizeof (okm[i]));
+    }
+
+    k = okm[side];
+    size = hev_fsh_client_base_crypto_info (&tx, self->cipher, TLS_1_3_VERSION,
+                                            k, k + 32, k + 36);
+    k = okm[!side];
+    hev_fsh_client_base_crypto_info (&rx, self->cipher, TLS_1_3_VERSION, k,
+                                     k + 32, k + 36);
+
+    return hev_fsh_client_base_encrypt_install (self, &tx, &rx, size);
+}
+#endif
+
+int
+hev_fsh_client_base_encrypt (HevFshClientBase *self)
+{
+#ifdef __linux__
+    HevFshConfigKey *key;
+
+    LOG_D ("%p fsh client base encrypt", self);
+
+    key = hev_fsh_config_get_key (self->config);
+    if (!key)
+        return 0;
+
+    if (self->flags & HEV_FSH_HELLO_F_TLS13)
+        return hev_fsh_client_base_encrypt_tls13 (self, key);
+
+    return hev_fsh_client_base_encrypt_tls12 (self, key);
+#else
+    return 0;
 #endif
+}
+
+int
+hev_fsh_client_base_compress (HevFshClientBase *self)
+{
+    HevTask *task = hev_task_self ();
+    int fd;
+
+    if (!(self->flags & HEV_FSH_HELLO_F_LZ4))
+        return 0;
+
+    LOG_D ("%p fsh client base compress", self);
+
+    /* below it the stream is already encrypted: compress on top */
+    hev_task_del_fd (task, self->fd);
+    fd = hev_task_io_lz4_start (self->fd, HEV_FSH_CONFIG_TASK_STACK_SIZE,
+                                HEV_FSH_IO (self)->timeout);
+    if (fd < 0) {
+        hev_task_add_fd (task, self->fd, POLLIN | POLLOUT);
+        LOG_E ("%p fsh client base compress", self);
+        return -1;
+    }
+
+    self->fd = fd;
+    hev_task_add_fd (task, self->fd, POLLIN | POLLOUT);
+
     return 0;
 }
 
+void
+hev_fsh_client_base_splice (HevFshClientBase *self, int ifd, int ofd)
+{
+    HevFshConfig *config = self->config;
+    size_t min, max;
+
+    LOG_D ("%p fsh client base splice", self);
+
+    min = hev_fsh_config_get_buf_min (config);
+    max = hev_fsh_config_get_buf_max (config);
+
+    if (hev_task_io_uring_enabled ())
+        hev_task_io_uring_splice (self->fd, self->fd, ifd, ofd, io_yielder,
+                                  self);
+    else if (hev_fsh_config_is_ugly_ktls (config) && (self->ktls > 0))
+        /* only splicing out of kTLS RX is broken: TX stays zero-copy */
+        hev_task_io_us_splice_tx (ifd, ofd, self->fd, self->fd, min, max,
+                                  io_yielder, self);
+    else /* pipe capacity is charged to the user whether used or not */
+        hev_task_io_splice (self->fd, self->fd, ifd, ofd, min, io_yielder,
+                            self);
+}
+
 int
-hev_fsh_client_base_construct (HevFshClientBase *self, HevFshConfig *config)
+hev_fsh_client_base_construct (HevFshClientBase *self, HevFshConfig *config,
+                               HevFshContext *context)
 {
     int res;
     unsigned int timeout;
@@ -219,6 +678,7 @@ hev_fsh_client_base_construct (HevFshClientBase *self, HevFshConfig *config)
 
     self->fd = -1;
     self->config = config;
+    self->context = context;
     signal (SIGCHLD, SIG_IGN);
 
     return 0;
@@ -12,6 +12,7 @@
 
 #include "hev-fsh-io.h"
 #include "hev-fsh-config.h"
+#include "hev-fsh-context.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -29,7 +30,13 @@ struct _HevFshClientBase
     HevFshIO base;
 
     int fd;
+    int cipher;
+    int flags;
+    int ktls;
+    int nodelay;
+    int offer;
     HevFshConfig *config;
+    HevFshContext *context;
 };
 
 struct _HevFshClientBaseClass
@@ -40,11 +47,22 @@ struct _HevFshClientBaseClass
 HevObjectClass *hev_fsh_client_base_class (void);
 
 int hev_fsh_client_base_construct (HevFshClientBase *self,
-                                   HevFshConfig *config);
+                                   HevFshConfig *config,
+                                   HevFshContext *context);
 
 int hev_fsh_client_base_listen (HevFshClientBase *self);
 int hev_fsh_client_base_connect (HevFshClientBase *self);
+int hev_fsh_client_base_send_hello (HevFshClientBase *self);
+/*
+ * Whether send_hello negotiates even without an offer: a key or -z. Only
+ * then may a connector offer more without locking out old forwarders.
+ */
+int hev_fsh_client_base_hello_needed (HevFshClientBase *self);
+int hev_fsh_client_base_recv_hello (HevFshClientBase *self);
 int hev_fsh_client_base_encrypt (HevFshClientBase *self);
+int hev_fsh_client_base_compress (HevFshClientBase *self);
+
+void hev_fsh_client_base_splice (HevFshClientBase *self, int ifd, int ofd);
 
 #ifdef __cplusplus
 }
@@ -57,20 +57,28 @@ hev_fsh_client_connect_send_connect (HevFshClientConnect *self)
     if (res <= 0)
         return -1;
 
+    res = hev_fsh_client_base_send_hello (base);
+    if (res < 0)
+        return -1;
+
     res = hev_fsh_client_base_encrypt (base);
     if (res < 0)
         return -1;
 
+    res = hev_fsh_client_base_compress (base);
+    if (res < 0)
+        return -1;
+
     return 0;
 }
 
 int
 hev_fsh_client_connect_construct (HevFshClientConnect *self,
-                                  HevFshConfig *config)
+                                  HevFshConfig *config, HevFshContext *context)
 {
     int res;
 
-    res = hev_fsh_client_base_construct (&self->base, config);
+    res = hev_fsh_client_base_construct (&self->base, config, context);
     if (res < 0)
         return res;
 
@@ -37,7 +37,8 @@ struct _HevFshClientConnectClass
 HevObjectClass *hev_fsh_client_connect_class (void);
 
 int hev_fsh_client_connect_construct (HevFshClientConnect *self,
-                                      HevFshConfig *config);
+                                      HevFshConfig *config,
+                                      HevFshContext *context);
 
 int hev_fsh_client_connect_send_connect (HevFshClientConnect *self);
 
@@ -30,23 +30,24 @@ hev_fsh_client_factory_get (HevFshClientFactory *self)
     mode = hev_fsh_config_get_mode (self->config);
 
     if (HEV_FSH_CONFIG_MODE_FORWARDER & mode) {
-        return hev_fsh_client_forward_new (self->config);
+        return hev_fsh_client_forward_new (self->config, self->context);
     } else if (HEV_FSH_CONFIG_MODE_CONNECTOR_PORT == mode) {
         if (hev_fsh_config_get_local_port (self->config))
-            return hev_fsh_client_port_listen_new (self->config);
+            return hev_fsh_client_port_listen_new (self->config, self->context);
         else
-            return hev_fsh_client_port_connect_new (self->config, -1);
+            return hev_fsh_client_port_connect_new (self->config,
+                                                    self->context, -1);
     } else if (HEV_FSH_CONFIG_MODE_CONNECTOR_SOCK == mode) {
-        return hev_fsh_client_sock_listen_new (self->config);
+        return hev_fsh_client_sock_listen_new (self->config, self->context);
     } else if (HEV_FSH_CONFIG_MODE_CONNECTOR_TERM == mode) {
-        return hev_fsh_client_term_connect_new (self->config);
+        return hev_fsh_client_term_connect_new (self->config, self->context);
     }
 
     return NULL;
 }
 
 HevFshClientFactory *
-hev_fsh_client_factory_new (HevFshConfig *config)
+hev_fsh_client_factory_new (HevFshConfig *config, HevFshContext *context)
 {
     HevFshClientFactory *self;
     int res;
@@ -55,7 +56,7 @@ hev_fsh_client_factory_new (HevFshConfig *config)
     if (!self)
         return NULL;
 
-    res = hev_fsh_client_factory_construct (self, config);
+    res = hev_fsh_client_factory_construct (self, config, context);
     if (res < 0) {
         hev_free (self);
         return NULL;
@@ -68,7 +69,7 @@ hev_fsh_client_factory_new (HevFshConfig *config)
 
 int
 hev_fsh_client_factory_construct (HevFshClientFactory *self,
-                                  HevFshConfig *config)
+                                  HevFshConfig *config, HevFshContext *context)
 {
     int res;
 
@@ -81,6 +82,7 @@ hev_fsh_client_factory_construct (HevFshClientFactory *self,
     HEV_OBJECT (self)->klass = HEV_FSH_CLIENT_FACTORY_TYPE;
 
     self->config = config;
+    self->context = context;
 
     return 0;
 }
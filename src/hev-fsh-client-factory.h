@@ -12,6 +12,7 @@
 
 #include "hev-object.h"
 #include "hev-fsh-config.h"
+#include "hev-fsh-context.h"
 #include "hev-fsh-client-base.h"
 
 #ifdef __cplusplus
@@ -30,6 +31,7 @@ struct _HevFshClientFactory
     HevObject base;
 
     HevFshConfig *config;
+    HevFshContext *context;
 };
 
 struct _HevFshClientFactoryClass
@@ -40,9 +42,11 @@ struct _HevFshClientFactoryClass
 HevObjectClass *hev_fsh_client_factory_class (void);
 
 int hev_fsh_client_factory_construct (HevFshClientFactory *self,
-                                      HevFshConfig *config);
+                                      HevFshConfig *config,
+                                      HevFshContext *context);
 
-HevFshClientFactory *hev_fsh_client_factory_new (HevFshConfig *config);
+HevFshClientFactory *hev_fsh_client_factory_new (HevFshConfig *config,
+                                                 HevFshContext *context);
 
 HevFshClientBase *hev_fsh_client_factory_get (HevFshClientFactory *self);
 
@@ -16,6 +16,7 @@
 #include <hev-memory-allocator.h>
 
 #include "hev-logger.h"
+#include "hev-object-pool.h"
 #include "hev-fsh-client-term-accept.h"
 #include "hev-fsh-client-port-accept.h"
 #include "hev-fsh-client-sock-accept.h"
@@ -135,13 +136,16 @@ hev_fsh_client_forward_accept (HevFshClientForward *self, HevFshToken token)
     mode = hev_fsh_config_get_mode (base->config);
     switch (mode) {
     case HEV_FSH_CONFIG_MODE_FORWARDER_PORT:
-        accept = hev_fsh_client_port_accept_new (base->config, token);
+        accept = hev_fsh_client_port_accept_new (base->config, base->context,
+                                                 token);
         break;
     case HEV_FSH_CONFIG_MODE_FORWARDER_SOCK:
-        accept = hev_fsh_client_sock_accept_new (base->config, token);
+        accept = hev_fsh_client_sock_accept_new (base->config, base->context,
+                                                 token);
         break;
     default:
-        accept = hev_fsh_client_term_accept_new (base->config, token);
+        accept = hev_fsh_client_term_accept_new (base->config, base->context,
+                                                 token);
         break;
     }
 
@@ -240,18 +244,18 @@ hev_fsh_client_forward_run (HevFshIO *base)
 }
 
 HevFshClientBase *
-hev_fsh_client_forward_new (HevFshConfig *config)
+hev_fsh_client_forward_new (HevFshConfig *config, HevFshContext *context)
 {
     HevFshClientForward *self;
     int res;
 
-    self = hev_malloc0 (sizeof (HevFshClientForward));
+    self = hev_object_pool_malloc0 (sizeof (HevFshClientForward));
     if (!self)
         return NULL;
 
-    res = hev_fsh_client_forward_construct (self, config);
+    res = hev_fsh_client_forward_construct (self, config, context);
     if (res < 0) {
-        hev_free (self);
+        hev_object_pool_free (self);
         return NULL;
     }
 
@@ -262,11 +266,11 @@ hev_fsh_client_forward_new (HevFshConfig *config)
 
 int
 hev_fsh_client_forward_construct (HevFshClientForward *self,
-                                  HevFshConfig *config)
+                                  HevFshConfig *config, HevFshContext *context)
 {
     int res;
 
-    res = hev_fsh_client_base_construct (&self->base, config);
+    res = hev_fsh_client_base_construct (&self->base, config, context);
     if (res < 0)
         return res;
 
@@ -45,9 +45,11 @@ struct _HevFshClientForwardClass
 HevObjectClass *hev_fsh_client_forward_class (void);
 
 int hev_fsh_client_forward_construct (HevFshClientForward *self,
-                                      HevFshConfig *config);
+                                      HevFshConfig *config,
+                                      HevFshContext *context);
 
-HevFshClientBase *hev_fsh_client_forward_new (HevFshConfig *config);
+HevFshClientBase *hev_fsh_client_forward_new (HevFshConfig *config,
+                                              HevFshContext *context);
 
 #ifdef __cplusplus
 }
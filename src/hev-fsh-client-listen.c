@@ -16,6 +16,7 @@
 #include <hev-memory-allocator.h>
 
 #include "hev-logger.h"
+#include "hev-object-pool.h"
 
 #include "hev-fsh-client-listen.h"
 
@@ -56,18 +57,18 @@ hev_fsh_client_listen_run (HevFshIO *base)
 }
 
 HevFshClientBase *
-hev_fsh_client_listen_new (HevFshConfig *config)
+hev_fsh_client_listen_new (HevFshConfig *config, HevFshContext *context)
 {
     HevFshClientListen *self;
     int res;
 
-    self = hev_malloc0 (sizeof (HevFshClientListen));
+    self = hev_object_pool_malloc0 (sizeof (HevFshClientListen));
     if (!self)
         return NULL;
 
-    res = hev_fsh_client_listen_construct (self, config);
+    res = hev_fsh_client_listen_construct (self, config, context);
     if (res < 0) {
-        hev_free (self);
+        hev_object_pool_free (self);
         return NULL;
     }
 
@@ -77,11 +78,12 @@ hev_fsh_client_listen_new (HevFshConfig *config)
 }
 
 int
-hev_fsh_client_listen_construct (HevFshClientListen *self, HevFshConfig *config)
+hev_fsh_client_listen_construct (HevFshClientListen *self,
+                                 HevFshConfig *config, HevFshContext *context)
 {
     int res;
 
-    res = hev_fsh_client_base_construct (&self->base, config);
+    res = hev_fsh_client_base_construct (&self->base, config, context);
     if (res < 0)
         return res;
 
@@ -39,7 +39,8 @@ struct _HevFshClientListenClass
 HevObjectClass *hev_fsh_client_listen_class (void);
 
 int hev_fsh_client_listen_construct (HevFshClientListen *self,
-                                     HevFshConfig *config);
+                                     HevFshConfig *config,
+                                     HevFshContext *context);
 
 #ifdef __cplusplus
 }
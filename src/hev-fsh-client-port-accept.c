@@ -9,6 +9,7 @@
 
 #include <string.h>
 #include <unistd.h>
+#include <arpa/inet.h>
 
 #include <hev-task.h>
 #include <hev-task-io.h>
@@ -16,18 +17,175 @@
 #include <hev-memory-allocator.h>
 
 #include "hev-logger.h"
-#include "hev-task-io-us.h"
+#include "hev-object-pool.h"
+#include "hev-task-io-race.h"
+#include "hev-task-io-stripe.h"
 
 #include "hev-fsh-client-port-accept.h"
 
+static int
+hev_fsh_client_port_accept_resolve (HevFshClientPortAccept *self,
+                                    HevFshMessagePortInfo *mpinfo,
+                                    struct sockaddr_storage *addrs)
+{
+    HevFshClientBase *base = HEV_FSH_CLIENT_BASE (self);
+    HevFshDnsCache *cache;
+    char name[256];
+    int count;
+    int res;
+    int i;
+
+    switch (mpinfo->type) {
+    case 4: {
+        struct sockaddr_in *addr4 = (struct sockaddr_in *)&addrs[0];
+        __builtin_bzero (addr4, sizeof (struct sockaddr_in));
+        addr4->sin_family = AF_INET;
+        addr4->sin_port = mpinfo->port;
+        memcpy (&addr4->sin_addr, mpinfo->addr, sizeof (addr4->sin_addr));
+        return 1;
+    }
+    case 6: {
+        struct sockaddr_in6 *addr6 = (struct sockaddr_in6 *)&addrs[0];
+        __builtin_bzero (addr6, sizeof (struct sockaddr_in6));
+        addr6->sin6_family = AF_INET6;
+        addr6->sin6_port = mpinfo->port;
+        memcpy (&addr6->sin6_addr, mpinfo->addr, sizeof (addr6->sin6_addr));
+        return 1;
+    }
+    case HEV_FSH_PORT_INFO_NAME:
+        break;
+    default:
+        return -1;
+    }
+
+    if (!mpinfo->addr[0])
+        return -1;
+
+    res = hev_task_io_socket_recv (base->fd, name, mpinfo->addr[0],
+                                   MSG_WAITALL, io_yielder, self);
+    if (res != mpinfo->addr[0])
+        return -1;
+    name[res] = '\0';
+
+    cache = hev_fsh_context_get_dns_cache (base->context);
+    count = hev_fsh_dns_cache_lookup (cache, name, addrs,
+                                      HEV_TASK_IO_RACE_MAX);
+    if (count <= 0) {
+        LOG_D ("%p fsh client port accept resolve %s", self, name);
+        return -1;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (addrs[i].ss_family == AF_INET6)
+            ((struct sockaddr_in6 *)&addrs[i])->sin6_port = mpinfo->port;
+        else
+            ((struct sockaddr_in *)&addrs[i])->sin_port = mpinfo->port;
+    }
+
+    return count;
+}
+
+static int
+hev_fsh_client_port_accept_filter (HevFshClientPortAccept *self,
+                                   struct sockaddr_storage *addrs, int count,
+                                   int *action)
+{
+    HevFshClientBase *base = HEV_FSH_CLIENT_BASE (self);
+    HevFshAcl *acl;
+    int i, n = 0;
+
+    acl = hev_fsh_context_get_acl (base->context);
+
+    for (i = 0; i < count; i++) {
+        struct sockaddr_in6 *addr6 = (struct sockaddr_in6 *)&addrs[i];
+        struct sockaddr_in *addr4 = (struct sockaddr_in *)&addrs[i];
+        int res;
+
+        if (addrs[i].ss_family == AF_INET6)
+            res = hev_fsh_acl_lookup (acl, 6, &addr6->sin6_addr,
+                                      ntohs (addr6->sin6_port));
+        else
+            res = hev_fsh_acl_lookup (acl, 4, &addr4->sin_addr,
+                                      ntohs (addr4->sin_port));
+        if (!(res & HEV_FSH_ACL_ALLOW))
+            continue;
+
+        if (!n)
+            *action = res;
+        if (n != i)
+            addrs[n] = addrs[i];
+        n++;
+    }
+
+    return n;
+}
+
+/* Hands the connection over to the one that runs its striped tunnel. */
+static void
+hev_fsh_client_port_accept_join (HevFshClientPortAccept *self,
+                                 HevFshMessageStripe *mstripe)
+{
+    HevFshClientBase *base = HEV_FSH_CLIENT_BASE (self);
+    HevFshStripes *stripes;
+    int res;
+
+    stripes = hev_fsh_context_get_stripes (base->context);
+
+    hev_task_del_fd (hev_task_self (), base->fd);
+    res = hev_fsh_stripes_join (stripes, mstripe->id, mstripe->index,
+                                mstripe->count, base->fd);
+    if (res < 0) {
+        LOG_D ("%p fsh client port accept join", self);
+        hev_fsh_stripes_abort (stripes, mstripe->id, mstripe->count);
+        return;
+    }
+
+    base->fd = -1;
+}
+
+static void
+hev_fsh_client_port_accept_stripe (HevFshClientPortAccept *self,
+                                   HevFshMessageStripe *mstripe, int lfd)
+{
+    HevFshClientBase *base = HEV_FSH_CLIENT_BASE (self);
+    int fds[HEV_TASK_IO_STRIPE_MAX];
+    HevTask *task = hev_task_self ();
+    HevFshStripes *stripes;
+    int res;
+    int i;
+
+    stripes = hev_fsh_context_get_stripes (base->context);
+    res = hev_fsh_stripes_wait (stripes, mstripe->id, mstripe->count, base->fd,
+                                fds + 1);
+    if (res < 0) {
+        LOG_D ("%p fsh client port accept stripe", self);
+        return;
+    }
+
+    fds[0] = base->fd;
+    for (i = 1; i < mstripe->count; i++)
+        hev_task_add_fd (task, fds[i], POLLIN | POLLOUT);
+
+    hev_task_io_stripe_splice (lfd, lfd, fds, mstripe->count, io_yielder,
+                               self);
+
+    for (i = 1; i < mstripe->count; i++) {
+        hev_task_del_fd (task, fds[i]);
+        close (fds[i]);
+    }
+}
+
 static void
 hev_fsh_client_port_accept_task_entry (void *data)
 {
     HevFshClientPortAccept *self = data;
     HevFshClientBase *base = data;
+    struct sockaddr_storage addrs[HEV_TASK_IO_RACE_MAX];
+    HevFshMessageStripe mstripe;
     HevFshMessagePortInfo mpinfo;
-    struct sockaddr_storage addr;
-    socklen_t addr_len;
+    HevFshUpstreamPool *pool;
+    int action;
+    int count;
     int lfd;
     int rfd;
     int res;
@@ -36,6 +194,19 @@ hev_fsh_client_port_accept_task_entry (void *data)
     if (res < 0)
         goto quit;
 
+    mstripe.count = 1;
+    if (base->flags & HEV_FSH_HELLO_F_STRIPE) {
+        res = hev_task_io_socket_recv (base->fd, &mstripe, sizeof (mstripe),
+                                       MSG_WAITALL, io_yielder, self);
+        if (res != sizeof (mstripe))
+            goto quit;
+
+        if (mstripe.index) {
+            hev_fsh_client_port_accept_join (self, &mstripe);
+            goto quit;
+        }
+    }
+
     rfd = base->fd;
     /* recv message port info */
     res = hev_task_io_socket_recv (rfd, &mpinfo, sizeof (mpinfo), MSG_WAITALL,
@@ -43,51 +214,41 @@ hev_fsh_client_port_accept_task_entry (void *data)
     if (res != sizeof (mpinfo))
         goto quit;
 
-    res = hev_fsh_config_addr_list_contains (base->config, mpinfo.type,
-                                             mpinfo.addr, mpinfo.port);
-    if (res == 0)
+    count = hev_fsh_client_port_accept_resolve (self, &mpinfo, addrs);
+    if (count <= 0)
         goto quit;
 
-    switch (mpinfo.type) {
-    case 4: {
-        struct sockaddr_in *addr4 = (struct sockaddr_in *)&addr;
-        addr_len = sizeof (struct sockaddr_in);
-        __builtin_bzero (addr4, addr_len);
-        addr4->sin_family = AF_INET;
-        addr4->sin_port = mpinfo.port;
-        memcpy (&addr4->sin_addr, mpinfo.addr, sizeof (addr4->sin_addr));
-        break;
-    }
-    case 6: {
-        struct sockaddr_in6 *addr6 = (struct sockaddr_in6 *)&addr;
-        addr_len = sizeof (struct sockaddr_in6);
-        __builtin_bzero (addr6, addr_len);
-        addr6->sin6_family = AF_INET6;
-        addr6->sin6_port = mpinfo.port;
-        memcpy (&addr6->sin6_addr, mpinfo.addr, sizeof (addr6->sin6_addr));
-        break;
-    }
-    default:
+    count = hev_fsh_client_port_accept_filter (self, addrs, count, &action);
+    if (!count)
         goto quit;
-    }
 
-    lfd = hev_task_io_socket_socket (addr.ss_family, SOCK_STREAM, IPPROTO_TCP);
-    if (lfd < 0)
-        goto quit;
+    lfd = -1;
+    if (HEV_FSH_ACL_POOL_DEPTH (action)) {
+        socklen_t addr_len = sizeof (struct sockaddr_in);
 
-    hev_task_add_fd (hev_task_self (), lfd, POLLIN | POLLOUT);
+        if (addrs[0].ss_family == AF_INET6)
+            addr_len = sizeof (struct sockaddr_in6);
 
-    res = hev_task_io_socket_connect (lfd, (struct sockaddr *)&addr, addr_len,
-                                      io_yielder, self);
-    if (res < 0)
-        goto quit_close;
+        pool = hev_fsh_context_get_upstream_pool (base->context);
+        lfd = hev_fsh_upstream_pool_get (pool, (struct sockaddr *)&addrs[0],
+                                         addr_len,
+                                         HEV_FSH_ACL_POOL_DEPTH (action));
+        if (lfd >= 0)
+            hev_task_add_fd (hev_task_self (), lfd, POLLIN | POLLOUT);
+    }
+
+    if (lfd < 0) {
+        lfd = hev_task_io_race_connect (addrs, count, HEV_TASK_IO_RACE_DELAY,
+                                        io_yielder, self);
+        if (lfd < 0)
+            goto quit;
+    }
 
-    if (hev_fsh_config_is_ugly_ktls (base->config))
-        hev_task_io_us_splice (rfd, rfd, lfd, lfd, 8192, io_yielder, self);
+    if (mstripe.count > 1)
+        hev_fsh_client_port_accept_stripe (self, &mstripe, lfd);
     else
-        hev_task_io_splice (rfd, rfd, lfd, lfd, 8192, io_yielder, self);
+        hev_fsh_client_base_splice (base, lfd, lfd);
 
-quit_close:
     close (lfd);
 quit:
     hev_object_unref (HEV_OBJECT (self));
@@ -102,18 +263,19 @@ hev_fsh_client_port_accept_run (HevFshIO *base)
 }
 
 HevFshClientBase *
-hev_fsh_client_port_accept_new (HevFshConfig *config, HevFshToken token)
+hev_fsh_client_port_accept_new (HevFshConfig *config, HevFshContext *context,
+                                HevFshToken token)
 {
     HevFshClientPortAccept *self;
     int res;
 
-    self = hev_malloc0 (sizeof (HevFshClientPortAccept));
+    self = hev_object_pool_malloc0 (sizeof (HevFshClientPortAccept));
     if (!self)
         return NULL;
 
-    res = hev_fsh_client_port_accept_construct (self, config, token);
+    res = hev_fsh_client_port_accept_construct (self, config, context, token);
     if (res < 0) {
-        hev_free (self);
+        hev_object_pool_free (self);
         return NULL;
     }
 
@@ -124,11 +286,12 @@ hev_fsh_client_port_accept_new (HevFshConfig *config, HevFshToken token)
 
 int
 hev_fsh_client_port_accept_construct (HevFshClientPortAccept *self,
-                                      HevFshConfig *config, HevFshToken token)
+                                      HevFshConfig *config,
+                                      HevFshContext *context, HevFshToken token)
 {
     int res;
 
-    res = hev_fsh_client_accept_construct (&self->base, config, token);
+    res = hev_fsh_client_accept_construct (&self->base, config, context, token);
     if (res < 0)
         return res;
 
@@ -136,6 +299,9 @@ hev_fsh_client_port_accept_construct (HevFshClientPortAccept *self,
 
     HEV_OBJECT (self)->klass = HEV_FSH_CLIENT_PORT_ACCEPT_TYPE;
 
+    if (hev_fsh_context_get_stripes (context))
+        HEV_FSH_CLIENT_BASE (self)->offer = HEV_FSH_HELLO_F_STRIPE;
+
     return 0;
 }
 
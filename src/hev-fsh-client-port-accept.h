@@ -37,9 +37,11 @@ HevObjectClass *hev_fsh_client_port_accept_class (void);
 
 int hev_fsh_client_port_accept_construct (HevFshClientPortAccept *self,
                                           HevFshConfig *config,
+                                          HevFshContext *context,
                                           HevFshToken token);
 
 HevFshClientBase *hev_fsh_client_port_accept_new (HevFshConfig *config,
+                                                  HevFshContext *context,
                                                   HevFshToken token);
 
 #ifdef __cplusplus
@@ -18,18 +18,82 @@
 #include <hev-memory-allocator.h>
 
 #include "hev-logger.h"
-#include "hev-task-io-us.h"
+#include "hev-object-pool.h"
 #include "hev-fsh-protocol.h"
+#include "hev-task-io-stripe.h"
+#include "hev-fsh-client-stripe-connect.h"
 
 #include "hev-fsh-client-port-connect.h"
 
+/* Starts the other connections of the striped tunnel. */
+static int
+hev_fsh_client_port_connect_spawn (HevFshClientPortConnect *self,
+                                   HevFshMessageStripe *mstripe)
+{
+    HevFshClientBase *base = HEV_FSH_CLIENT_BASE (self);
+    HevFshMessageStripe mextra;
+    int i;
+
+    memcpy (&mextra, mstripe, sizeof (HevFshMessageStripe));
+
+    for (i = 1; i < mstripe->count; i++) {
+        HevFshClientBase *client;
+
+        mextra.index = i;
+        client = hev_fsh_client_stripe_connect_new (base->config,
+                                                    base->context, &mextra);
+        if (!client)
+            return -1;
+
+        hev_fsh_io_run (HEV_FSH_IO (client));
+    }
+
+    return 0;
+}
+
+static void
+hev_fsh_client_port_connect_stripe (HevFshClientPortConnect *self,
+                                    HevFshMessageStripe *mstripe, int ifd,
+                                    int ofd)
+{
+    HevFshClientBase *base = HEV_FSH_CLIENT_BASE (self);
+    int fds[HEV_TASK_IO_STRIPE_MAX];
+    HevTask *task = hev_task_self ();
+    HevFshStripes *stripes;
+    int res;
+    int i;
+
+    stripes = hev_fsh_context_get_stripes (base->context);
+    res = hev_fsh_stripes_wait (stripes, mstripe->id, mstripe->count, base->fd,
+                                fds + 1);
+    if (res < 0) {
+        LOG_E ("%p fsh client port connect stripe", self);
+        return;
+    }
+
+    fds[0] = base->fd;
+    for (i = 1; i < mstripe->count; i++)
+        hev_task_add_fd (task, fds[i], POLLIN | POLLOUT);
+
+    hev_task_io_stripe_splice (ifd, ofd, fds, mstripe->count, io_yielder,
+                               self);
+
+    for (i = 1; i < mstripe->count; i++) {
+        hev_task_del_fd (task, fds[i]);
+        close (fds[i]);
+    }
+}
+
 static void
 hev_fsh_client_port_connect_task_entry (void *data)
 {
     HevFshClientPortConnect *self = data;
     HevFshClientBase *base = data;
+    HevFshMessageStripe mstripe;
     HevFshMessagePortInfo mpinfo;
     HevTask *task = hev_task_self ();
+    struct msghdr mh;
+    struct iovec iov[3];
     const char *addr;
     int port;
     int ifd;
@@ -48,19 +112,49 @@ hev_fsh_client_port_connect_task_entry (void *data)
     mpinfo.port = htons (port);
     bfd = base->fd;
 
+    mstripe.count = 1;
+    iov[0].iov_base = &mstripe;
+    iov[0].iov_len = 0;
+    iov[1].iov_base = &mpinfo;
+    iov[1].iov_len = sizeof (mpinfo);
+    iov[2].iov_base = (void *)addr;
+    iov[2].iov_len = 0;
+
+    if (base->flags & HEV_FSH_HELLO_F_STRIPE) {
+        hev_fsh_protocol_token_generate (mstripe.id);
+        mstripe.index = 0;
+        mstripe.count = hev_fsh_config_get_streams (base->config);
+        iov[0].iov_len = sizeof (mstripe);
+    }
+
     if (inet_pton (AF_INET, addr, mpinfo.addr) == 1) {
         mpinfo.type = 4;
-    } else {
+    } else if (inet_pton (AF_INET6, addr, mpinfo.addr) == 1) {
         mpinfo.type = 6;
-        inet_pton (AF_INET6, addr, mpinfo.addr);
+    } else {
+        /* A host name: the forwarder resolves it and races the results. */
+        iov[2].iov_len = strlen (addr);
+        if (iov[2].iov_len > 255)
+            goto exit;
+        mpinfo.type = HEV_FSH_PORT_INFO_NAME;
+        mpinfo.addr[0] = iov[2].iov_len;
     }
 
+    __builtin_bzero (&mh, sizeof (mh));
+    mh.msg_iov = iov;
+    mh.msg_iovlen = 3;
+
     /* send message port info */
-    res = hev_task_io_socket_send (bfd, &mpinfo, sizeof (mpinfo), MSG_WAITALL,
-                                   io_yielder, self);
+    res = hev_task_io_socket_sendmsg (bfd, &mh, MSG_WAITALL, io_yielder, self);
     if (res <= 0)
         goto exit;
 
+    if (mstripe.count > 1) {
+        res = hev_fsh_client_port_connect_spawn (self, &mstripe);
+        if (res < 0)
+            goto exit;
+    }
+
     if (self->fd < 0) {
         ifd = 0;
         ofd = 1;
@@ -84,10 +178,10 @@ hev_fsh_client_port_connect_task_entry (void *data)
         hev_task_add_fd (task, ifd, POLLIN | POLLOUT);
     }
 
-    if (hev_fsh_config_is_ugly_ktls (base->config))
-        hev_task_io_us_splice (bfd, bfd, ifd, ofd, 8192, io_yielder, self);
+    if (mstripe.count > 1)
+        hev_fsh_client_port_connect_stripe (self, &mstripe, ifd, ofd);
     else
-        hev_task_io_splice (bfd, bfd, ifd, ofd, 8192, io_yielder, self);
+        hev_fsh_client_base_splice (base, ifd, ofd);
 
 exit:
     hev_object_unref (HEV_OBJECT (self));
@@ -102,18 +196,19 @@ hev_fsh_client_port_connect_run (HevFshIO *base)
 }
 
 HevFshClientBase *
-hev_fsh_client_port_connect_new (HevFshConfig *config, int fd)
+hev_fsh_client_port_connect_new (HevFshConfig *config, HevFshContext *context,
+                                 int fd)
 {
     HevFshClientPortConnect *self;
     int res;
 
-    self = hev_malloc0 (sizeof (HevFshClientPortConnect));
+    self = hev_object_pool_malloc0 (sizeof (HevFshClientPortConnect));
     if (!self)
         return NULL;
 
-    res = hev_fsh_client_port_connect_construct (self, config, fd);
+    res = hev_fsh_client_port_connect_construct (self, config, context, fd);
     if (res < 0) {
-        hev_free (self);
+        hev_object_pool_free (self);
         return NULL;
     }
 
@@ -124,11 +219,12 @@ hev_fsh_client_port_connect_new (HevFshConfig *config, int fd)
 
 int
 hev_fsh_client_port_connect_construct (HevFshClientPortConnect *self,
-                                       HevFshConfig *config, int fd)
+                                       HevFshConfig *config,
+                                       HevFshContext *context, int fd)
 {
     int res;
 
-    res = hev_fsh_client_connect_construct (&self->base, config);
+    res = hev_fsh_client_connect_construct (&self->base, config, context);
     if (res < 0)
         return res;
 
@@ -136,6 +232,9 @@ hev_fsh_client_port_connect_construct (HevFshClientPortConnect *self,
 
     HEV_OBJECT (self)->klass = HEV_FSH_CLIENT_PORT_CONNECT_TYPE;
 
+    if (hev_fsh_config_get_streams (config) > 1)
+        HEV_FSH_CLIENT_BASE (self)->offer = HEV_FSH_HELLO_F_STRIPE;
+
     self->fd = fd;
 
     return 0;
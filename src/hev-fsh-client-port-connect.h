@@ -38,9 +38,11 @@ struct _HevFshClientPortConnectClass
 HevObjectClass *hev_fsh_client_port_connect_class (void);
 
 int hev_fsh_client_port_connect_construct (HevFshClientPortConnect *self,
-                                           HevFshConfig *config, int fd);
+                                           HevFshConfig *config,
+                                           HevFshContext *context, int fd);
 
 HevFshClientBase *hev_fsh_client_port_connect_new (HevFshConfig *config,
+                                                   HevFshContext *context,
                                                    int fd);
 
 #ifdef __cplusplus
@@ -16,6 +16,7 @@
 #include <hev-memory-allocator.h>
 
 #include "hev-logger.h"
+#include "hev-object-pool.h"
 #include "hev-fsh-client-port-connect.h"
 
 #include "hev-fsh-client-port-listen.h"
@@ -26,7 +27,7 @@ hev_fsh_client_port_listen_dispatch (HevFshClientListen *base, int fd)
     HevFshClientBase *b = HEV_FSH_CLIENT_BASE (base);
     HevFshClientBase *client;
 
-    client = hev_fsh_client_port_connect_new (b->config, fd);
+    client = hev_fsh_client_port_connect_new (b->config, b->context, fd);
     if (client)
         hev_fsh_io_run (HEV_FSH_IO (client));
     else
@@ -34,18 +35,18 @@ hev_fsh_client_port_listen_dispatch (HevFshClientListen *base, int fd)
 }
 
 HevFshClientBase *
-hev_fsh_client_port_listen_new (HevFshConfig *config)
+hev_fsh_client_port_listen_new (HevFshConfig *config, HevFshContext *context)
 {
     HevFshClientPortListen *self;
     int res;
 
-    self = hev_malloc0 (sizeof (HevFshClientPortListen));
+    self = hev_object_pool_malloc0 (sizeof (HevFshClientPortListen));
     if (!self)
         return NULL;
 
-    res = hev_fsh_client_port_listen_construct (self, config);
+    res = hev_fsh_client_port_listen_construct (self, config, context);
     if (res < 0) {
-        hev_free (self);
+        hev_object_pool_free (self);
         return NULL;
     }
 
@@ -56,11 +57,12 @@ hev_fsh_client_port_listen_new (HevFshConfig *config)
 
 int
 hev_fsh_client_port_listen_construct (HevFshClientPortListen *self,
-                                      HevFshConfig *config)
+                                      HevFshConfig *config,
+                                      HevFshContext *context)
 {
     int res;
 
-    res = hev_fsh_client_listen_construct (&self->base, config);
+    res = hev_fsh_client_listen_construct (&self->base, config, context);
     if (res < 0)
         return res;
 
@@ -36,9 +36,11 @@ struct _HevFshClientPortListenClass
 HevObjectClass *hev_fsh_client_port_listen_class (void);
 
 int hev_fsh_client_port_listen_construct (HevFshClientPortListen *self,
-                                          HevFshConfig *config);
+                                          HevFshConfig *config,
+                                          HevFshContext *context);
 
-HevFshClientBase *hev_fsh_client_port_listen_new (HevFshConfig *config);
+HevFshClientBase *hev_fsh_client_port_listen_new (HevFshConfig *config,
+                                                  HevFshContext *context);
 
 #ifdef __cplusplus
 }
@@ -9,6 +9,8 @@
 
 #include <string.h>
 #include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
 
 #include <hev-task.h>
 #include <hev-task-io.h>
@@ -16,32 +18,431 @@
 #include <hev-memory-allocator.h>
 
 #include "hev-logger.h"
+#include "hev-object-pool.h"
+#include "hev-fsh-protocol.h"
+#include "hev-fsh-sock-udp.h"
+#include "hev-task-io-mux.h"
+#include "hev-task-io-race.h"
 #include "hev-socks5-server.h"
-#include "hev-socks5-server-us.h"
 
 #include "hev-fsh-client-sock-accept.h"
 
+static void
+hev_fsh_client_sock_accept_socks_entry (void *data)
+{
+    HevSocks5Server *socks = data;
+
+    hev_task_add_fd (hev_task_self (), HEV_SOCKS5 (socks)->fd,
+                     POLLIN | POLLOUT);
+    hev_socks5_server_run (socks);
+    hev_object_unref (HEV_OBJECT (socks));
+}
+
+typedef struct _HevFshClientSockAcceptUdp HevFshClientSockAcceptUdp;
+
+struct _HevFshClientSockAcceptUdp
+{
+    HevFshDnsCache *cache;
+    int fd;
+};
+
+static void
+hev_fsh_client_sock_accept_udp_entry (void *data)
+{
+    HevFshClientSockAcceptUdp *udp = data;
+    HevFshDnsCache *cache = udp->cache;
+    int fd = udp->fd;
+
+    hev_free (udp);
+
+    hev_task_add_fd (hev_task_self (), fd, POLLIN | POLLOUT);
+    hev_fsh_sock_udp_server_run (fd, cache, NULL, NULL);
+    close (fd);
+}
+
+typedef struct _HevFshClientSockAcceptFront HevFshClientSockAcceptFront;
+
+struct _HevFshClientSockAcceptFront
+{
+    HevFshClientSockAccept *self;
+    int fd;
+};
+
+/*
+ * Hands the request in buf, of size, to a SOCKS5 server of its own, as if
+ * the greeting were done; returns the fd that talks to it, or -1.
+ */
+static int
+hev_fsh_client_sock_accept_server (HevFshClientSockAccept *self,
+                                   unsigned char *buf, int size)
+{
+    HevTask *task = hev_task_self ();
+    HevSocks5Server *socks;
+    HevTask *stask;
+    int fds[2];
+    int res;
+
+    if (socketpair (AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0,
+                    fds) < 0)
+        return -1;
+
+    stask = hev_task_new (HEV_FSH_CONFIG_TASK_STACK_SIZE);
+    if (!stask)
+        goto close;
+
+    /* the server owns its end from here on */
+    socks = hev_socks5_server_new (fds[1]);
+    if (!socks) {
+        hev_task_unref (stask);
+        goto close;
+    }
+
+    hev_task_run (stask, hev_fsh_client_sock_accept_socks_entry, socks);
+    hev_task_add_fd (task, fds[0], POLLIN | POLLOUT);
+
+    memmove (buf + 3, buf, size);
+    buf[0] = 5;
+    buf[1] = 1;
+    buf[2] = 0;
+    size += 3;
+
+    res = hev_task_io_socket_send (fds[0], buf, size, MSG_WAITALL, io_yielder,
+                                   self);
+    if (res != size)
+        goto del;
+
+    /* its answer to the greeting is no news to the client: drop it */
+    res = hev_task_io_socket_recv (fds[0], buf, 2, MSG_WAITALL, io_yielder,
+                                   self);
+    if (res != 2 || buf[1] != 0)
+        goto del;
+
+    return fds[0];
+
+del:
+    hev_task_del_fd (task, fds[0]);
+    close (fds[0]);
+    return -1;
+
+close:
+    close (fds[0]);
+    close (fds[1]);
+    return -1;
+}
+
+/* Resolves the address of the request in buf: the count, or -1. */
+static int
+hev_fsh_client_sock_accept_resolve (HevFshClientSockAccept *self,
+                                    unsigned char *buf,
+                                    struct sockaddr_storage *addrs)
+{
+    HevFshClientBase *base = HEV_FSH_CLIENT_BASE (self);
+    HevFshDnsCache *cache;
+    unsigned short port;
+    char name[256];
+    int count;
+    int i;
+
+    switch (buf[3]) {
+    case 1: {
+        struct sockaddr_in *addr4 = (struct sockaddr_in *)&addrs[0];
+        __builtin_bzero (addr4, sizeof (struct sockaddr_in));
+        addr4->sin_family = AF_INET;
+        memcpy (&addr4->sin_addr, buf + 4, 4);
+        memcpy (&addr4->sin_port, buf + 8, 2);
+        return 1;
+    }
+    case 4: {
+        struct sockaddr_in6 *addr6 = (struct sockaddr_in6 *)&addrs[0];
+        __builtin_bzero (addr6, sizeof (struct sockaddr_in6));
+        addr6->sin6_family = AF_INET6;
+        memcpy (&addr6->sin6_addr, buf + 4, 16);
+        memcpy (&addr6->sin6_port, buf + 20, 2);
+        return 1;
+    }
+    }
+
+    memcpy (name, buf + 5, buf[4]);
+    name[buf[4]] = '\0';
+    memcpy (&port, buf + 5 + buf[4], 2);
+
+    cache = hev_fsh_context_get_dns_cache (base->context);
+    count = hev_fsh_dns_cache_lookup (cache, name, addrs,
+                                      HEV_TASK_IO_RACE_MAX);
+    if (count <= 0) {
+        LOG_D ("%p fsh client sock accept resolve %s", self, name);
+        return -1;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (addrs[i].ss_family == AF_INET6)
+            ((struct sockaddr_in6 *)&addrs[i])->sin6_port = port;
+        else
+            ((struct sockaddr_in *)&addrs[i])->sin_port = port;
+    }
+
+    return count;
+}
+
+/*
+ * Serves the SOCKS5 request on fd, registered with the current task, after
+ * the greeting unless greeted: returns the fd to splice it with, or -1.
+ * CONNECT is answered here, names resolved through the cache and addresses
+ * raced; the rest is left to a SOCKS5 server.
+ */
+static int
+hev_fsh_client_sock_accept_request (HevFshClientSockAccept *self, int fd,
+                                    int greeted)
+{
+    struct sockaddr_storage addrs[HEV_TASK_IO_RACE_MAX];
+    unsigned char buf[3 + 4 + 1 + 255 + 2];
+    socklen_t len;
+    int count;
+    int size;
+    int rfd;
+    int res;
+    int i;
+
+    if (!greeted) {
+        res = hev_task_io_socket_recv (fd, buf, 2, MSG_WAITALL, io_yielder,
+                                       self);
+        if (res != 2 || buf[0] != 5 || !buf[1])
+            return -1;
+
+        res = hev_task_io_socket_recv (fd, buf + 2, buf[1], MSG_WAITALL,
+                                       io_yielder, self);
+        if (res != buf[1])
+            return -1;
+
+        for (i = 0; i < buf[1]; i++)
+            if (buf[2 + i] == 0)
+                break;
+
+        buf[1] = (i < buf[1]) ? 0 : 0xff;
+        res = hev_task_io_socket_send (fd, buf, 2, MSG_WAITALL, io_yielder,
+                                       self);
+        if (res != 2 || buf[1])
+            return -1;
+    }
+
+    /* VER, CMD, RSV, ATYP, then the address and port */
+    res = hev_task_io_socket_recv (fd, buf, 5, MSG_WAITALL, io_yielder, self);
+    if (res != 5 || buf[0] != 5)
+        return -1;
+
+    switch (buf[3]) {
+    case 1:
+        size = 4 + 2 - 1;
+        break;
+    case 4:
+        size = 16 + 2 - 1;
+        break;
+    case 3:
+        size = buf[4] + 2;
+        break;
+    default:
+        return -1;
+    }
+
+    res = hev_task_io_socket_recv (fd, buf + 5, size, MSG_WAITALL,
+                                   io_yielder, self);
+    if (res != size)
+        return -1;
+
+    if (buf[1] != 1)
+        return hev_fsh_client_sock_accept_server (self, buf, 5 + size);
+
+    rfd = -1;
+    buf[1] = 4;
+    count = hev_fsh_client_sock_accept_resolve (self, buf, addrs);
+    if (count > 0) {
+        rfd = hev_task_io_race_connect (addrs, count, HEV_TASK_IO_RACE_DELAY,
+                                        io_yielder, self);
+        buf[1] = 5;
+    }
+
+    size = 3;
+    len = sizeof (struct sockaddr_storage);
+    if (rfd >= 0 && getsockname (rfd, (struct sockaddr *)addrs, &len) == 0) {
+        hev_fsh_sock_udp_unmap (&addrs[0]);
+        res = hev_fsh_sock_udp_put_addr (buf + 3, &addrs[0]);
+        if (res > 0) {
+            buf[1] = 0;
+            size += res;
+        }
+    }
+
+    if (buf[1]) {
+        __builtin_bzero (buf + 3, 7);
+        buf[3] = 1;
+        size += 7;
+    }
+
+    res = hev_task_io_socket_send (fd, buf, size, MSG_WAITALL, io_yielder,
+                                   self);
+    if (res == size && !buf[1])
+        return rfd;
+
+    if (rfd >= 0) {
+        hev_task_del_fd (hev_task_self (), rfd);
+        close (rfd);
+    }
+
+    return -1;
+}
+
+static void
+hev_fsh_client_sock_accept_front_entry (void *data)
+{
+    HevFshClientSockAcceptFront *front = data;
+    HevFshClientSockAccept *self = front->self;
+    HevFshClientBase *base = HEV_FSH_CLIENT_BASE (self);
+    HevTask *task = hev_task_self ();
+    int fd = front->fd;
+    size_t min;
+    int rfd;
+
+    hev_free (front);
+
+    hev_task_add_fd (task, fd, POLLIN | POLLOUT);
+
+    /* the connector has settled the greeting with the client already */
+    rfd = hev_fsh_client_sock_accept_request (self, fd, 1);
+    if (rfd >= 0) {
+        min = hev_fsh_config_get_buf_min (base->config);
+        hev_task_io_splice (fd, fd, rfd, rfd, min, io_yielder, self);
+        hev_task_del_fd (task, rfd);
+        close (rfd);
+    }
+
+    hev_task_del_fd (task, fd);
+    close (fd);
+    hev_object_unref (HEV_OBJECT (self));
+}
+
+static int
+hev_fsh_client_sock_accept_mux_stream (HevFshClientSockAccept *self, int sfd)
+{
+    HevFshClientSockAcceptFront *front;
+    HevTask *task;
+
+    front = hev_malloc (sizeof (HevFshClientSockAcceptFront));
+    if (!front)
+        goto close;
+
+    task = hev_task_new (HEV_FSH_CONFIG_TASK_STACK_SIZE);
+    if (!task) {
+        hev_free (front);
+        goto close;
+    }
+
+    front->self = self;
+    front->fd = sfd;
+    hev_object_ref (HEV_OBJECT (self));
+    hev_task_run (task, hev_fsh_client_sock_accept_front_entry, front);
+
+    return 0;
+
+close:
+    close (sfd);
+    return -1;
+}
+
+static int
+hev_fsh_client_sock_accept_mux_udp (HevFshClientSockAccept *self, int sfd)
+{
+    HevFshClientBase *base = HEV_FSH_CLIENT_BASE (self);
+    HevFshClientSockAcceptUdp *udp;
+    HevTask *task;
+
+    udp = hev_malloc (sizeof (HevFshClientSockAcceptUdp));
+    if (!udp)
+        goto close;
+
+    task = hev_task_new (HEV_FSH_CONFIG_TASK_STACK_SIZE);
+    if (!task) {
+        hev_free (udp);
+        goto close;
+    }
+
+    udp->cache = hev_fsh_context_get_dns_cache (base->context);
+    udp->fd = sfd;
+    hev_task_run (task, hev_fsh_client_sock_accept_udp_entry, udp);
+
+    return 0;
+
+close:
+    close (sfd);
+    return -1;
+}
+
+static int
+hev_fsh_client_sock_accept_mux_accept (void *data, unsigned int kind)
+{
+    HevFshClientSockAccept *self = data;
+    int fds[2];
+    int res;
+
+    LOG_D ("%p fsh client sock accept mux accept %u", self, kind);
+
+    if (kind != HEV_FSH_SOCK_MUX_STREAM && kind != HEV_FSH_SOCK_MUX_UDP)
+        return -1;
+
+    if (socketpair (AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0,
+                    fds) < 0)
+        return -1;
+
+    if (kind == HEV_FSH_SOCK_MUX_UDP)
+        res = hev_fsh_client_sock_accept_mux_udp (self, fds[1]);
+    else
+        res = hev_fsh_client_sock_accept_mux_stream (self, fds[1]);
+
+    if (res < 0) {
+        close (fds[0]);
+        return -1;
+    }
+
+    return fds[0];
+}
+
+static void
+hev_fsh_client_sock_accept_mux (HevFshClientSockAccept *self)
+{
+    HevFshClientBase *base = HEV_FSH_CLIENT_BASE (self);
+    HevTaskIOMux *mux;
+
+    mux = hev_task_io_mux_new (hev_fsh_client_sock_accept_mux_accept, self);
+    if (!mux)
+        return;
+
+    hev_task_io_mux_run (mux, base->fd, io_yielder, self);
+    hev_task_io_mux_destroy (mux);
+}
+
 static void
 hev_fsh_client_sock_accept_task_entry (void *data)
 {
     HevFshClientSockAccept *self = data;
     HevFshClientBase *base = data;
-    HevSocks5Server *socks;
+    int rfd;
     int res;
 
     res = hev_fsh_client_accept_send_accept (&self->base);
     if (res < 0)
         goto quit;
 
-    if (hev_fsh_config_is_ugly_ktls (base->config))
-        socks = hev_socks5_server_us_new (base->fd);
-    else
-        socks = hev_socks5_server_new (base->fd);
-    if (!socks)
+    if (base->flags & HEV_FSH_HELLO_F_SOCK_MUX) {
+        hev_fsh_client_sock_accept_mux (self);
         goto quit;
+    }
 
-    hev_socks5_server_run (socks);
-    hev_object_unref (HEV_OBJECT (socks));
+    rfd = hev_fsh_client_sock_accept_request (self, base->fd, 0);
+    if (rfd < 0)
+        goto quit;
+
+    hev_fsh_client_base_splice (base, rfd, rfd);
+
+    close (rfd);
 
 quit:
     hev_object_unref (HEV_OBJECT (self));
@@ -56,18 +457,19 @@ hev_fsh_client_sock_accept_run (HevFshIO *base)
 }
 
 HevFshClientBase *
-hev_fsh_client_sock_accept_new (HevFshConfig *config, HevFshToken token)
+hev_fsh_client_sock_accept_new (HevFshConfig *config, HevFshContext *context,
+                                HevFshToken token)
 {
     HevFshClientSockAccept *self;
     int res;
 
-    self = hev_malloc0 (sizeof (HevFshClientSockAccept));
+    self = hev_object_pool_malloc0 (sizeof (HevFshClientSockAccept));
     if (!self)
         return NULL;
 
-    res = hev_fsh_client_sock_accept_construct (self, config, token);
+    res = hev_fsh_client_sock_accept_construct (self, config, context, token);
     if (res < 0) {
-        hev_free (self);
+        hev_object_pool_free (self);
         return NULL;
     }
 
@@ -78,17 +480,19 @@ hev_fsh_client_sock_accept_new (HevFshConfig *config, HevFshToken token)
 
 int
 hev_fsh_client_sock_accept_construct (HevFshClientSockAccept *self,
-                                      HevFshConfig *config, HevFshToken token)
+                                      HevFshConfig *config,
+                                      HevFshContext *context, HevFshToken token)
 {
     int res;
 
-    res = hev_fsh_client_accept_construct (&self->base, config, token);
+    res = hev_fsh_client_accept_construct (&self->base, config, context, token);
     if (res < 0)
         return res;
 
     LOG_D ("%p fsh client sock accept construct", self);
 
     HEV_OBJECT (self)->klass = HEV_FSH_CLIENT_SOCK_ACCEPT_TYPE;
+    HEV_FSH_CLIENT_BASE (self)->offer = HEV_FSH_HELLO_F_SOCK_MUX;
 
     return 0;
 }
@@ -16,7 +16,7 @@
 #include <hev-memory-allocator.h>
 
 #include "hev-logger.h"
-#include "hev-task-io-us.h"
+#include "hev-object-pool.h"
 #include "hev-fsh-protocol.h"
 
 #include "hev-fsh-client-sock-connect.h"
@@ -27,7 +27,6 @@ hev_fsh_client_sock_connect_task_entry (void *data)
     HevFshClientSockConnect *self = data;
     HevFshClientBase *base = data;
     int sfd;
-    int bfd;
     int res;
 
     res = hev_fsh_client_connect_send_connect (&self->base);
@@ -35,13 +34,9 @@ hev_fsh_client_sock_connect_task_entry (void *data)
         goto exit;
 
     sfd = self->fd;
-    bfd = base->fd;
     hev_task_add_fd (hev_task_self (), sfd, POLLIN | POLLOUT);
 
-    if (hev_fsh_config_is_ugly_ktls (base->config))
-        hev_task_io_us_splice (bfd, bfd, sfd, sfd, 8192, io_yielder, self);
-    else
-        hev_task_io_splice (bfd, bfd, sfd, sfd, 8192, io_yielder, self);
+    hev_fsh_client_base_splice (base, sfd, sfd);
 
 exit:
     hev_object_unref (HEV_OBJECT (self));
@@ -56,18 +51,19 @@ hev_fsh_client_sock_connect_run (HevFshIO *base)
 }
 
 HevFshClientBase *
-hev_fsh_client_sock_connect_new (HevFshConfig *config, int fd)
+hev_fsh_client_sock_connect_new (HevFshConfig *config, HevFshContext *context,
+                                 int fd)
 {
     HevFshClientSockConnect *self;
     int res;
 
-    self = hev_malloc0 (sizeof (HevFshClientSockConnect));
+    self = hev_object_pool_malloc0 (sizeof (HevFshClientSockConnect));
     if (!self)
         return NULL;
 
-    res = hev_fsh_client_sock_connect_construct (self, config, fd);
+    res = hev_fsh_client_sock_connect_construct (self, config, context, fd);
     if (res < 0) {
-        hev_free (self);
+        hev_object_pool_free (self);
         return NULL;
     }
 
@@ -78,11 +74,12 @@ hev_fsh_client_sock_connect_new (HevFshConfig *config, int fd)
 
 int
 hev_fsh_client_sock_connect_construct (HevFshClientSockConnect *self,
-                                       HevFshConfig *config, int fd)
+                                       HevFshConfig *config,
+                                       HevFshContext *context, int fd)
 {
     int res;
 
-    res = hev_fsh_client_connect_construct (&self->base, config);
+    res = hev_fsh_client_connect_construct (&self->base, config, context);
     if (res < 0)
         return res;
 
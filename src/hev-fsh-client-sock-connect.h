@@ -38,9 +38,11 @@ struct _HevFshClientSockConnectClass
 HevObjectClass *hev_fsh_client_sock_connect_class (void);
 
 int hev_fsh_client_sock_connect_construct (HevFshClientSockConnect *self,
-                                           HevFshConfig *config, int fd);
+                                           HevFshConfig *config,
+                                           HevFshContext *context, int fd);
 
 HevFshClientBase *hev_fsh_client_sock_connect_new (HevFshConfig *config,
+                                                   HevFshContext *context,
                                                    int fd);
 
 #ifdef __cplusplus
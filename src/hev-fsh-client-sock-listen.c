@@ -16,6 +16,7 @@
 #include <hev-memory-allocator.h>
 
 #include "hev-logger.h"
+#include "hev-object-pool.h"
 #include "hev-fsh-client-sock-connect.h"
 
 #include "hev-fsh-client-sock-listen.h"
@@ -23,29 +24,56 @@
 static void
 hev_fsh_client_sock_listen_dispatch (HevFshClientListen *base, int fd)
 {
+    HevFshClientSockListen *self = HEV_FSH_CLIENT_SOCK_LISTEN (base);
     HevFshClientBase *b = HEV_FSH_CLIENT_BASE (base);
     HevFshClientBase *client;
 
-    client = hev_fsh_client_sock_connect_new (b->config, fd);
-    if (client)
-        hev_fsh_io_run (HEV_FSH_IO (client));
-    else
+    /* SOCK_MUX needs a hello, which old forwarders cannot answer */
+    if (!hev_fsh_client_base_hello_needed (b)) {
+        client = hev_fsh_client_sock_connect_new (b->config, b->context, fd);
+        if (client)
+            hev_fsh_io_run (HEV_FSH_IO (client));
+        else
+            close (fd);
+        return;
+    }
+
+    if (self->mux && hev_fsh_client_sock_mux_open (self->mux, fd) == 0)
+        return;
+
+    /* the tunnel is gone: the next one carries this client and those after */
+    if (self->mux) {
+        hev_object_unref (HEV_OBJECT (self->mux));
+        self->mux = NULL;
+    }
+
+    client = hev_fsh_client_sock_mux_new (b->config, b->context);
+    if (!client) {
+        close (fd);
+        return;
+    }
+
+    self->mux = HEV_FSH_CLIENT_SOCK_MUX (client);
+    hev_object_ref (HEV_OBJECT (client));
+    hev_fsh_io_run (HEV_FSH_IO (client));
+
+    if (hev_fsh_client_sock_mux_open (self->mux, fd) < 0)
         close (fd);
 }
 
 HevFshClientBase *
-hev_fsh_client_sock_listen_new (HevFshConfig *config)
+hev_fsh_client_sock_listen_new (HevFshConfig *config, HevFshContext *context)
 {
     HevFshClientSockListen *self;
     int res;
 
-    self = hev_malloc0 (sizeof (HevFshClientSockListen));
+    self = hev_object_pool_malloc0 (sizeof (HevFshClientSockListen));
     if (!self)
         return NULL;
 
-    res = hev_fsh_client_sock_listen_construct (self, config);
+    res = hev_fsh_client_sock_listen_construct (self, config, context);
     if (res < 0) {
-        hev_free (self);
+        hev_object_pool_free (self);
         return NULL;
     }
 
@@ -56,11 +84,12 @@ hev_fsh_client_sock_listen_new (HevFshConfig *config)
 
 int
 hev_fsh_client_sock_listen_construct (HevFshClientSockListen *self,
-                                      HevFshConfig *config)
+                                      HevFshConfig *config,
+                                      HevFshContext *context)
 {
     int res;
 
-    res = hev_fsh_client_listen_construct (&self->base, config);
+    res = hev_fsh_client_listen_construct (&self->base, config, context);
     if (res < 0)
         return res;
 
@@ -78,6 +107,9 @@ hev_fsh_client_sock_listen_destruct (HevObject *base)
 
     LOG_D ("%p fsh client sock listen destruct", self);
 
+    if (self->mux)
+        hev_object_unref (HEV_OBJECT (self->mux));
+
     HEV_FSH_CLIENT_LISTEN_TYPE->destruct (base);
 }
 
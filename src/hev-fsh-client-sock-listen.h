@@ -11,6 +11,7 @@
 #define __HEV_FSH_CLIENT_SOCK_LISTEN_H__
 
 #include "hev-fsh-client-listen.h"
+#include "hev-fsh-client-sock-mux.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -26,6 +27,8 @@ typedef struct _HevFshClientSockListenClass HevFshClientSockListenClass;
 struct _HevFshClientSockListen
 {
     HevFshClientListen base;
+
+    HevFshClientSockMux *mux;
 };
 
 struct _HevFshClientSockListenClass
@@ -36,9 +39,11 @@ struct _HevFshClientSockListenClass
 HevObjectClass *hev_fsh_client_sock_listen_class (void);
 
 int hev_fsh_client_sock_listen_construct (HevFshClientSockListen *self,
-                                          HevFshConfig *config);
+                                          HevFshConfig *config,
+                                          HevFshContext *context);
 
-HevFshClientBase *hev_fsh_client_sock_listen_new (HevFshConfig *config);
+HevFshClientBase *hev_fsh_client_sock_listen_new (HevFshConfig *config,
+                                                  HevFshContext *context);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,405 @@
+/*
+ ============================================================================
+ Name        : hev-fsh-client-sock-mux.c
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Fsh client sock mux
+ ============================================================================
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <hev-task.h>
+#include <hev-task-io.h>
+#include <hev-task-io-socket.h>
+#include <hev-memory-allocator.h>
+
+#include "hev-logger.h"
+#include "hev-object-pool.h"
+#include "hev-fsh-protocol.h"
+#include "hev-fsh-sock-udp.h"
+#include "hev-fsh-client-sock-connect.h"
+
+#include "hev-fsh-client-sock-mux.h"
+
+#define SOCKS5_CMD_UDP_ASSOCIATE (3)
+
+typedef struct _HevFshClientSockMuxClient HevFshClientSockMuxClient;
+
+struct _HevFshClientSockMuxClient
+{
+    HevFshClientSockMux *self;
+    int fd;
+};
+
+static int
+hev_fsh_client_sock_mux_spawn (HevFshClientSockMux *self, int fd)
+{
+    HevFshClientBase *base = HEV_FSH_CLIENT_BASE (self);
+    HevFshClientBase *client;
+
+    client = hev_fsh_client_sock_connect_new (base->config, base->context, fd);
+    if (!client)
+        return -1;
+
+    hev_fsh_io_run (HEV_FSH_IO (client));
+
+    return 0;
+}
+
+/*
+ * Settles on no authentication with the client, as the forwarder would, and
+ * returns the command of its request, left unread; or -1.
+ */
+static int
+hev_fsh_client_sock_mux_greet (HevFshClientSockMux *self, int fd)
+{
+    unsigned char buf[2 + 255];
+    int res;
+    int i;
+
+    res = hev_task_io_socket_recv (fd, buf, 2, MSG_WAITALL, io_yielder, self);
+    if (res != 2 || buf[0] != 5 || !buf[1])
+        return -1;
+
+    res = hev_task_io_socket_recv (fd, buf + 2, buf[1], MSG_WAITALL,
+                                   io_yielder, self);
+    if (res != buf[1])
+        return -1;
+
+    for (i = 0; i < buf[1]; i++)
+        if (buf[2 + i] == 0)
+            break;
+
+    buf[1] = (i < buf[1]) ? 0 : 0xff;
+    res = hev_task_io_socket_send (fd, buf, 2, MSG_WAITALL, io_yielder, self);
+    if (res != 2 || buf[1])
+        return -1;
+
+    for (;;) {
+        res = recv (fd, buf, 2, MSG_PEEK);
+        if (res == 2)
+            return buf[1];
+        if (res == 0 || (res < 0 && errno != EAGAIN))
+            return -1;
+        if (io_yielder (HEV_TASK_WAITIO, self) < 0)
+            return -1;
+    }
+}
+
+static int
+hev_fsh_client_sock_mux_udp_bind (int fd, struct sockaddr_storage *addr)
+{
+    socklen_t len = sizeof (struct sockaddr_storage);
+    int ufd;
+
+    /* where the client reached us, so it can send there too */
+    if (getsockname (fd, (struct sockaddr *)addr, &len) < 0)
+        return -1;
+
+    hev_fsh_sock_udp_unmap (addr);
+    if (addr->ss_family == AF_INET6)
+        ((struct sockaddr_in6 *)addr)->sin6_port = 0;
+    else
+        ((struct sockaddr_in *)addr)->sin_port = 0;
+
+    ufd = socket (addr->ss_family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                  0);
+    if (ufd < 0)
+        return -1;
+
+    len = sizeof (struct sockaddr_storage);
+    if (addr->ss_family == AF_INET)
+        len = sizeof (struct sockaddr_in);
+    if ((bind (ufd, (struct sockaddr *)addr, len) < 0) ||
+        (getsockname (ufd, (struct sockaddr *)addr, &len) < 0)) {
+        close (ufd);
+        return -1;
+    }
+
+    return ufd;
+}
+
+static void
+hev_fsh_client_sock_mux_udp (HevFshClientSockMux *self, int fd)
+{
+    HevTask *task = hev_task_self ();
+    struct sockaddr_storage addr;
+    unsigned char buf[4 + 1 + 255 + 2];
+    int ufd = -1;
+    int fds[2];
+    int size;
+    int res;
+
+    LOG_D ("%p fsh client sock mux udp", self);
+
+    /* VER, CMD, RSV, ATYP, then where the client will send from: unused */
+    res = hev_task_io_socket_recv (fd, buf, 5, MSG_WAITALL, io_yielder, self);
+    if (res != 5)
+        return;
+
+    switch (buf[3]) {
+    case 1:
+        size = 4 + 2 - 1;
+        break;
+    case 4:
+        size = 16 + 2 - 1;
+        break;
+    case 3:
+        size = buf[4] + 2;
+        break;
+    default:
+        return;
+    }
+
+    res = hev_task_io_socket_recv (fd, buf + 5, size, MSG_WAITALL,
+                                   io_yielder, self);
+    if (res != size)
+        return;
+
+    buf[0] = 5;
+    buf[1] = 1;
+    buf[2] = 0;
+    size = 3;
+
+    ufd = hev_fsh_client_sock_mux_udp_bind (fd, &addr);
+    if (ufd < 0)
+        goto reply;
+
+    if (socketpair (AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0,
+                    fds) < 0)
+        goto reply;
+
+    if (hev_task_io_mux_open (self->mux, fds[0], HEV_FSH_SOCK_MUX_UDP) < 0) {
+        close (fds[0]);
+        close (fds[1]);
+        goto reply;
+    }
+
+    buf[1] = 0;
+    size += hev_fsh_sock_udp_put_addr (buf + 3, &addr);
+
+reply:
+    if (buf[1]) {
+        __builtin_bzero (buf + 3, 7);
+        buf[3] = 1;
+        size += 7;
+    }
+
+    res = hev_task_io_socket_send (fd, buf, size, MSG_WAITALL, io_yielder,
+                                   self);
+    if (res == size && !buf[1]) {
+        hev_task_add_fd (task, ufd, POLLIN | POLLOUT);
+        hev_task_add_fd (task, fds[1], POLLIN | POLLOUT);
+        hev_fsh_sock_udp_client_run (fd, ufd, fds[1], io_yielder, self);
+    }
+
+    if (!buf[1])
+        close (fds[1]);
+    if (ufd >= 0)
+        close (ufd);
+}
+
+static void
+hev_fsh_client_sock_mux_client_entry (void *data)
+{
+    HevFshClientSockMuxClient *client = data;
+    HevFshClientSockMux *self = client->self;
+    HevTask *task = hev_task_self ();
+    int fd = client->fd;
+    int cmd;
+
+    hev_free (client);
+
+    hev_task_add_fd (task, fd, POLLIN | POLLOUT);
+
+    cmd = hev_fsh_client_sock_mux_greet (self, fd);
+    if (cmd == SOCKS5_CMD_UDP_ASSOCIATE) {
+        hev_fsh_client_sock_mux_udp (self, fd);
+    } else if (cmd >= 0) {
+        hev_task_del_fd (task, fd);
+        if (hev_task_io_mux_open (self->mux, fd, HEV_FSH_SOCK_MUX_STREAM) == 0)
+            fd = -1;
+    }
+
+    if (fd >= 0)
+        close (fd);
+
+    hev_object_unref (HEV_OBJECT (self));
+}
+
+/* Greets the client in a task of its own, to see what it asks for. */
+static int
+hev_fsh_client_sock_mux_client (HevFshClientSockMux *self, int fd)
+{
+    HevFshClientSockMuxClient *client;
+    HevTask *task;
+
+    client = hev_malloc (sizeof (HevFshClientSockMuxClient));
+    if (!client)
+        return -1;
+
+    task = hev_task_new (HEV_FSH_CONFIG_TASK_STACK_SIZE);
+    if (!task) {
+        hev_free (client);
+        return -1;
+    }
+
+    client->self = self;
+    client->fd = fd;
+
+    hev_object_ref (HEV_OBJECT (self));
+    hev_task_run (task, hev_fsh_client_sock_mux_client_entry, client);
+
+    return 0;
+}
+
+static void
+hev_fsh_client_sock_mux_task_entry (void *data)
+{
+    HevFshClientSockMux *self = data;
+    HevFshClientBase *base = data;
+    int res;
+    int fd;
+
+    res = hev_fsh_client_connect_send_connect (&self->base);
+    if (res < 0)
+        goto exit;
+
+    if (base->flags & HEV_FSH_HELLO_F_SOCK_MUX) {
+        /* those queued so far are greeted like those to come */
+        self->ready = 1;
+        while ((fd = hev_task_io_mux_steal (self->mux)) >= 0) {
+            if (hev_fsh_client_sock_mux_client (self, fd) < 0)
+                close (fd);
+        }
+
+        hev_task_io_mux_run (self->mux, base->fd, io_yielder, self);
+        goto exit;
+    }
+
+    LOG_D ("%p fsh client sock mux legacy", self);
+
+    /* an old forwarder: one tunnel per client, as before */
+    self->legacy = 1;
+    while ((fd = hev_task_io_mux_steal (self->mux)) >= 0) {
+        if (hev_fsh_client_sock_mux_spawn (self, fd) < 0)
+            close (fd);
+    }
+
+    hev_object_unref (HEV_OBJECT (self));
+    return;
+
+exit:
+    /* clients still queued get no tunnel: let them go */
+    self->done = 1;
+    while ((fd = hev_task_io_mux_steal (self->mux)) >= 0)
+        close (fd);
+
+    hev_object_unref (HEV_OBJECT (self));
+}
+
+static void
+hev_fsh_client_sock_mux_run (HevFshIO *base)
+{
+    LOG_D ("%p fsh client sock mux run", base);
+
+    hev_task_run (base->task, hev_fsh_client_sock_mux_task_entry, base);
+}
+
+int
+hev_fsh_client_sock_mux_open (HevFshClientSockMux *self, int fd)
+{
+    if (self->done)
+        return -1;
+
+    if (self->legacy)
+        return hev_fsh_client_sock_mux_spawn (self, fd);
+
+    if (self->ready)
+        return hev_fsh_client_sock_mux_client (self, fd);
+
+    return hev_task_io_mux_open (self->mux, fd, HEV_FSH_SOCK_MUX_STREAM);
+}
+
+HevFshClientBase *
+hev_fsh_client_sock_mux_new (HevFshConfig *config, HevFshContext *context)
+{
+    HevFshClientSockMux *self;
+    int res;
+
+    self = hev_object_pool_malloc0 (sizeof (HevFshClientSockMux));
+    if (!self)
+        return NULL;
+
+    res = hev_fsh_client_sock_mux_construct (self, config, context);
+    if (res < 0) {
+        hev_object_pool_free (self);
+        return NULL;
+    }
+
+    LOG_D ("%p fsh client sock mux new", self);
+
+    return HEV_FSH_CLIENT_BASE (self);
+}
+
+int
+hev_fsh_client_sock_mux_construct (HevFshClientSockMux *self,
+                                   HevFshConfig *config, HevFshContext *context)
+{
+    int res;
+
+    res = hev_fsh_client_connect_construct (&self->base, config, context);
+    if (res < 0)
+        return res;
+
+    LOG_D ("%p fsh client sock mux construct", self);
+
+    HEV_OBJECT (self)->klass = HEV_FSH_CLIENT_SOCK_MUX_TYPE;
+
+    self->mux = hev_task_io_mux_new (NULL, NULL);
+    if (!self->mux)
+        return -1;
+
+    HEV_FSH_CLIENT_BASE (self)->offer = HEV_FSH_HELLO_F_SOCK_MUX;
+
+    return 0;
+}
+
+static void
+hev_fsh_client_sock_mux_destruct (HevObject *base)
+{
+    HevFshClientSockMux *self = HEV_FSH_CLIENT_SOCK_MUX (base);
+
+    LOG_D ("%p fsh client sock mux destruct", self);
+
+    hev_task_io_mux_destroy (self->mux);
+
+    HEV_FSH_CLIENT_CONNECT_TYPE->destruct (base);
+}
+
+HevObjectClass *
+hev_fsh_client_sock_mux_class (void)
+{
+    static HevFshClientSockMuxClass klass;
+    HevFshClientSockMuxClass *kptr = &klass;
+    HevObjectClass *okptr = HEV_OBJECT_CLASS (kptr);
+
+    if (!okptr->name) {
+        HevFshIOClass *ikptr;
+        void *ptr;
+
+        ptr = HEV_FSH_CLIENT_CONNECT_TYPE;
+        memcpy (kptr, ptr, sizeof (HevFshClientConnectClass));
+
+        okptr->name = "HevFshClientSockMux";
+        okptr->destruct = hev_fsh_client_sock_mux_destruct;
+
+        ikptr = HEV_FSH_IO_CLASS (kptr);
+        ikptr->run = hev_fsh_client_sock_mux_run;
+    }
+
+    return okptr;
+}
@@ -0,0 +1,62 @@
+/*
+ ============================================================================
+ Name        : hev-fsh-client-sock-mux.h
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Fsh client sock mux
+ ============================================================================
+ */
+
+#ifndef __HEV_FSH_CLIENT_SOCK_MUX_H__
+#define __HEV_FSH_CLIENT_SOCK_MUX_H__
+
+#include "hev-task-io-mux.h"
+#include "hev-fsh-client-connect.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HEV_FSH_CLIENT_SOCK_MUX(p) ((HevFshClientSockMux *)p)
+#define HEV_FSH_CLIENT_SOCK_MUX_CLASS(P) ((HevFshClientSockMuxClass *)p)
+#define HEV_FSH_CLIENT_SOCK_MUX_TYPE (hev_fsh_client_sock_mux_class ())
+
+typedef struct _HevFshClientSockMux HevFshClientSockMux;
+typedef struct _HevFshClientSockMuxClass HevFshClientSockMuxClass;
+
+struct _HevFshClientSockMux
+{
+    HevFshClientConnect base;
+
+    HevTaskIOMux *mux;
+    unsigned int legacy : 1;
+    unsigned int ready : 1;
+    unsigned int done : 1;
+};
+
+struct _HevFshClientSockMuxClass
+{
+    HevFshClientConnectClass base;
+};
+
+HevObjectClass *hev_fsh_client_sock_mux_class (void);
+
+int hev_fsh_client_sock_mux_construct (HevFshClientSockMux *self,
+                                       HevFshConfig *config,
+                                       HevFshContext *context);
+
+HevFshClientBase *hev_fsh_client_sock_mux_new (HevFshConfig *config,
+                                               HevFshContext *context);
+
+/*
+ * Carries the SOCKS client fd, taken over, in the tunnel, UDP associations
+ * included; a forwarder that cannot multiplex gets a tunnel of its own for
+ * it. Returns -1 once the tunnel is gone, and the fd stays the caller's.
+ */
+int hev_fsh_client_sock_mux_open (HevFshClientSockMux *self, int fd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HEV_FSH_CLIENT_SOCK_MUX_H__ */
@@ -0,0 +1,150 @@
+/*
+ ============================================================================
+ Name        : hev-fsh-client-stripe-connect.c
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Fsh client stripe connect
+ ============================================================================
+ */
+
+#include <string.h>
+#include <unistd.h>
+
+#include <hev-task.h>
+#include <hev-task-io.h>
+#include <hev-task-io-socket.h>
+#include <hev-memory-allocator.h>
+
+#include "hev-logger.h"
+#include "hev-object-pool.h"
+
+#include "hev-fsh-client-stripe-connect.h"
+
+static void
+hev_fsh_client_stripe_connect_task_entry (void *data)
+{
+    HevFshClientStripeConnect *self = data;
+    HevFshClientBase *base = data;
+    HevFshStripes *stripes;
+    int res;
+
+    stripes = hev_fsh_context_get_stripes (base->context);
+
+    res = hev_fsh_client_connect_send_connect (&self->base);
+    if (res < 0)
+        goto exit;
+
+    if (!(base->flags & HEV_FSH_HELLO_F_STRIPE))
+        goto exit;
+
+    res = hev_task_io_socket_send (base->fd, &self->mstripe,
+                                   sizeof (self->mstripe), MSG_WAITALL,
+                                   io_yielder, self);
+    if (res <= 0)
+        goto exit;
+
+    hev_task_del_fd (hev_task_self (), base->fd);
+    res = hev_fsh_stripes_join (stripes, self->mstripe.id,
+                                self->mstripe.index, self->mstripe.count,
+                                base->fd);
+    if (res < 0) {
+        LOG_D ("%p fsh client stripe connect join", self);
+        goto exit;
+    }
+
+    base->fd = -1;
+    hev_object_unref (HEV_OBJECT (self));
+    return;
+
+exit:
+    /* the tunnel cannot be whole: its first connection need not wait */
+    hev_fsh_stripes_abort (stripes, self->mstripe.id, self->mstripe.count);
+    hev_object_unref (HEV_OBJECT (self));
+}
+
+static void
+hev_fsh_client_stripe_connect_run (HevFshIO *base)
+{
+    LOG_D ("%p fsh client stripe connect run", base);
+
+    hev_task_run (base->task, hev_fsh_client_stripe_connect_task_entry, base);
+}
+
+HevFshClientBase *
+hev_fsh_client_stripe_connect_new (HevFshConfig *config, HevFshContext *context,
+                                   HevFshMessageStripe *mstripe)
+{
+    HevFshClientStripeConnect *self;
+    int res;
+
+    self = hev_object_pool_malloc0 (sizeof (HevFshClientStripeConnect));
+    if (!self)
+        return NULL;
+
+    res = hev_fsh_client_stripe_connect_construct (self, config, context,
+                                                   mstripe);
+    if (res < 0) {
+        hev_object_pool_free (self);
+        return NULL;
+    }
+
+    LOG_D ("%p fsh client stripe connect new", self);
+
+    return HEV_FSH_CLIENT_BASE (self);
+}
+
+int
+hev_fsh_client_stripe_connect_construct (HevFshClientStripeConnect *self,
+                                         HevFshConfig *config,
+                                         HevFshContext *context,
+                                         HevFshMessageStripe *mstripe)
+{
+    int res;
+
+    res = hev_fsh_client_connect_construct (&self->base, config, context);
+    if (res < 0)
+        return res;
+
+    LOG_D ("%p fsh client stripe connect construct", self);
+
+    HEV_OBJECT (self)->klass = HEV_FSH_CLIENT_STRIPE_CONNECT_TYPE;
+    HEV_FSH_CLIENT_BASE (self)->offer = HEV_FSH_HELLO_F_STRIPE;
+
+    memcpy (&self->mstripe, mstripe, sizeof (HevFshMessageStripe));
+
+    return 0;
+}
+
+static void
+hev_fsh_client_stripe_connect_destruct (HevObject *base)
+{
+    HevFshClientStripeConnect *self = HEV_FSH_CLIENT_STRIPE_CONNECT (base);
+
+    LOG_D ("%p fsh client stripe connect destruct", self);
+
+    HEV_FSH_CLIENT_CONNECT_TYPE->destruct (base);
+}
+
+HevObjectClass *
+hev_fsh_client_stripe_connect_class (void)
+{
+    static HevFshClientStripeConnectClass klass;
+    HevFshClientStripeConnectClass *kptr = &klass;
+    HevObjectClass *okptr = HEV_OBJECT_CLASS (kptr);
+
+    if (!okptr->name) {
+        HevFshIOClass *ikptr;
+        void *ptr;
+
+        ptr = HEV_FSH_CLIENT_CONNECT_TYPE;
+        memcpy (kptr, ptr, sizeof (HevFshClientConnectClass));
+
+        okptr->name = "HevFshClientStripeConnect";
+        okptr->destruct = hev_fsh_client_stripe_connect_destruct;
+
+        ikptr = HEV_FSH_IO_CLASS (kptr);
+        ikptr->run = hev_fsh_client_stripe_connect_run;
+    }
+
+    return okptr;
+}
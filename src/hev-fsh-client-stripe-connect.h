@@ -0,0 +1,58 @@
+/*
+ ============================================================================
+ Name        : hev-fsh-client-stripe-connect.h
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Fsh client stripe connect
+ ============================================================================
+ */
+
+#ifndef __HEV_FSH_CLIENT_STRIPE_CONNECT_H__
+#define __HEV_FSH_CLIENT_STRIPE_CONNECT_H__
+
+#include "hev-fsh-protocol.h"
+#include "hev-fsh-client-connect.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HEV_FSH_CLIENT_STRIPE_CONNECT(p) ((HevFshClientStripeConnect *)p)
+#define HEV_FSH_CLIENT_STRIPE_CONNECT_CLASS(P) ((HevFshClientStripeConnectClass *)p)
+#define HEV_FSH_CLIENT_STRIPE_CONNECT_TYPE (hev_fsh_client_stripe_connect_class ())
+
+typedef struct _HevFshClientStripeConnect HevFshClientStripeConnect;
+typedef struct _HevFshClientStripeConnectClass HevFshClientStripeConnectClass;
+
+/*
+ * One of the extra connections of a striped port tunnel: once through the
+ * relay, it joins the tunnel in the config's stripes and is done.
+ */
+struct _HevFshClientStripeConnect
+{
+    HevFshClientConnect base;
+
+    HevFshMessageStripe mstripe;
+};
+
+struct _HevFshClientStripeConnectClass
+{
+    HevFshClientConnectClass base;
+};
+
+HevObjectClass *hev_fsh_client_stripe_connect_class (void);
+
+int hev_fsh_client_stripe_connect_construct (HevFshClientStripeConnect *self,
+                                             HevFshConfig *config,
+                                             HevFshContext *context,
+                                             HevFshMessageStripe *mstripe);
+
+HevFshClientBase *
+hev_fsh_client_stripe_connect_new (HevFshConfig *config, HevFshContext *context,
+                                   HevFshMessageStripe *mstripe);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HEV_FSH_CLIENT_STRIPE_CONNECT_H__ */
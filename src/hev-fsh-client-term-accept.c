@@ -7,105 +7,68 @@
  ============================================================================
  */
 
-#include <fcntl.h>
-#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
-#include <pwd.h>
-#if defined(__linux__)
-#include <pty.h>
-#elif defined(__APPLE__) || (__MACH__)
-#include <util.h>
-#else
-#include <termios.h>
-#include <libutil.h>
-#endif
+#include <arpa/inet.h>
 
 #include <hev-task.h>
 #include <hev-task-io.h>
-#include <hev-task-call.h>
 #include <hev-task-io-socket.h>
 #include <hev-memory-allocator.h>
 
 #include "hev-logger.h"
-#include "hev-task-io-us.h"
+#include "hev-object-pool.h"
+#include "hev-task-io-term.h"
 #include "hev-fsh-protocol.h"
+#include "hev-fsh-shell-pool.h"
+#include "hev-fsh-term-sessions.h"
 
 #include "hev-fsh-client-term-accept.h"
 
-typedef struct _HevTaskCallForkPty HevTaskCallForkPty;
-
-struct _HevTaskCallForkPty
+/*
+ * Answers a resume request: term is set to the parked session, or left NULL
+ * for a new one. Returns -1 once the connector is told it is gone.
+ */
+static int
+hev_fsh_client_term_accept_resume (HevFshClientTermAccept *self,
+                                   HevFshTermSessions *sessions,
+                                   HevFshMessageTermResume *mresume,
+                                   HevTaskIOTerm **term, int *pfd)
 {
-    HevTaskCall base;
-
-    int *pfd;
-    HevFshConfig *config;
-    HevFshMessageTermInfo *term_info;
-};
+    HevFshClientBase *base = HEV_FSH_CLIENT_BASE (self);
+    static const HevFshToken zero;
+    unsigned int offset = 0;
+    int gone = 0;
+    int res;
 
-static void
-exec_shell (HevFshConfig *config)
-{
-    const char *sh = "/bin/sh";
-    const char *bash = "/bin/bash";
-    const char *cmd = bash;
-
-    if (access (bash, X_OK) < 0)
-        cmd = sh;
-
-    if (getuid () == 0) {
-        const char *user;
-
-        user = hev_fsh_config_get_user (config);
-        if (user) {
-            struct passwd *pwd;
-
-            pwd = getpwnam (user);
-            if (pwd) {
-                if (setgid (pwd->pw_gid)) {
-                    /* ignore return value */
-                }
-                if (setuid (pwd->pw_uid)) {
-                    /* ignore return value */
-                }
-            }
-        } else {
-            setsid ();
-            cmd = "/bin/login";
-        }
+    if (memcmp (mresume->id, zero, sizeof (HevFshToken)) == 0) {
+        hev_fsh_protocol_token_generate (mresume->id);
+        hev_fsh_term_sessions_attach (sessions, mresume->id, base->fd);
+    } else if (hev_fsh_term_sessions_take (sessions, mresume->id, base->fd,
+                                           term, pfd) < 0) {
+        LOG_D ("%p fsh client term accept resume gone", self);
+        gone = 1;
+    } else if (hev_task_io_term_rewind (*term,
+                                        ntohl (mresume->offset)) < 0) {
+        LOG_D ("%p fsh client term accept resume too late", self);
+        hev_fsh_term_sessions_detach (sessions, mresume->id);
+        gone = 1;
+    } else {
+        LOG_D ("%p fsh client term accept resume", self);
+        offset = hev_task_io_term_get_rx (*term);
     }
 
-    if (!getenv ("TERM"))
-        setenv ("TERM", "linux", 1);
-
-    execl (cmd, cmd, NULL);
-    exit (0);
-}
-
-static void
-forkpty_entry (HevTaskCall *call)
-{
-    HevTaskCallForkPty *fpty = (HevTaskCallForkPty *)call;
-    pid_t pid;
-
-    pid = forkpty (fpty->pfd, NULL, NULL, NULL);
-    if (pid < 0) {
-        hev_task_call_set_retval (call, NULL);
-    } else if (pid == 0) {
-        exec_shell (fpty->config);
-    } else {
-        struct winsize win_size;
+    if (gone)
+        memset (mresume->id, 0, sizeof (HevFshToken));
+    mresume->offset = htonl (offset);
 
-        win_size.ws_row = fpty->term_info->rows;
-        win_size.ws_col = fpty->term_info->columns;
-        win_size.ws_xpixel = 0;
-        win_size.ws_ypixel = 0;
+    res = hev_task_io_socket_send (base->fd, mresume, sizeof (*mresume),
+                                   MSG_WAITALL, io_yielder, self);
+    if (res <= 0 || gone)
+        return -1;
 
-        ioctl (*fpty->pfd, TIOCSWINSZ, &win_size);
-        hev_task_call_set_retval (call, fpty);
-    }
+    return 0;
 }
 
 static void
@@ -113,18 +76,36 @@ hev_fsh_client_term_accept_task_entry (void *data)
 {
     HevFshClientTermAccept *self = data;
     HevFshClientBase *base = data;
+    HevFshMessageTermResume mresume;
     HevFshMessageTermInfo mtinfo;
-    HevTaskCallForkPty *fpty;
-    HevTaskCall *call;
-    void *ptr;
+    HevFshTermSessions *sessions;
+    HevTaskIOTerm *term = NULL;
+    HevFshShellPool *pool;
+    struct winsize win_size;
+    size_t replay;
+    int flags;
     int sfd;
-    int pfd;
+    int pfd = -1;
     int res;
 
     res = hev_fsh_client_accept_send_accept (&self->base);
     if (res < 0)
         goto quit;
 
+    flags = HEV_TASK_IO_TERM_F_PTY;
+    if (base->flags & HEV_FSH_HELLO_F_TERM_CTL)
+        flags |= HEV_TASK_IO_TERM_F_CTL;
+    if (base->flags & HEV_FSH_HELLO_F_TERM_ECHO)
+        flags |= HEV_TASK_IO_TERM_F_ECHO;
+
+    sessions = NULL;
+    replay = HEV_TASK_IO_TERM_SIZE;
+    if (base->flags & HEV_FSH_HELLO_F_TERM_RESUME) {
+        sessions = hev_fsh_context_get_term_sessions (base->context);
+        flags |= HEV_TASK_IO_TERM_F_RESUME;
+        replay = HEV_TASK_IO_TERM_REPLAY_PTY;
+    }
+
     sfd = base->fd;
     /* recv msg term info */
     res = hev_task_io_socket_recv (sfd, &mtinfo, sizeof (mtinfo), MSG_WAITALL,
@@ -132,33 +113,59 @@ hev_fsh_client_term_accept_task_entry (void *data)
     if (res != sizeof (mtinfo))
         goto quit;
 
-    call = hev_task_call_new (sizeof (HevTaskCallForkPty), 16384);
-    if (!call)
-        goto quit;
+    if (sessions) {
+        res = hev_task_io_socket_recv (sfd, &mresume, sizeof (mresume),
+                                       MSG_WAITALL, io_yielder, self);
+        if (res != sizeof (mresume))
+            goto quit;
 
-    fpty = (HevTaskCallForkPty *)call;
-    fpty->pfd = &pfd;
-    fpty->term_info = &mtinfo;
-    fpty->config = base->config;
+        res = hev_fsh_client_term_accept_resume (self, sessions, &mresume,
+                                                 &term, &pfd);
+        if (res < 0)
+            goto quit_close;
+    }
 
-    ptr = hev_task_call_jump (call, forkpty_entry);
-    hev_task_call_destroy (call);
-    if (!ptr)
-        goto quit;
+    if (!term) {
+        pool = hev_fsh_context_get_shell_pool (base->context);
+        if (pool)
+            pfd = hev_fsh_shell_pool_get (pool);
 
-    res = fcntl (pfd, F_SETFL, O_NONBLOCK);
-    if (res < 0)
-        goto quit_close;
+        if (pfd < 0) {
+            const char *user = hev_fsh_config_get_user (base->config);
+
+            pfd = hev_fsh_shell_pool_spawn (user);
+            if (pfd < 0)
+                goto quit_close;
+        }
+
+        term = hev_task_io_term_new (pfd, pfd, -1, replay, flags);
+        if (!term)
+            goto quit_close;
+    }
+
+    /* a pooled or resumed shell learns its size here, by SIGWINCH */
+    win_size.ws_row = mtinfo.rows;
+    win_size.ws_col = mtinfo.columns;
+    win_size.ws_xpixel = 0;
+    win_size.ws_ypixel = 0;
+    ioctl (pfd, TIOCSWINSZ, &win_size);
 
     hev_task_add_fd (hev_task_self (), pfd, POLLIN | POLLOUT);
+    res = hev_task_io_term_run (term, sfd, io_yielder, self);
+    hev_task_del_fd (hev_task_self (), pfd);
 
-    if (hev_fsh_config_is_ugly_ktls (base->config))
-        hev_task_io_us_splice (sfd, sfd, pfd, pfd, 8192, io_yielder, self);
-    else
-        hev_task_io_splice (sfd, sfd, pfd, pfd, 8192, io_yielder, self);
+    /* the link dropped with the shell still running: wait for a resume */
+    if (!res && sessions &&
+        hev_fsh_term_sessions_park (sessions, mresume.id, term, pfd) == 0)
+        goto quit;
 
 quit_close:
-    close (pfd);
+    if (sessions)
+        hev_fsh_term_sessions_detach (sessions, mresume.id);
+    if (term)
+        hev_task_io_term_destroy (term);
+    if (pfd >= 0)
+        close (pfd);
 quit:
     hev_object_unref (HEV_OBJECT (self));
 }
@@ -172,18 +179,19 @@ hev_fsh_client_term_accept_run (HevFshIO *base)
 }
 
 HevFshClientBase *
-hev_fsh_client_term_accept_new (HevFshConfig *config, HevFshToken token)
+hev_fsh_client_term_accept_new (HevFshConfig *config, HevFshContext *context,
+                                HevFshToken token)
 {
     HevFshClientTermAccept *self;
     int res;
 
-    self = hev_malloc0 (sizeof (HevFshClientTermAccept));
+    self = hev_object_pool_malloc0 (sizeof (HevFshClientTermAccept));
     if (!self)
         return NULL;
 
-    res = hev_fsh_client_term_accept_construct (self, config, token);
+    res = hev_fsh_client_term_accept_construct (self, config, context, token);
     if (res < 0) {
-        hev_free (self);
+        hev_object_pool_free (self);
         return NULL;
     }
 
@@ -194,17 +202,23 @@ hev_fsh_client_term_accept_new (HevFshConfig *config, HevFshToken token)
 
 int
 hev_fsh_client_term_accept_construct (HevFshClientTermAccept *self,
-                                      HevFshConfig *config, HevFshToken token)
+                                      HevFshConfig *config,
+                                      HevFshContext *context, HevFshToken token)
 {
     int res;
 
-    res = hev_fsh_client_accept_construct (&self->base, config, token);
+    res = hev_fsh_client_accept_construct (&self->base, config, context, token);
     if (res < 0)
         return res;
 
     LOG_D ("%p fsh client term accept construct", self);
 
     HEV_OBJECT (self)->klass = HEV_FSH_CLIENT_TERM_ACCEPT_TYPE;
+    HEV_FSH_CLIENT_BASE (self)->nodelay = 1;
+    HEV_FSH_CLIENT_BASE (self)->offer = HEV_FSH_HELLO_F_TERM_CTL;
+    HEV_FSH_CLIENT_BASE (self)->offer |= HEV_FSH_HELLO_F_TERM_ECHO;
+    if (hev_fsh_context_get_term_sessions (context))
+        HEV_FSH_CLIENT_BASE (self)->offer |= HEV_FSH_HELLO_F_TERM_RESUME;
 
     return 0;
 }
@@ -37,9 +37,11 @@ HevObjectClass *hev_fsh_client_term_accept_class (void);
 
 int hev_fsh_client_term_accept_construct (HevFshClientTermAccept *self,
                                           HevFshConfig *config,
+                                          HevFshContext *context,
                                           HevFshToken token);
 
 HevFshClientBase *hev_fsh_client_term_accept_new (HevFshConfig *config,
+                                                  HevFshContext *context,
                                                   HevFshToken token);
 
 #ifdef __cplusplus
@@ -7,11 +7,14 @@
  ============================================================================
  */
 
+#include <errno.h>
 #include <fcntl.h>
+#include <signal.h>
 #include <string.h>
 #include <unistd.h>
 #include <termios.h>
 #include <sys/ioctl.h>
+#include <arpa/inet.h>
 
 #include <hev-task.h>
 #include <hev-task-io.h>
@@ -19,39 +22,193 @@
 #include <hev-memory-allocator.h>
 
 #include "hev-logger.h"
-#include "hev-task-io-us.h"
+#include "hev-object-pool.h"
+#include "hev-task-io-term.h"
 #include "hev-fsh-protocol.h"
 
 #include "hev-fsh-client-term-connect.h"
 
+/* how long a dropped session is tried to be resumed: times, ms apart */
+#define HEV_FSH_CLIENT_TERM_CONNECT_RETRIES (60)
+#define HEV_FSH_CLIENT_TERM_CONNECT_RETRY (1000)
+
+static int winch_fd = -1;
+
 static void
-hev_fsh_client_term_connect_task_entry (void *data)
+winch_handler (int signum)
 {
-    HevFshClientTermConnect *self = data;
-    HevFshClientBase *base = data;
+    int err = errno;
+
+    if (write (winch_fd, "", 1)) {
+        /* ignore return value */
+    }
+    errno = err;
+}
+
+/*
+ * Opens the session on a new link: term info, then with resume the session
+ * id (updated from the answer) and where term continues. Returns -2 if the
+ * forwarder no longer has the session.
+ */
+static int
+hev_fsh_client_term_connect_open (HevFshClientTermConnect *self,
+                                  HevTaskIOTerm *term, HevFshToken id)
+{
+    HevFshClientBase *base = HEV_FSH_CLIENT_BASE (self);
+    HevFshMessageTermResume mresume;
     HevFshMessageTermInfo mtinfo;
+    static const HevFshToken zero;
     struct winsize win_size;
-    struct termios term_rsh;
-    struct termios term;
     int res;
-    int fd;
-
-    res = hev_fsh_client_connect_send_connect (&self->base);
-    if (res < 0)
-        goto exit;
 
     res = ioctl (0, TIOCGWINSZ, &win_size);
     if (res < 0)
-        goto exit;
+        return -1;
 
-    fd = base->fd;
     mtinfo.rows = win_size.ws_row;
     mtinfo.columns = win_size.ws_col;
 
     /* send message term info */
-    res = hev_task_io_socket_send (fd, &mtinfo, sizeof (mtinfo), MSG_WAITALL,
-                                   io_yielder, self);
+    res = hev_task_io_socket_send (base->fd, &mtinfo, sizeof (mtinfo),
+                                   MSG_WAITALL, io_yielder, self);
+    if (res <= 0)
+        return -1;
+
+    if (!(base->flags & HEV_FSH_HELLO_F_TERM_RESUME))
+        return 0;
+
+    memcpy (mresume.id, id, sizeof (HevFshToken));
+    mresume.offset = htonl (hev_task_io_term_get_rx (term));
+
+    res = hev_task_io_socket_send (base->fd, &mresume, sizeof (mresume),
+                                   MSG_WAITALL, io_yielder, self);
     if (res <= 0)
+        return -1;
+
+    res = hev_task_io_socket_recv (base->fd, &mresume, sizeof (mresume),
+                                   MSG_WAITALL, io_yielder, self);
+    if (res != sizeof (mresume))
+        return -1;
+
+    if (memcmp (mresume.id, zero, sizeof (HevFshToken)) == 0) {
+        LOG_E ("%p fsh client term connect session gone", self);
+        return -2;
+    }
+
+    memcpy (id, mresume.id, sizeof (HevFshToken));
+    if (hev_task_io_term_rewind (term, ntohl (mresume.offset)) < 0) {
+        LOG_E ("%p fsh client term connect rewind", self);
+        return -2;
+    }
+
+    return 0;
+}
+
+static int
+hev_fsh_client_term_connect_reconnect (HevFshClientTermConnect *self,
+                                       HevTaskIOTerm *term, HevFshToken id)
+{
+    HevFshClientBase *base = HEV_FSH_CLIENT_BASE (self);
+    int flags = base->flags;
+    int i;
+
+    for (i = 0; i < HEV_FSH_CLIENT_TERM_CONNECT_RETRIES; i++) {
+        unsigned int wait = HEV_FSH_CLIENT_TERM_CONNECT_RETRY;
+        int res;
+
+        if (base->fd >= 0) {
+            hev_task_del_fd (hev_task_self (), base->fd);
+            close (base->fd);
+            base->fd = -1;
+        }
+
+        /* keystrokes wake the sleep, they wait in the tty meanwhile */
+        if (i)
+            while (wait)
+                wait = hev_task_sleep (wait);
+
+        LOG_D ("%p fsh client term connect reconnect", self);
+
+        res = hev_fsh_client_connect_send_connect (&self->base);
+        if (res < 0)
+            continue;
+
+        /* a forwarder restarted with other options cannot resume */
+        if (base->flags != flags)
+            return -1;
+
+        res = hev_fsh_client_term_connect_open (self, term, id);
+        if (res == -2)
+            return -1;
+        if (res == 0)
+            return 0;
+    }
+
+    return -1;
+}
+
+static void
+hev_fsh_client_term_connect_attach (HevFshClientTermConnect *self,
+                                    HevTaskIOTerm *term, HevFshToken id)
+{
+    HevFshClientBase *base = HEV_FSH_CLIENT_BASE (self);
+
+    LOG_D ("%p fsh client term connect attach", self);
+
+    for (;;) {
+        int res;
+
+        res = hev_task_io_term_run (term, base->fd, io_yielder, self);
+        if (res || !(base->flags & HEV_FSH_HELLO_F_TERM_RESUME))
+            break;
+
+        LOG_D ("%p fsh client term connect link lost", self);
+
+        res = hev_fsh_client_term_connect_reconnect (self, term, id);
+        if (res < 0)
+            break;
+    }
+}
+
+static void
+hev_fsh_client_term_connect_task_entry (void *data)
+{
+    HevFshClientTermConnect *self = data;
+    HevFshClientBase *base = data;
+    HevTaskIOTerm *term = NULL;
+    HevTask *task = hev_task_self ();
+    struct termios term_rsh;
+    struct termios term_old;
+    HevFshToken id = { 0 };
+    int fds[2] = { -1, -1 };
+    int flags = 0;
+    int res;
+
+    res = hev_fsh_client_connect_send_connect (&self->base);
+    if (res < 0)
+        goto exit;
+
+    if (base->flags & HEV_FSH_HELLO_F_TERM_CTL) {
+        flags |= HEV_TASK_IO_TERM_F_CTL;
+
+        if (pipe (fds) < 0)
+            goto exit;
+        if (fcntl (fds[0], F_SETFL, O_NONBLOCK) < 0 ||
+            fcntl (fds[1], F_SETFL, O_NONBLOCK) < 0)
+            goto exit;
+    }
+    if (base->flags & HEV_FSH_HELLO_F_TERM_RESUME)
+        flags |= HEV_TASK_IO_TERM_F_RESUME;
+    if (base->flags & HEV_FSH_HELLO_F_TERM_ECHO)
+        flags |= HEV_TASK_IO_TERM_F_ECHO;
+
+    term = hev_task_io_term_new (0, 1, fds[0], HEV_TASK_IO_TERM_REPLAY_TTY,
+                                 flags);
+    if (!term)
+        goto exit;
+
+    res = hev_fsh_client_term_connect_open (self, term, id);
+    if (res < 0)
         goto exit;
 
     res = fcntl (0, F_SETFL, O_NONBLOCK);
@@ -61,28 +218,46 @@ hev_fsh_client_term_connect_task_entry (void *data)
     if (res < 0)
         goto exit;
 
-    hev_task_add_fd (hev_task_self (), 0, POLLIN);
-    hev_task_add_fd (hev_task_self (), 1, POLLOUT);
+    hev_task_add_fd (task, 0, POLLIN);
+    hev_task_add_fd (task, 1, POLLOUT);
 
-    res = tcgetattr (0, &term);
+    res = tcgetattr (0, &term_old);
     if (res < 0)
         goto exit;
 
-    memcpy (&term_rsh, &term, sizeof (term));
+    memcpy (&term_rsh, &term_old, sizeof (term_old));
     term_rsh.c_oflag &= ~(OPOST);
     term_rsh.c_lflag &= ~(ISIG | ICANON | IEXTEN | ECHO | ECHOE | ECHOK);
     res = tcsetattr (0, TCSADRAIN, &term_rsh);
     if (res < 0)
         goto exit;
 
-    if (hev_fsh_config_is_ugly_ktls (base->config))
-        hev_task_io_us_splice (fd, fd, 0, 1, 8192, io_yielder, self);
-    else
-        hev_task_io_splice (fd, fd, 0, 1, 8192, io_yielder, self);
+    if (flags) {
+        if (fds[0] >= 0) {
+            winch_fd = fds[1];
+            hev_task_add_fd (task, fds[0], POLLIN);
+            signal (SIGWINCH, winch_handler);
+        }
+
+        hev_fsh_client_term_connect_attach (self, term, id);
+
+        if (fds[0] >= 0) {
+            signal (SIGWINCH, SIG_DFL);
+            hev_task_del_fd (task, fds[0]);
+        }
+    } else {
+        hev_fsh_client_base_splice (base, 0, 1);
+    }
 
-    tcsetattr (0, TCSADRAIN, &term);
+    tcsetattr (0, TCSADRAIN, &term_old);
 
 exit:
+    if (term)
+        hev_task_io_term_destroy (term);
+    if (fds[0] >= 0) {
+        close (fds[0]);
+        close (fds[1]);
+    }
     hev_object_unref (HEV_OBJECT (self));
 }
 
@@ -95,18 +270,18 @@ hev_fsh_client_term_connect_run (HevFshIO *base)
 }
 
 HevFshClientBase *
-hev_fsh_client_term_connect_new (HevFshConfig *config)
+hev_fsh_client_term_connect_new (HevFshConfig *config, HevFshContext *context)
 {
     HevFshClientTermConnect *self;
     int res;
 
-    self = hev_malloc0 (sizeof (HevFshClientTermConnect));
+    self = hev_object_pool_malloc0 (sizeof (HevFshClientTermConnect));
     if (!self)
         return NULL;
 
-    res = hev_fsh_client_term_connect_construct (self, config);
+    res = hev_fsh_client_term_connect_construct (self, config, context);
     if (res < 0) {
-        hev_free (self);
+        hev_object_pool_free (self);
         return NULL;
     }
 
@@ -117,17 +292,29 @@ hev_fsh_client_term_connect_new (HevFshConfig *config)
 
 int
 hev_fsh_client_term_connect_construct (HevFshClientTermConnect *self,
-                                       HevFshConfig *config)
+                                       HevFshConfig *config,
+                                       HevFshContext *context)
 {
     int res;
 
-    res = hev_fsh_client_connect_construct (&self->base, config);
+    res = hev_fsh_client_connect_construct (&self->base, config, context);
     if (res < 0)
         return res;
 
     LOG_D ("%p fsh client term connect construct", self);
 
     HEV_OBJECT (self)->klass = HEV_FSH_CLIENT_TERM_CONNECT_TYPE;
+    HEV_FSH_CLIENT_BASE (self)->nodelay = 1;
+
+    /* -e asks for the hello; otherwise only ride along on one sent anyway */
+    if (hev_fsh_config_get_predict (config)) {
+        HEV_FSH_CLIENT_BASE (self)->offer = HEV_FSH_HELLO_F_TERM_CTL;
+        HEV_FSH_CLIENT_BASE (self)->offer |= HEV_FSH_HELLO_F_TERM_RESUME;
+        HEV_FSH_CLIENT_BASE (self)->offer |= HEV_FSH_HELLO_F_TERM_ECHO;
+    } else if (hev_fsh_client_base_hello_needed (HEV_FSH_CLIENT_BASE (self))) {
+        HEV_FSH_CLIENT_BASE (self)->offer = HEV_FSH_HELLO_F_TERM_CTL;
+        HEV_FSH_CLIENT_BASE (self)->offer |= HEV_FSH_HELLO_F_TERM_RESUME;
+    }
 
     return 0;
 }
@@ -36,9 +36,11 @@ struct _HevFshClientTermConnectClass
 HevObjectClass *hev_fsh_client_term_connect_class (void);
 
 int hev_fsh_client_term_connect_construct (HevFshClientTermConnect *self,
-                                           HevFshConfig *config);
+                                           HevFshConfig *config,
+                                           HevFshContext *context);
 
-HevFshClientBase *hev_fsh_client_term_connect_new (HevFshConfig *config);
+HevFshClientBase *hev_fsh_client_term_connect_new (HevFshConfig *config,
+                                                   HevFshContext *context);
 
 #ifdef __cplusplus
 }
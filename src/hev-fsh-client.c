@@ -43,7 +43,7 @@ hev_fsh_client_reload (HevFshBase *base)
 }
 
 HevFshBase *
-hev_fsh_client_new (HevFshConfig *config)
+hev_fsh_client_new (HevFshConfig *config, HevFshContext *context)
 {
     HevFshClient *self;
     int res;
@@ -52,7 +52,7 @@ hev_fsh_client_new (HevFshConfig *config)
     if (!self)
         return NULL;
 
-    res = hev_fsh_client_construct (self, config);
+    res = hev_fsh_client_construct (self, config, context);
     if (res < 0) {
         hev_free (self);
         return NULL;
@@ -64,7 +64,8 @@ hev_fsh_client_new (HevFshConfig *config)
 }
 
 int
-hev_fsh_client_construct (HevFshClient *self, HevFshConfig *config)
+hev_fsh_client_construct (HevFshClient *self, HevFshConfig *config,
+                          HevFshContext *context)
 {
     int res;
 
@@ -76,7 +77,7 @@ hev_fsh_client_construct (HevFshClient *self, HevFshConfig *config)
 
     HEV_OBJECT (self)->klass = HEV_FSH_CLIENT_TYPE;
 
-    self->factory = hev_fsh_client_factory_new (config);
+    self->factory = hev_fsh_client_factory_new (config, context);
     if (!self->factory) {
         LOG_E ("%p fsh client factory", self);
         return -1;
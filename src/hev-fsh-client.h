@@ -12,6 +12,7 @@
 
 #include "hev-fsh-base.h"
 #include "hev-fsh-config.h"
+#include "hev-fsh-context.h"
 #include "hev-fsh-client-factory.h"
 
 #ifdef __cplusplus
@@ -39,9 +40,10 @@ struct _HevFshClientClass
 
 HevObjectClass *hev_fsh_client_class (void);
 
-int hev_fsh_client_construct (HevFshClient *self, HevFshConfig *config);
+int hev_fsh_client_construct (HevFshClient *self, HevFshConfig *config,
+                              HevFshContext *context);
 
-HevFshBase *hev_fsh_client_new (HevFshConfig *config);
+HevFshBase *hev_fsh_client_new (HevFshConfig *config, HevFshContext *context);
 
 #ifdef __cplusplus
 }
@@ -23,7 +23,6 @@
 #include "hev-memory-allocator.h"
 
 typedef struct _HevTaskCallResolv HevTaskCallResolv;
-typedef struct _HevFshAddrListNode HevFshAddrListNode;
 
 struct _HevFshConfig
 {
@@ -32,10 +31,20 @@ struct _HevFshConfig
     int ip_type;
     int log_level;
     int ugly_ktls;
+    int io_uring;
+    int relay;
+    int compress;
+    int predict;
+    int mptcp;
 
     const char *server_address;
     const char *server_port;
     unsigned int timeout;
+    unsigned int pool_size;
+    unsigned int buf_min;
+    unsigned int buf_max;
+    unsigned int streams;
+    unsigned int uring_tunnels;
 
     const char *user;
     const char *token;
@@ -43,8 +52,6 @@ struct _HevFshConfig
     const char *log_path;
     const char *tokens_file;
 
-    HevFshAddrListNode *addr_list;
-
     const char *local_address;
     unsigned int local_port;
 
@@ -62,17 +69,6 @@ struct _HevTaskCallResolv
     socklen_t *len;
 };
 
-struct _HevFshAddrListNode
-{
-    HevFshAddrListNode *next;
-
-    int type;
-    int action;
-
-    unsigned char addr[16];
-    unsigned int port;
-};
-
 HevFshConfig *
 hev_fsh_config_new (void)
 {
@@ -85,6 +81,11 @@ hev_fsh_config_new (void)
     }
 
     self->timeout = 120;
+    self->pool_size = 64;
+    self->buf_min = 8192;
+    self->buf_max = 262144;
+    self->streams = 1;
+    self->uring_tunnels = 64;
     self->server_port = "6339";
     self->local_address = "127.0.0.1";
 
@@ -94,15 +95,6 @@ hev_fsh_config_new (void)
 void
 hev_fsh_config_destroy (HevFshConfig *self)
 {
-    HevFshAddrListNode *iter = self->addr_list;
-
-    while (iter) {
-        HevFshAddrListNode *node = iter;
-
-        iter = iter->next;
-        hev_free (node);
-    }
-
     hev_free (self);
 }
 
@@ -259,6 +251,113 @@ hev_fsh_config_set_tcp_cc (HevFshConfig *self, const char *val)
     self->tcp_cc = val;
 }
 
+unsigned int
+hev_fsh_config_get_pool_size (HevFshConfig *self)
+{
+    return self->pool_size;
+}
+
+void
+hev_fsh_config_set_pool_size (HevFshConfig *self, unsigned int val)
+{
+    self->pool_size = val;
+}
+
+unsigned int
+hev_fsh_config_get_buf_min (HevFshConfig *self)
+{
+    return self->buf_min;
+}
+
+void
+hev_fsh_config_set_buf_min (HevFshConfig *self, unsigned int val)
+{
+    if (val < 1024)
+        val = 1024;
+
+    self->buf_min = val;
+    if (self->buf_max < val)
+        self->buf_max = val;
+}
+
+int
+hev_fsh_config_get_io_uring (HevFshConfig *self)
+{
+    return self->io_uring;
+}
+
+void
+hev_fsh_config_set_io_uring (HevFshConfig *self, int val)
+{
+    self->io_uring = val;
+}
+
+unsigned int
+hev_fsh_config_get_uring_tunnels (HevFshConfig *self)
+{
+    return self->uring_tunnels;
+}
+
+void
+hev_fsh_config_set_uring_tunnels (HevFshConfig *self, unsigned int val)
+{
+    if (val < 1)
+        val = 1;
+
+    self->uring_tunnels = val;
+}
+
+int
+hev_fsh_config_get_relay (HevFshConfig *self)
+{
+    return self->relay;
+}
+
+void
+hev_fsh_config_set_relay (HevFshConfig *self, int val)
+{
+    self->relay = val;
+}
+
+int
+hev_fsh_config_get_compress (HevFshConfig *self)
+{
+    return self->compress;
+}
+
+void
+hev_fsh_config_set_compress (HevFshConfig *self, int val)
+{
+    self->compress = val;
+}
+
+int
+hev_fsh_config_get_mptcp (HevFshConfig *self)
+{
+    return self->mptcp;
+}
+
+void
+hev_fsh_config_set_mptcp (HevFshConfig *self, int val)
+{
+    self->mptcp = val;
+}
+
+unsigned int
+hev_fsh_config_get_buf_max (HevFshConfig *self)
+{
+    return self->buf_max;
+}
+
+void
+hev_fsh_config_set_buf_max (HevFshConfig *self, unsigned int val)
+{
+    if (val < self->buf_min)
+        val = self->buf_min;
+
+    self->buf_max = val;
+}
+
 const char *
 hev_fsh_config_get_user (HevFshConfig *self)
 {
@@ -272,58 +371,27 @@ hev_fsh_config_set_user (HevFshConfig *self, const char *val)
 }
 
 int
-hev_fsh_config_addr_list_contains (HevFshConfig *self, int type, void *addr,
-                                   unsigned int port)
-{
-    HevFshAddrListNode *iter = self->addr_list;
-
-    while (iter) {
-        if (!iter->type)
-            return iter->action;
-
-        if (type == iter->type && port == iter->port) {
-            switch (type) {
-            case 4:
-                if (0 == memcmp (addr, iter->addr, 4))
-                    return iter->action;
-                break;
-            case 6:
-                if (0 == memcmp (addr, iter->addr, 16))
-                    return iter->action;
-                break;
-            }
-        }
-
-        iter = iter->next;
-    }
-
-    return 0;
+hev_fsh_config_get_predict (HevFshConfig *self)
+{
+    return self->predict;
 }
 
 void
-hev_fsh_config_addr_list_add (HevFshConfig *self, int type, void *addr,
-                              unsigned int port, int action)
+hev_fsh_config_set_predict (HevFshConfig *self, int val)
 {
-    HevFshAddrListNode *node;
-
-    node = hev_malloc0 (sizeof (HevFshAddrListNode));
-    if (!node)
-        return;
+    self->predict = val;
+}
 
-    node->type = type;
-    node->port = port;
-    node->action = action;
-    switch (type) {
-    case 4:
-        memcpy (node->addr, addr, 4);
-        break;
-    case 6:
-        memcpy (node->addr, addr, 16);
-        break;
-    }
+unsigned int
+hev_fsh_config_get_streams (HevFshConfig *self)
+{
+    return self->streams;
+}
 
-    node->next = self->addr_list;
-    self->addr_list = node;
+void
+hev_fsh_config_set_streams (HevFshConfig *self, unsigned int val)
+{
+    self->streams = val;
 }
 
 const char *
@@ -17,6 +17,7 @@
 typedef struct _HevFshConfig HevFshConfig;
 typedef struct _HevFshConfigKey HevFshConfigKey;
 typedef enum _HevFshConfigMode HevFshConfigMode;
+typedef enum _HevFshConfigCipher HevFshConfigCipher;
 
 enum _HevFshConfigMode
 {
@@ -32,9 +33,18 @@ enum _HevFshConfigMode
     HEV_FSH_CONFIG_MODE_CONNECTOR_SOCK = (1 << 2) | (1 << 1),
 };
 
+enum _HevFshConfigCipher
+{
+    HEV_FSH_CONFIG_CIPHER_AES_128_GCM = (1 << 0),
+    HEV_FSH_CONFIG_CIPHER_AES_256_GCM = (1 << 1),
+    HEV_FSH_CONFIG_CIPHER_CHACHA20_POLY1305 = (1 << 2),
+    HEV_FSH_CONFIG_CIPHER_ALL = (1 << 3) - 1,
+};
+
 struct _HevFshConfigKey
 {
-    unsigned char key[16];
+    unsigned char ciphers; /* 0: legacy key, AES-128-GCM only */
+    unsigned char key[32];
     unsigned char salt[4];
 };
 
@@ -76,15 +86,41 @@ void hev_fsh_config_set_key (HevFshConfig *self, HevFshConfigKey *val,
 const char *hev_fsh_config_get_tcp_cc (HevFshConfig *self);
 void hev_fsh_config_set_tcp_cc (HevFshConfig *self, const char *val);
 
+unsigned int hev_fsh_config_get_pool_size (HevFshConfig *self);
+void hev_fsh_config_set_pool_size (HevFshConfig *self, unsigned int val);
+
+unsigned int hev_fsh_config_get_buf_min (HevFshConfig *self);
+void hev_fsh_config_set_buf_min (HevFshConfig *self, unsigned int val);
+
+unsigned int hev_fsh_config_get_buf_max (HevFshConfig *self);
+void hev_fsh_config_set_buf_max (HevFshConfig *self, unsigned int val);
+
+int hev_fsh_config_get_io_uring (HevFshConfig *self);
+void hev_fsh_config_set_io_uring (HevFshConfig *self, int val);
+
+unsigned int hev_fsh_config_get_uring_tunnels (HevFshConfig *self);
+void hev_fsh_config_set_uring_tunnels (HevFshConfig *self, unsigned int val);
+
+int hev_fsh_config_get_relay (HevFshConfig *self);
+void hev_fsh_config_set_relay (HevFshConfig *self, int val);
+
+int hev_fsh_config_get_compress (HevFshConfig *self);
+void hev_fsh_config_set_compress (HevFshConfig *self, int val);
+
+int hev_fsh_config_get_mptcp (HevFshConfig *self);
+void hev_fsh_config_set_mptcp (HevFshConfig *self, int val);
+
 /* Forwarder terminal */
 const char *hev_fsh_config_get_user (HevFshConfig *self);
 void hev_fsh_config_set_user (HevFshConfig *self, const char *val);
 
-/* Forwarder port */
-int hev_fsh_config_addr_list_contains (HevFshConfig *self, int type, void *addr,
-                                       unsigned int port);
-void hev_fsh_config_addr_list_add (HevFshConfig *self, int type, void *addr,
-                                   unsigned int port, int action);
+/* Connector terminal */
+int hev_fsh_config_get_predict (HevFshConfig *self);
+void hev_fsh_config_set_predict (HevFshConfig *self, int val);
+
+/* Connector port */
+unsigned int hev_fsh_config_get_streams (HevFshConfig *self);
+void hev_fsh_config_set_streams (HevFshConfig *self, unsigned int val);
 
 /* Connector port | sock */
 const char *hev_fsh_config_get_local_address (HevFshConfig *self);
@@ -0,0 +1,143 @@
+/*
+ ============================================================================
+ Name        : hev-fsh-context.c
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Fsh client runtime context
+ ============================================================================
+ */
+
+#include <stdio.h>
+
+#include "hev-memory-allocator.h"
+
+#include "hev-fsh-context.h"
+
+struct _HevFshContext
+{
+    HevFshShellPool *shell_pool;
+    HevFshTermSessions *term_sessions;
+    HevFshAcl *acl;
+    HevFshUpstreamPool *upstream_pool;
+    HevFshDnsCache *dns_cache;
+    HevFshStripes *stripes;
+};
+
+HevFshContext *
+hev_fsh_context_new (void)
+{
+    HevFshContext *self;
+
+    self = hev_malloc0 (sizeof (HevFshContext));
+    if (!self) {
+        fprintf (stderr, "Create fsh context failed!\n");
+        return NULL;
+    }
+
+    return self;
+}
+
+void
+hev_fsh_context_destroy (HevFshContext *self)
+{
+    if (self->acl)
+        hev_fsh_acl_destroy (self->acl);
+    if (self->shell_pool)
+        hev_fsh_shell_pool_destroy (self->shell_pool);
+    if (self->term_sessions)
+        hev_fsh_term_sessions_destroy (self->term_sessions);
+    if (self->upstream_pool)
+        hev_fsh_upstream_pool_destroy (self->upstream_pool);
+    if (self->dns_cache)
+        hev_fsh_dns_cache_destroy (self->dns_cache);
+    if (self->stripes)
+        hev_fsh_stripes_destroy (self->stripes);
+
+    hev_free (self);
+}
+
+HevFshShellPool *
+hev_fsh_context_get_shell_pool (HevFshContext *self)
+{
+    return self->shell_pool;
+}
+
+void
+hev_fsh_context_set_shell_pool (HevFshContext *self, HevFshShellPool *val)
+{
+    if (self->shell_pool)
+        hev_fsh_shell_pool_destroy (self->shell_pool);
+    self->shell_pool = val;
+}
+
+HevFshTermSessions *
+hev_fsh_context_get_term_sessions (HevFshContext *self)
+{
+    return self->term_sessions;
+}
+
+void
+hev_fsh_context_set_term_sessions (HevFshContext *self,
+                                   HevFshTermSessions *val)
+{
+    if (self->term_sessions)
+        hev_fsh_term_sessions_destroy (self->term_sessions);
+    self->term_sessions = val;
+}
+
+HevFshAcl *
+hev_fsh_context_get_acl (HevFshContext *self)
+{
+    return self->acl;
+}
+
+void
+hev_fsh_context_set_acl (HevFshContext *self, HevFshAcl *val)
+{
+    if (self->acl)
+        hev_fsh_acl_destroy (self->acl);
+    self->acl = val;
+}
+
+HevFshUpstreamPool *
+hev_fsh_context_get_upstream_pool (HevFshContext *self)
+{
+    return self->upstream_pool;
+}
+
+void
+hev_fsh_context_set_upstream_pool (HevFshContext *self,
+                                   HevFshUpstreamPool *val)
+{
+    if (self->upstream_pool)
+        hev_fsh_upstream_pool_destroy (self->upstream_pool);
+    self->upstream_pool = val;
+}
+
+HevFshDnsCache *
+hev_fsh_context_get_dns_cache (HevFshContext *self)
+{
+    return self->dns_cache;
+}
+
+void
+hev_fsh_context_set_dns_cache (HevFshContext *self, HevFshDnsCache *val)
+{
+    if (self->dns_cache)
+        hev_fsh_dns_cache_destroy (self->dns_cache);
+    self->dns_cache = val;
+}
+
+HevFshStripes *
+hev_fsh_context_get_stripes (HevFshContext *self)
+{
+    return self->stripes;
+}
+
+void
+hev_fsh_context_set_stripes (HevFshContext *self, HevFshStripes *val)
+{
+    if (self->stripes)
+        hev_fsh_stripes_destroy (self->stripes);
+    self->stripes = val;
+}
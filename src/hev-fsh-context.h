@@ -0,0 +1,52 @@
+/*
+ ============================================================================
+ Name        : hev-fsh-context.h
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Fsh client runtime context
+ ============================================================================
+ */
+
+#ifndef __HEV_FSH_CONTEXT_H__
+#define __HEV_FSH_CONTEXT_H__
+
+#include "hev-fsh-acl.h"
+#include "hev-fsh-dns-cache.h"
+#include "hev-fsh-stripes.h"
+#include "hev-fsh-shell-pool.h"
+#include "hev-fsh-term-sessions.h"
+#include "hev-fsh-upstream-pool.h"
+
+typedef struct _HevFshContext HevFshContext;
+
+/*
+ * Objects shared by all clients of one instance, built by main from the
+ * config. It owns what is set: a setter destroys the one it replaces.
+ */
+HevFshContext *hev_fsh_context_new (void);
+void hev_fsh_context_destroy (HevFshContext *self);
+
+/* Forwarder terminal */
+HevFshShellPool *hev_fsh_context_get_shell_pool (HevFshContext *self);
+void hev_fsh_context_set_shell_pool (HevFshContext *self,
+                                     HevFshShellPool *val);
+HevFshTermSessions *hev_fsh_context_get_term_sessions (HevFshContext *self);
+void hev_fsh_context_set_term_sessions (HevFshContext *self,
+                                        HevFshTermSessions *val);
+
+/* Forwarder port */
+HevFshAcl *hev_fsh_context_get_acl (HevFshContext *self);
+void hev_fsh_context_set_acl (HevFshContext *self, HevFshAcl *val);
+HevFshUpstreamPool *hev_fsh_context_get_upstream_pool (HevFshContext *self);
+void hev_fsh_context_set_upstream_pool (HevFshContext *self,
+                                        HevFshUpstreamPool *val);
+
+/* Forwarder port | sock */
+HevFshDnsCache *hev_fsh_context_get_dns_cache (HevFshContext *self);
+void hev_fsh_context_set_dns_cache (HevFshContext *self, HevFshDnsCache *val);
+
+/* Port, both ends */
+HevFshStripes *hev_fsh_context_get_stripes (HevFshContext *self);
+void hev_fsh_context_set_stripes (HevFshContext *self, HevFshStripes *val);
+
+#endif /* __HEV_FSH_CONTEXT_H__ */
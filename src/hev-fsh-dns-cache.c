@@ -0,0 +1,387 @@
+/*
+ ============================================================================
+ Name        : hev-fsh-dns-cache.c
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Fsh forwarder DNS cache
+ ============================================================================
+ */
+
+#include <time.h>
+#include <netdb.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <netinet/in.h>
+
+#include <hev-task.h>
+#include <hev-task-dns.h>
+#include <hev-task-call.h>
+#include <hev-memory-allocator.h>
+
+#include "hev-logger.h"
+
+#include "hev-fsh-dns-cache.h"
+
+#define HEV_FSH_DNS_CACHE_BUCKETS (256)
+#define HEV_FSH_DNS_CACHE_SIZE (1024)
+
+typedef struct _HevFshDnsCacheEntry HevFshDnsCacheEntry;
+typedef struct _HevFshDnsCacheWaiter HevFshDnsCacheWaiter;
+typedef struct _HevTaskCallResolv HevTaskCallResolv;
+
+struct _HevFshDnsCacheEntry
+{
+    HevFshDnsCacheEntry *next;
+    HevFshDnsCacheWaiter *waiters;
+    unsigned int hash;
+    unsigned int pending;
+    int64_t expire;
+
+    /* 0: the name does not exist */
+    int count;
+    struct sockaddr_storage addrs[HEV_FSH_DNS_CACHE_ADDRS];
+
+    char name[256];
+};
+
+/* A lookup waiting for the query already out for its name. */
+struct _HevFshDnsCacheWaiter
+{
+    HevFshDnsCacheWaiter *next;
+    HevTask *task;
+
+    struct sockaddr_storage *addrs;
+    int max;
+    int count;
+    int done;
+};
+
+struct _HevFshDnsCache
+{
+    HevFshDnsCacheEntry *buckets[HEV_FSH_DNS_CACHE_BUCKETS];
+    unsigned int count;
+    unsigned int ttl;
+};
+
+struct _HevTaskCallResolv
+{
+    HevTaskCall base;
+
+    const char *name;
+    struct sockaddr_storage *addrs;
+    int count;
+};
+
+static int64_t
+hev_fsh_dns_cache_now (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static unsigned int
+hev_fsh_dns_cache_hash (const char *name)
+{
+    unsigned int hash = 2166136261u;
+
+    for (; *name; name++) {
+        unsigned char c = *name;
+
+        if (c >= 'A' && c <= 'Z')
+            c += 'a' - 'A';
+        hash = (hash ^ c) * 16777619u;
+    }
+
+    return hash;
+}
+
+HevFshDnsCache *
+hev_fsh_dns_cache_new (unsigned int ttl)
+{
+    HevFshDnsCache *self;
+
+    self = hev_malloc0 (sizeof (HevFshDnsCache));
+    if (!self)
+        return NULL;
+
+    LOG_D ("%p fsh dns cache new", self);
+
+    self->ttl = ttl;
+
+    return self;
+}
+
+void
+hev_fsh_dns_cache_destroy (HevFshDnsCache *self)
+{
+    int i;
+
+    LOG_D ("%p fsh dns cache destroy", self);
+
+    for (i = 0; i < HEV_FSH_DNS_CACHE_BUCKETS; i++) {
+        HevFshDnsCacheEntry *iter = self->buckets[i];
+
+        while (iter) {
+            HevFshDnsCacheEntry *entry = iter;
+
+            iter = iter->next;
+            hev_free (entry);
+        }
+    }
+
+    hev_free (self);
+}
+
+static void
+hev_fsh_dns_cache_purge (HevFshDnsCache *self, int64_t now)
+{
+    int i;
+
+    for (i = 0; i < HEV_FSH_DNS_CACHE_BUCKETS; i++) {
+        HevFshDnsCacheEntry **prev = &self->buckets[i];
+
+        while (*prev) {
+            HevFshDnsCacheEntry *entry = *prev;
+
+            if (entry->pending || entry->expire > now) {
+                prev = &entry->next;
+                continue;
+            }
+
+            *prev = entry->next;
+            hev_free (entry);
+            self->count--;
+        }
+    }
+}
+
+static void
+resolv_entry (HevTaskCall *call)
+{
+    HevTaskCallResolv *resolv = (HevTaskCallResolv *)call;
+    struct addrinfo *fams[2][HEV_FSH_DNS_CACHE_ADDRS];
+    struct addrinfo *res = NULL;
+    struct addrinfo *ai;
+    struct addrinfo hints;
+    int n[2] = { 0, 0 };
+    int i, k;
+    int s;
+
+    __builtin_bzero (&hints, sizeof (hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    hints.ai_flags = AI_ADDRCONFIG;
+
+    s = hev_task_dns_getaddrinfo (resolv->name, NULL, &hints, &res);
+    if ((s != 0) || !res) {
+        /* an answer too, that may be cached: no other failure is */
+#ifdef EAI_NODATA
+        if (s == EAI_NODATA)
+            s = EAI_NONAME;
+#endif
+        hev_task_call_set_retval (call, (s == EAI_NONAME) ? resolv : NULL);
+        return;
+    }
+
+    for (ai = res; ai; ai = ai->ai_next) {
+        if (ai->ai_family != AF_INET6 && ai->ai_family != AF_INET)
+            continue;
+
+        k = ai->ai_family != res->ai_family;
+        if (n[k] < HEV_FSH_DNS_CACHE_ADDRS)
+            fams[k][n[k]++] = ai;
+    }
+
+    /* Alternate families, leading with the resolver's first choice. */
+    for (i = 0; i < HEV_FSH_DNS_CACHE_ADDRS; i++) {
+        for (k = 0; k < 2; k++) {
+            if (i >= n[k] || resolv->count >= HEV_FSH_DNS_CACHE_ADDRS)
+                continue;
+
+            ai = fams[k][i];
+            memcpy (&resolv->addrs[resolv->count++], ai->ai_addr,
+                    ai->ai_addrlen);
+        }
+    }
+
+    freeaddrinfo (res);
+    hev_task_call_set_retval (call, resolv->addrs);
+}
+
+/* Returns the count, 0 if the name does not exist, or -1. */
+static int
+hev_fsh_dns_cache_resolve (const char *name, struct sockaddr_storage *addrs)
+{
+    HevTaskCallResolv *resolv;
+    HevTaskCall *call;
+    void *res;
+    int count;
+
+    call = hev_task_call_new (sizeof (HevTaskCallResolv), 16384);
+    if (!call)
+        return -1;
+
+    resolv = (HevTaskCallResolv *)call;
+    resolv->name = name;
+    resolv->addrs = addrs;
+    resolv->count = 0;
+
+    res = hev_task_call_jump (call, resolv_entry);
+    count = resolv->count;
+    hev_task_call_destroy (call);
+
+    if (!res)
+        return -1;
+
+    return count;
+}
+
+static HevFshDnsCacheEntry *
+hev_fsh_dns_cache_find (HevFshDnsCache *self, const char *name,
+                        unsigned int hash)
+{
+    HevFshDnsCacheEntry *entry;
+
+    entry = self->buckets[hash % HEV_FSH_DNS_CACHE_BUCKETS];
+    for (; entry; entry = entry->next) {
+        if (entry->hash == hash && strcasecmp (entry->name, name) == 0)
+            return entry;
+    }
+
+    return NULL;
+}
+
+static int
+hev_fsh_dns_cache_copy (struct sockaddr_storage *addrs, int max,
+                        const struct sockaddr_storage *res, int count)
+{
+    if (count <= 0)
+        return -1;
+
+    if (max > count)
+        max = count;
+    memcpy (addrs, res, sizeof (struct sockaddr_storage) * max);
+
+    return max;
+}
+
+static int
+hev_fsh_dns_cache_wait (HevFshDnsCacheEntry *entry,
+                        struct sockaddr_storage *addrs, int max)
+{
+    HevFshDnsCacheWaiter *waiter;
+    int count;
+
+    /* on the heap: the entry's list must not point into this frame */
+    waiter = hev_malloc (sizeof (HevFshDnsCacheWaiter));
+    if (!waiter)
+        return -1;
+
+    waiter->task = hev_task_self ();
+    waiter->addrs = addrs;
+    waiter->max = max;
+    waiter->done = 0;
+    waiter->next = entry->waiters;
+    entry->waiters = waiter;
+
+    /* the entry may be gone once done: the answer is copied here */
+    while (!waiter->done)
+        hev_task_yield (HEV_TASK_WAITIO);
+
+    count = waiter->count;
+    hev_free (waiter);
+
+    return count;
+}
+
+static HevFshDnsCacheEntry *
+hev_fsh_dns_cache_add (HevFshDnsCache *self, const char *name,
+                       unsigned int hash, int64_t now)
+{
+    HevFshDnsCacheEntry *entry;
+    unsigned int i = hash % HEV_FSH_DNS_CACHE_BUCKETS;
+
+    if (self->count >= HEV_FSH_DNS_CACHE_SIZE)
+        hev_fsh_dns_cache_purge (self, now);
+    if (self->count >= HEV_FSH_DNS_CACHE_SIZE)
+        return NULL;
+
+    entry = hev_malloc0 (sizeof (HevFshDnsCacheEntry));
+    if (!entry)
+        return NULL;
+
+    entry->hash = hash;
+    strcpy (entry->name, name);
+    entry->next = self->buckets[i];
+    self->buckets[i] = entry;
+    self->count++;
+
+    return entry;
+}
+
+int
+hev_fsh_dns_cache_lookup (HevFshDnsCache *self, const char *name,
+                          struct sockaddr_storage *addrs, int max)
+{
+    struct sockaddr_storage res[HEV_FSH_DNS_CACHE_ADDRS];
+    HevFshDnsCacheWaiter *waiter;
+    HevFshDnsCacheEntry *entry;
+    unsigned int hash;
+    int64_t now;
+    int count;
+
+    if (strlen (name) >= sizeof (entry->name))
+        return -1;
+
+    hash = hev_fsh_dns_cache_hash (name);
+    now = hev_fsh_dns_cache_now ();
+
+    entry = hev_fsh_dns_cache_find (self, name, hash);
+    if (entry && entry->pending)
+        return hev_fsh_dns_cache_wait (entry, addrs, max);
+    if (entry && entry->expire > now)
+        return hev_fsh_dns_cache_copy (addrs, max, entry->addrs,
+                                       entry->count);
+
+    LOG_D ("%p fsh dns cache miss %s", self, name);
+
+    /* lookups of the name from now on wait for this one */
+    if (!entry)
+        entry = hev_fsh_dns_cache_add (self, name, hash, now);
+    if (entry)
+        entry->pending = 1;
+
+    count = hev_fsh_dns_cache_resolve (name, res);
+    if (!entry)
+        return hev_fsh_dns_cache_copy (addrs, max, res, count);
+
+    now = hev_fsh_dns_cache_now ();
+    entry->pending = 0;
+    if (count > 0) {
+        entry->count = count;
+        entry->expire = now + self->ttl;
+        memcpy (entry->addrs, res, sizeof (struct sockaddr_storage) * count);
+    } else {
+        /* a failed query is retried by the next lookup */
+        entry->count = 0;
+        entry->expire = count ? now : now + HEV_FSH_DNS_CACHE_NEGATIVE_TTL;
+    }
+
+    for (waiter = entry->waiters; waiter;) {
+        HevFshDnsCacheWaiter *next = waiter->next;
+
+        waiter->count = hev_fsh_dns_cache_copy (waiter->addrs, waiter->max,
+                                                res, count);
+        waiter->done = 1;
+        hev_task_wakeup (waiter->task);
+        waiter = next;
+    }
+    entry->waiters = NULL;
+
+    return hev_fsh_dns_cache_copy (addrs, max, res, count);
+}
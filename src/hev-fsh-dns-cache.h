@@ -0,0 +1,33 @@
+/*
+ ============================================================================
+ Name        : hev-fsh-dns-cache.h
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Fsh forwarder DNS cache
+ ============================================================================
+ */
+
+#ifndef __HEV_FSH_DNS_CACHE_H__
+#define __HEV_FSH_DNS_CACHE_H__
+
+#include <sys/socket.h>
+
+#define HEV_FSH_DNS_CACHE_ADDRS (8)
+#define HEV_FSH_DNS_CACHE_TTL (60000)
+#define HEV_FSH_DNS_CACHE_NEGATIVE_TTL (10000)
+
+typedef struct _HevFshDnsCache HevFshDnsCache;
+
+HevFshDnsCache *hev_fsh_dns_cache_new (unsigned int ttl);
+void hev_fsh_dns_cache_destroy (HevFshDnsCache *self);
+
+/*
+ * Resolves name to at most max addresses with port 0, IPv6 and IPv4
+ * interleaved for happy eyeballs. Answers are kept for ttl ms, names that
+ * do not exist for HEV_FSH_DNS_CACHE_NEGATIVE_TTL; lookups of a name being
+ * resolved wait for that query. Returns the count, or -1.
+ */
+int hev_fsh_dns_cache_lookup (HevFshDnsCache *self, const char *name,
+                              struct sockaddr_storage *addrs, int max);
+
+#endif /* __HEV_FSH_DNS_CACHE_H__ */
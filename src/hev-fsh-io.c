@@ -12,6 +12,7 @@
 #include <hev-memory-allocator.h>
 
 #include "hev-logger.h"
+#include "hev-object-pool.h"
 #include "hev-fsh-config.h"
 
 #include "hev-fsh-io.h"
@@ -80,7 +81,7 @@ hev_fsh_io_destruct (HevObject *base)
     LOG_D ("%p fsh io destruct", self);
 
     HEV_OBJECT_TYPE->destruct (base);
-    hev_free (self);
+    hev_object_pool_free (self);
 }
 
 HevObjectClass *
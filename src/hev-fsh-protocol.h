@@ -11,12 +11,35 @@
 #define __HEV_FSH_PROTOCOL_H__
 
 #define HEV_FSH_TOKEN_STR_LEN 36
+#define HEV_FSH_HELLO_MAGIC "\xfe" "FSH"
+#define HEV_FSH_HELLO_VERSION 1
+#define HEV_FSH_HELLO_F_TLS13 (1 << 0)
+#define HEV_FSH_HELLO_F_LZ4 (1 << 1)
+#define HEV_FSH_HELLO_F_TERM_CTL (1 << 2)
+#define HEV_FSH_HELLO_F_TERM_RESUME (1 << 3)
+#define HEV_FSH_HELLO_F_TERM_ECHO (1 << 4)
+#define HEV_FSH_HELLO_F_SOCK_MUX (1 << 5)
+#define HEV_FSH_HELLO_F_STRIPE (1 << 6)
+#define HEV_FSH_PORT_INFO_NAME (1)
+
+/*
+ * Kinds of streams in a HEV_FSH_HELLO_F_SOCK_MUX tunnel. A STREAM starts at
+ * the SOCKS5 request: the connector has settled on no authentication with
+ * the client itself. A UDP stream carries the datagrams of an association,
+ * each a big-endian 16-bit length, then the SOCKS5 address (ATYP, address,
+ * port) and payload it covers.
+ */
+#define HEV_FSH_SOCK_MUX_STREAM (0)
+#define HEV_FSH_SOCK_MUX_UDP (1)
 
 typedef enum _HevFshCommand HevFshCommand;
 typedef struct _HevFshMessage HevFshMessage;
 typedef struct _HevFshMessageToken HevFshMessageToken;
 typedef struct _HevFshMessageTermInfo HevFshMessageTermInfo;
+typedef struct _HevFshMessageTermResume HevFshMessageTermResume;
 typedef struct _HevFshMessagePortInfo HevFshMessagePortInfo;
+typedef struct _HevFshMessageStripe HevFshMessageStripe;
+typedef struct _HevFshMessageHello HevFshMessageHello;
 typedef unsigned char HevFshToken[16];
 
 enum _HevFshCommand
@@ -45,6 +68,22 @@ struct _HevFshMessageTermInfo
     unsigned short columns;
 } __attribute__ ((packed));
 
+/*
+ * With HEV_FSH_HELLO_F_TERM_RESUME, sent by the connector after the term
+ * info: the session to resume (zero for a new one) and the data bytes of it
+ * received so far, big-endian. The forwarder answers in kind; a zero id
+ * there means the session is gone.
+ */
+struct _HevFshMessageTermResume
+{
+    HevFshToken id;
+    unsigned int offset;
+} __attribute__ ((packed));
+
+/*
+ * type is 4 or 6 for an address, or HEV_FSH_PORT_INFO_NAME: then addr[0] is
+ * the length of a host name that follows, for the forwarder to resolve.
+ */
 struct _HevFshMessagePortInfo
 {
     unsigned char type;
@@ -52,6 +91,32 @@ struct _HevFshMessagePortInfo
     unsigned char addr[16];
 } __attribute__ ((packed));
 
+/*
+ * With HEV_FSH_HELLO_F_STRIPE, sent by the connector first on each of the
+ * count connections of a port tunnel. Connection 0 goes on with the port
+ * info; from then on all of them carry chunks of the stream.
+ */
+struct _HevFshMessageStripe
+{
+    HevFshToken id;
+    unsigned char index;
+    unsigned char count;
+} __attribute__ ((packed));
+
+/*
+ * Optional, sent by the connector ahead of the key exchange and answered by
+ * the forwarder. Its magic cannot open a legacy stream: those start with a
+ * random IV, term info, port info (type 1, 4 or 6) or a socks5 greeting.
+ */
+struct _HevFshMessageHello
+{
+    unsigned char magic[4];
+    unsigned char ver;
+    unsigned char ciphers;
+    unsigned char cipher;
+    unsigned char flags;
+} __attribute__ ((packed));
+
 void hev_fsh_protocol_token_generate (HevFshToken token);
 void hev_fsh_protocol_token_to_string (HevFshToken token, char *out);
 
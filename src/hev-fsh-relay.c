@@ -0,0 +1,407 @@
+/*
+ ============================================================================
+ Name        : hev-fsh-relay.c
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Fsh relay
+ ============================================================================
+ */
+
+#define _GNU_SOURCE
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
+#include <hev-task.h>
+#include <hev-memory-allocator.h>
+
+#include "hev-logger.h"
+#include "hev-fsh-config.h"
+
+#include "hev-fsh-relay.h"
+
+#define HEV_FSH_RELAY_BATCH (256)
+#define HEV_FSH_RELAY_ROUNDS (16)
+
+#ifdef __linux__
+
+typedef struct _HevFshRelayDir HevFshRelayDir;
+
+struct _HevFshRelayDir
+{
+    int in;
+    int out;
+    int pfd[2];
+    size_t len;
+
+    unsigned int eof : 1;
+    unsigned int shut : 1;
+    unsigned int error : 1;
+};
+
+struct _HevFshRelayPair
+{
+    HevFshRelayPair *prev;
+    HevFshRelayPair *next;
+
+    HevTask *task;
+    int64_t active;
+    int fd_a;
+    int fd_b;
+
+    unsigned int busy : 1;
+    unsigned int done : 1;
+
+    HevFshRelayDir dirs[2];
+};
+
+static int64_t
+hev_fsh_relay_now (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int
+hev_fsh_relay_dir_init (HevFshRelayDir *d, int in, int out,
+                        unsigned int pipe_size)
+{
+    if (pipe2 (d->pfd, O_NONBLOCK | O_CLOEXEC) < 0)
+        return -1;
+
+    fcntl (d->pfd[1], F_SETPIPE_SZ, pipe_size);
+
+    d->in = in;
+    d->out = out;
+
+    return 0;
+}
+
+static void
+hev_fsh_relay_dir_fini (HevFshRelayDir *d)
+{
+    close (d->pfd[0]);
+    close (d->pfd[1]);
+}
+
+static int
+hev_fsh_relay_dir_run (HevFshRelay *self, HevFshRelayDir *d)
+{
+    int flags = SPLICE_F_MOVE | SPLICE_F_NONBLOCK;
+    int progress = 0;
+    int i;
+
+    for (i = 0; !d->error && i < HEV_FSH_RELAY_ROUNDS; i++) {
+        ssize_t s;
+        int step = 0;
+
+        if (!d->eof && d->len < self->pipe_size) {
+            s = splice (d->in, NULL, d->pfd[1], NULL, self->pipe_size - d->len,
+                        flags);
+            if (s > 0)
+                d->len += s;
+            else if (s == 0)
+                d->eof = 1;
+            else if (errno != EAGAIN)
+                d->error = 1;
+            step |= s >= 0;
+        }
+
+        if (d->len) {
+            s = splice (d->pfd[0], NULL, d->out, NULL, d->len, flags);
+            if (s > 0)
+                d->len -= s;
+            else if (s < 0 && errno != EAGAIN)
+                d->error = 1;
+            step |= s > 0;
+        }
+
+        if (!step)
+            break;
+        progress = 1;
+    }
+
+    if ((d->eof || d->error) && !d->len && !d->shut) {
+        shutdown (d->out, SHUT_WR);
+        d->shut = 1;
+    }
+
+    /* budget spent before EAGAIN: edge-triggered, so run again unasked */
+    if (i == HEV_FSH_RELAY_ROUNDS)
+        return 2;
+
+    return progress;
+}
+
+static void
+hev_fsh_relay_pair_finish (HevFshRelay *self, HevFshRelayPair *p)
+{
+    epoll_ctl (self->epfd, EPOLL_CTL_DEL, p->fd_a, NULL);
+    epoll_ctl (self->epfd, EPOLL_CTL_DEL, p->fd_b, NULL);
+
+    if (p->prev)
+        p->prev->next = p->next;
+    else
+        self->pairs = p->next;
+    if (p->next)
+        p->next->prev = p->prev;
+
+    p->done = 1;
+    hev_task_wakeup (p->task);
+}
+
+static void
+hev_fsh_relay_pair_run (HevFshRelay *self, HevFshRelayPair *p, int64_t now)
+{
+    int busy = 0;
+    int i;
+
+    for (i = 0; i < 2; i++) {
+        HevFshRelayDir *d = &p->dirs[i];
+        int res;
+
+        res = hev_fsh_relay_dir_run (self, d);
+        if (res)
+            p->active = now;
+        if (res == 2)
+            busy = 1;
+        if (d->error) {
+            hev_fsh_relay_pair_finish (self, p);
+            return;
+        }
+    }
+
+    p->busy = busy;
+    if (p->dirs[0].shut && p->dirs[1].shut)
+        hev_fsh_relay_pair_finish (self, p);
+}
+
+static int
+hev_fsh_relay_run_busy (HevFshRelay *self, int64_t now)
+{
+    HevFshRelayPair *p, *n;
+    int busy = 0;
+
+    for (p = self->pairs; p; p = n) {
+        n = p->next;
+        if (!p->busy)
+            continue;
+        hev_fsh_relay_pair_run (self, p, now);
+        busy |= !p->done && p->busy;
+    }
+
+    return busy;
+}
+
+static void
+hev_fsh_relay_scan (HevFshRelay *self, int64_t now)
+{
+    HevFshRelayPair *p, *n;
+
+    for (p = self->pairs; p; p = n) {
+        n = p->next;
+        if ((now - p->active) >= self->timeout) {
+            LOG_D ("%p fsh relay timeout %p", self, p);
+            hev_fsh_relay_pair_finish (self, p);
+        }
+    }
+}
+
+static void
+hev_fsh_relay_task_entry (void *data)
+{
+    struct epoll_event events[HEV_FSH_RELAY_BATCH];
+    HevFshRelay *self = data;
+    HevTask *task = hev_task_self ();
+    int64_t scan = hev_fsh_relay_now ();
+
+    hev_task_add_fd (task, self->epfd, POLLIN);
+
+    while (self->pairs) {
+        int64_t now;
+        int busy;
+        int i, n;
+
+        n = epoll_wait (self->epfd, events, HEV_FSH_RELAY_BATCH, 0);
+        now = hev_fsh_relay_now ();
+
+        /* a finished pair stays valid until its task runs again */
+        for (i = 0; i < n; i++) {
+            HevFshRelayPair *p = events[i].data.ptr;
+
+            if (!p->done)
+                hev_fsh_relay_pair_run (self, p, now);
+        }
+
+        busy = hev_fsh_relay_run_busy (self, now);
+
+        if ((now - scan) >= 1000) {
+            hev_fsh_relay_scan (self, now);
+            scan = now;
+        }
+
+        if (busy || n == HEV_FSH_RELAY_BATCH)
+            hev_task_yield (HEV_TASK_YIELD);
+        else if (self->pairs)
+            hev_task_sleep (1000);
+    }
+
+    hev_task_del_fd (task, self->epfd);
+    self->task = NULL;
+}
+
+void
+hev_fsh_relay_splice (HevFshRelay *self, int fd_a, int fd_b)
+{
+    HevTask *task = hev_task_self ();
+    struct epoll_event ev;
+    HevFshRelayPair p;
+
+    memset (&p, 0, sizeof (p));
+    p.task = task;
+    p.fd_a = fd_a;
+    p.fd_b = fd_b;
+    p.active = hev_fsh_relay_now ();
+
+    if (hev_fsh_relay_dir_init (&p.dirs[0], fd_a, fd_b, self->pipe_size) < 0)
+        return;
+    if (hev_fsh_relay_dir_init (&p.dirs[1], fd_b, fd_a, self->pipe_size) < 0)
+        goto exit;
+
+    /* only the relay task watches the pair from here on */
+    hev_task_del_fd (task, fd_a);
+    hev_task_del_fd (task, fd_b);
+
+    ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    ev.data.ptr = &p;
+    if (epoll_ctl (self->epfd, EPOLL_CTL_ADD, fd_a, &ev) < 0)
+        goto exit2;
+    if (epoll_ctl (self->epfd, EPOLL_CTL_ADD, fd_b, &ev) < 0) {
+        epoll_ctl (self->epfd, EPOLL_CTL_DEL, fd_a, NULL);
+        goto exit2;
+    }
+
+    p.next = self->pairs;
+    if (p.next)
+        p.next->prev = &p;
+    self->pairs = &p;
+
+    if (self->task) {
+        hev_task_wakeup (self->task);
+    } else {
+        self->task = hev_task_new (HEV_FSH_CONFIG_TASK_STACK_SIZE);
+        if (!self->task) {
+            hev_fsh_relay_pair_finish (self, &p);
+            goto exit2;
+        }
+        hev_task_run (self->task, hev_fsh_relay_task_entry, self);
+    }
+
+    while (!p.done)
+        hev_task_yield (HEV_TASK_WAITIO);
+
+exit2:
+    hev_fsh_relay_dir_fini (&p.dirs[1]);
+exit:
+    hev_fsh_relay_dir_fini (&p.dirs[0]);
+}
+
+#else /* !__linux__ */
+
+void
+hev_fsh_relay_splice (HevFshRelay *self, int fd_a, int fd_b)
+{
+}
+
+#endif /* __linux__ */
+
+HevFshRelay *
+hev_fsh_relay_new (unsigned int timeout, unsigned int pipe_size)
+{
+    HevFshRelay *self;
+    int res;
+
+    self = hev_malloc0 (sizeof (HevFshRelay));
+    if (!self)
+        return NULL;
+
+    res = hev_fsh_relay_construct (self, timeout, pipe_size);
+    if (res < 0) {
+        hev_free (self);
+        return NULL;
+    }
+
+    LOG_D ("%p fsh relay new", self);
+
+    return self;
+}
+
+int
+hev_fsh_relay_construct (HevFshRelay *self, unsigned int timeout,
+                         unsigned int pipe_size)
+{
+    int res;
+
+    res = hev_object_construct (&self->base);
+    if (res < 0)
+        return res;
+
+    LOG_D ("%p fsh relay construct", self);
+
+    HEV_OBJECT (self)->klass = HEV_FSH_RELAY_TYPE;
+
+#ifdef __linux__
+    self->epfd = epoll_create1 (EPOLL_CLOEXEC);
+#else
+    self->epfd = -1;
+#endif
+    if (self->epfd < 0) {
+        LOG_E ("%p fsh relay epoll", self);
+        return -1;
+    }
+
+    self->timeout = timeout * 1000;
+    self->pipe_size = pipe_size;
+
+    return 0;
+}
+
+static void
+hev_fsh_relay_destruct (HevObject *base)
+{
+    HevFshRelay *self = HEV_FSH_RELAY (base);
+
+    LOG_D ("%p fsh relay destruct", self);
+
+    close (self->epfd);
+
+    HEV_OBJECT_TYPE->destruct (base);
+    hev_free (self);
+}
+
+HevObjectClass *
+hev_fsh_relay_class (void)
+{
+    static HevFshRelayClass klass;
+    HevFshRelayClass *kptr = &klass;
+    HevObjectClass *okptr = HEV_OBJECT_CLASS (kptr);
+
+    if (!okptr->name) {
+        memcpy (kptr, HEV_OBJECT_TYPE, sizeof (HevObjectClass));
+
+        okptr->name = "HevFshRelay";
+        okptr->destruct = hev_fsh_relay_destruct;
+    }
+
+    return okptr;
+}
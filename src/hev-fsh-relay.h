@@ -0,0 +1,64 @@
+/*
+ ============================================================================
+ Name        : hev-fsh-relay.h
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Fsh relay
+ ============================================================================
+ */
+
+#ifndef __HEV_FSH_RELAY_H__
+#define __HEV_FSH_RELAY_H__
+
+#include <hev-task.h>
+
+#include "hev-object.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HEV_FSH_RELAY(p) ((HevFshRelay *)p)
+#define HEV_FSH_RELAY_CLASS(p) ((HevFshRelayClass *)p)
+#define HEV_FSH_RELAY_TYPE (hev_fsh_relay_class ())
+
+typedef struct _HevFshRelay HevFshRelay;
+typedef struct _HevFshRelayPair HevFshRelayPair;
+typedef struct _HevFshRelayClass HevFshRelayClass;
+
+struct _HevFshRelay
+{
+    HevObject base;
+
+    int epfd;
+    unsigned int timeout;
+    unsigned int pipe_size;
+
+    HevTask *task;
+    HevFshRelayPair *pairs;
+};
+
+struct _HevFshRelayClass
+{
+    HevObjectClass base;
+};
+
+HevObjectClass *hev_fsh_relay_class (void);
+
+int hev_fsh_relay_construct (HevFshRelay *self, unsigned int timeout,
+                             unsigned int pipe_size);
+
+HevFshRelay *hev_fsh_relay_new (unsigned int timeout, unsigned int pipe_size);
+
+/*
+ * Splice fd_a and fd_b until both directions are closed or idle for longer
+ * than the relay timeout. The calling task sleeps meanwhile: all pairs are
+ * driven by the relay task straight from one epoll batch.
+ */
+void hev_fsh_relay_splice (HevFshRelay *self, int fd_a, int fd_b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HEV_FSH_RELAY_H__ */
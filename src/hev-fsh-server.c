@@ -7,6 +7,7 @@
  ============================================================================
  */
 
+#include <errno.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -19,25 +20,43 @@
 #include <hev-memory-allocator.h>
 
 #include "hev-logger.h"
+#include "hev-task-io-uring.h"
 #include "hev-fsh-session.h"
 
 #include "hev-fsh-server.h"
 
+#ifndef IPPROTO_MPTCP
+#define IPPROTO_MPTCP 262
+#endif
+
 static void
 hev_fsh_server_task_entry (void *data)
 {
     HevFshServer *self = HEV_FSH_SERVER (data);
-    unsigned int timeout;
+    HevTaskIOUringAccept *ua = NULL;
 
-    timeout = hev_fsh_config_get_timeout (self->config);
-    hev_task_add_fd (hev_task_self (), self->fd, POLLIN);
+    if (hev_task_io_uring_enabled ())
+        ua = hev_task_io_uring_accept_new (self->fd);
+    if (!ua)
+        hev_task_add_fd (hev_task_self (), self->fd, POLLIN);
 
     for (;;) {
         HevFshSession *s;
         const char *cc;
         int fd;
 
-        fd = hev_task_io_socket_accept (self->fd, NULL, NULL, NULL, NULL);
+        if (ua) {
+            fd = hev_task_io_uring_accept (ua);
+            if (fd == -EINVAL) {
+                LOG_W ("%p fsh server multishot accept", self);
+                hev_task_io_uring_accept_destroy (ua);
+                hev_task_add_fd (hev_task_self (), self->fd, POLLIN);
+                ua = NULL;
+                continue;
+            }
+        } else {
+            fd = hev_task_io_socket_accept (self->fd, NULL, NULL, NULL, NULL);
+        }
         if (fd < 0) {
             LOG_W ("%p fsh server accept", self);
             continue;
@@ -53,7 +72,8 @@ hev_fsh_server_task_entry (void *data)
 #endif
         }
 
-        s = hev_fsh_session_new (fd, timeout, self->t_mgr, self->s_mgr);
+        s = hev_fsh_session_new (fd, self->config, self->relay, self->t_mgr,
+                                 self->s_mgr);
         if (!s) {
             close (fd);
             continue;
@@ -138,7 +158,16 @@ hev_fsh_server_socket (HevFshServer *self, HevFshConfig *config)
         return -1;
     }
 
-    fd = hev_task_io_socket_socket (addr->sa_family, SOCK_STREAM, IPPROTO_TCP);
+    fd = -1;
+#ifdef __linux__
+    /* subflows join on any path; plain TCP peers are still accepted */
+    if (hev_fsh_config_get_mptcp (config))
+        fd = hev_task_io_socket_socket (addr->sa_family, SOCK_STREAM,
+                                        IPPROTO_MPTCP);
+#endif
+    if (fd < 0)
+        fd = hev_task_io_socket_socket (addr->sa_family, SOCK_STREAM,
+                                        IPPROTO_TCP);
     if (fd < 0) {
         LOG_E ("%p fsh server socket socket", self);
         return -1;
@@ -233,6 +262,16 @@ hev_fsh_server_construct (HevFshServer *self, HevFshConfig *config)
         }
     }
 
+    if (hev_fsh_config_get_relay (config)) {
+        unsigned int timeout = hev_fsh_config_get_timeout (config);
+        unsigned int size = hev_fsh_config_get_buf_min (config);
+
+        /* optional: sessions splice on their own tasks without it */
+        self->relay = hev_fsh_relay_new (timeout, size);
+        if (!self->relay)
+            LOG_W ("%p fsh server relay", self);
+    }
+
     self->config = config;
 
     return 0;
@@ -245,6 +284,8 @@ hev_fsh_server_destruct (HevObject *base)
 
     LOG_D ("%p fsh server destruct", self);
 
+    if (self->relay)
+        hev_object_unref (HEV_OBJECT (self->relay));
     hev_object_unref (HEV_OBJECT (self->s_mgr));
     if (self->t_mgr)
         hev_object_unref (HEV_OBJECT (self->t_mgr));
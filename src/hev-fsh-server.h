@@ -13,6 +13,7 @@
 #include <hev-task.h>
 
 #include "hev-fsh-base.h"
+#include "hev-fsh-relay.h"
 #include "hev-fsh-config.h"
 #include "hev-fsh-token-manager.h"
 #include "hev-fsh-session-manager.h"
@@ -38,6 +39,7 @@ struct _HevFshServer
 
     HevTask *main_task;
     HevTask *event_task;
+    HevFshRelay *relay;
     HevFshConfig *config;
     HevFshTokenManager *t_mgr;
     HevFshSessionManager *s_mgr;
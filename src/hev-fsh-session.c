@@ -18,6 +18,8 @@
 #include <hev-memory-allocator.h>
 
 #include "hev-logger.h"
+#include "hev-object-pool.h"
+#include "hev-task-io-uring.h"
 #include "hev-compiler.h"
 #include "hev-fsh-config.h"
 
@@ -167,6 +169,7 @@ static void
 hev_fsh_session_splice (HevFshSession *self)
 {
     unsigned timeout = self->base.timeout;
+    size_t buf_size;
 
     /* wait for accept */
     while (timeout) {
@@ -175,8 +178,21 @@ hev_fsh_session_splice (HevFshSession *self)
         timeout = hev_task_sleep (timeout);
     }
 
+    if (self->relay) {
+        hev_fsh_relay_splice (self->relay, self->client_fd, self->remote_fd);
+        return;
+    }
+
+    if (hev_task_io_uring_enabled ()) {
+        hev_task_io_uring_splice (self->client_fd, self->client_fd,
+                                  self->remote_fd, self->remote_fd, io_yielder,
+                                  self);
+        return;
+    }
+
+    buf_size = hev_fsh_config_get_buf_min (self->config);
     hev_task_io_splice (self->client_fd, self->client_fd, self->remote_fd,
-                        self->remote_fd, 8192, io_yielder, self);
+                        self->remote_fd, buf_size, io_yielder, self);
 }
 
 static int
@@ -344,19 +360,19 @@ hev_fsh_session_run (HevFshIO *base)
 }
 
 HevFshSession *
-hev_fsh_session_new (int fd, unsigned int timeout, HevFshTokenManager *t_mgr,
-                     HevFshSessionManager *s_mgr)
+hev_fsh_session_new (int fd, HevFshConfig *config, HevFshRelay *relay,
+                     HevFshTokenManager *t_mgr, HevFshSessionManager *s_mgr)
 {
     HevFshSession *self;
     int res;
 
-    self = hev_malloc0 (sizeof (HevFshSession));
+    self = hev_object_pool_malloc0 (sizeof (HevFshSession));
     if (!self)
         return NULL;
 
-    res = hev_fsh_session_construct (self, fd, timeout, t_mgr, s_mgr);
+    res = hev_fsh_session_construct (self, fd, config, relay, t_mgr, s_mgr);
     if (res < 0) {
-        hev_free (self);
+        hev_object_pool_free (self);
         return NULL;
     }
 
@@ -366,12 +382,14 @@ hev_fsh_session_new (int fd, unsigned int timeout, HevFshTokenManager *t_mgr,
 }
 
 int
-hev_fsh_session_construct (HevFshSession *self, int fd, unsigned int timeout,
-                           HevFshTokenManager *t_mgr,
+hev_fsh_session_construct (HevFshSession *self, int fd, HevFshConfig *config,
+                           HevFshRelay *relay, HevFshTokenManager *t_mgr,
                            HevFshSessionManager *s_mgr)
 {
+    unsigned int timeout;
     int res;
 
+    timeout = hev_fsh_config_get_timeout (config);
     res = hev_fsh_io_construct (&self->base, timeout);
     if (res < 0)
         return res;
@@ -382,6 +400,8 @@ hev_fsh_session_construct (HevFshSession *self, int fd, unsigned int timeout,
 
     self->client_fd = fd;
     self->remote_fd = -1;
+    self->relay = relay;
+    self->config = config;
     self->t_mgr = t_mgr;
     self->s_mgr = s_mgr;
 
@@ -15,6 +15,8 @@
 
 #include "hev-rbtree.h"
 #include "hev-fsh-io.h"
+#include "hev-fsh-config.h"
+#include "hev-fsh-relay.h"
 #include "hev-fsh-protocol.h"
 #include "hev-fsh-token-manager.h"
 #include "hev-fsh-session-manager.h"
@@ -45,6 +47,8 @@ struct _HevFshSession
     HevTaskMutex wlock;
     HevRBTreeNode node;
 
+    HevFshRelay *relay;
+    HevFshConfig *config;
     HevFshTokenManager *t_mgr;
     HevFshSessionManager *s_mgr;
 };
@@ -57,10 +61,12 @@ struct _HevFshSessionClass
 HevObjectClass *hev_fsh_session_class (void);
 
 int hev_fsh_session_construct (HevFshSession *self, int fd,
-                               unsigned int timeout, HevFshTokenManager *t_mgr,
+                               HevFshConfig *config, HevFshRelay *relay,
+                               HevFshTokenManager *t_mgr,
                                HevFshSessionManager *s_mgr);
 
-HevFshSession *hev_fsh_session_new (int fd, unsigned int timeout,
+HevFshSession *hev_fsh_session_new (int fd, HevFshConfig *config,
+                                    HevFshRelay *relay,
                                     HevFshTokenManager *t_mgr,
                                     HevFshSessionManager *s_mgr);
 
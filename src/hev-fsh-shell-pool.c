@@ -0,0 +1,467 @@
+/*
+ ============================================================================
+ Name        : hev-fsh-shell-pool.c
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Fsh forwarder pre-spawned shell pool
+ ============================================================================
+ */
+
+#define _GNU_SOURCE
+#include <pwd.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#elif defined(__APPLE__) || (__MACH__)
+#include <util.h>
+#else
+#include <termios.h>
+#include <libutil.h>
+#endif
+
+#include <hev-task.h>
+#include <hev-task-call.h>
+#include <hev-memory-allocator.h>
+
+#include "hev-logger.h"
+#include "hev-fsh-config.h"
+
+#include "hev-fsh-shell-pool.h"
+
+/* how often idle shells are checked for having exited (login timeout) */
+#define HEV_FSH_SHELL_POOL_CHECK (10000)
+#define HEV_FSH_SHELL_POOL_RETRY (1000)
+
+#define SPAWN_STACK_SIZE (16384)
+
+typedef struct _HevTaskCallSpawn HevTaskCallSpawn;
+
+struct _HevFshShellPool
+{
+    HevTask *task;
+    const char *user;
+
+    unsigned int size;
+    unsigned int head;
+    unsigned int count;
+
+    int fds[HEV_FSH_SHELL_POOL_SIZE_MAX];
+};
+
+struct _HevTaskCallSpawn
+{
+    HevTaskCall base;
+
+    int ids;
+    uid_t uid;
+    gid_t gid;
+#if defined(__linux__)
+    const char *tty;
+    char **envp;
+#else
+    int pfd;
+#endif
+    char **argv;
+};
+
+#if defined(__linux__)
+/* the 16-bit id calls of old ABIs got 32-bit twins */
+#ifdef SYS_setresuid32
+#define SYS_SETGROUPS SYS_setgroups32
+#define SYS_SETRESGID SYS_setresgid32
+#define SYS_SETRESUID SYS_setresuid32
+#else
+#define SYS_SETGROUPS SYS_setgroups
+#define SYS_SETRESGID SYS_setresgid
+#define SYS_SETRESUID SYS_setresuid
+#endif
+
+static int
+spawn_child (void *data)
+{
+    HevTaskCallSpawn *spawn = data;
+    struct sigaction sa;
+    sigset_t set;
+    int fd;
+    int i;
+
+    /*
+     * Memory is shared with the parent until exec: syscalls only. The libc
+     * set*id wrappers would sync the ids across the parent's threads.
+     */
+    sa.sa_handler = SIG_DFL;
+    sa.sa_flags = 0;
+    sigemptyset (&sa.sa_mask);
+    for (i = 1; i < NSIG; i++)
+        sigaction (i, &sa, NULL);
+    sigemptyset (&set);
+    sigprocmask (SIG_SETMASK, &set, NULL);
+
+    setsid ();
+    fd = open (spawn->tty, O_RDWR);
+    if (fd < 0)
+        _exit (127);
+    ioctl (fd, TIOCSCTTY, 0);
+    dup2 (fd, 0);
+    dup2 (fd, 1);
+    dup2 (fd, 2);
+    if (fd > 2)
+        close (fd);
+
+    if (spawn->ids) {
+        gid_t gid = spawn->gid;
+        uid_t uid = spawn->uid;
+
+        if (syscall (SYS_SETGROUPS, 1, &gid) < 0 ||
+            syscall (SYS_SETRESGID, gid, gid, gid) < 0 ||
+            syscall (SYS_SETRESUID, uid, uid, uid) < 0)
+            _exit (127);
+    }
+
+    execve (spawn->argv[0], spawn->argv, spawn->envp);
+    _exit (127);
+}
+
+static int
+spawn_ids (HevTaskCallSpawn *spawn, const char *user)
+{
+    static const char *cached;
+    static uid_t uid;
+    static gid_t gid;
+
+    if (user != cached) {
+        struct passwd *pwd;
+
+        pwd = getpwnam (user);
+        if (!pwd)
+            return -1;
+
+        uid = pwd->pw_uid;
+        gid = pwd->pw_gid;
+        cached = user;
+    }
+
+    spawn->ids = 1;
+    spawn->uid = uid;
+    spawn->gid = gid;
+
+    return 0;
+}
+
+static char **
+spawn_envp (void)
+{
+    static char term[] = "TERM=linux";
+    char **envp;
+    int n;
+
+    for (n = 0; environ[n]; n++)
+        ;
+
+    envp = hev_malloc (sizeof (char *) * (n + 2));
+    if (!envp)
+        return NULL;
+
+    memcpy (envp, environ, sizeof (char *) * n);
+    if (!getenv ("TERM"))
+        envp[n++] = term;
+    envp[n] = NULL;
+
+    return envp;
+}
+
+static void
+spawn_entry (HevTaskCall *call)
+{
+    HevTaskCallSpawn *spawn = (HevTaskCallSpawn *)call;
+    sigset_t set, old;
+    void *stack;
+    pid_t pid;
+
+    stack = hev_malloc (SPAWN_STACK_SIZE);
+    if (!stack) {
+        hev_task_call_set_retval (call, NULL);
+        return;
+    }
+
+    /* no handler of ours may run on the child before it is reset */
+    sigfillset (&set);
+    sigprocmask (SIG_SETMASK, &set, &old);
+    /* no page tables copied: we are back as soon as it execs */
+    pid = clone (spawn_child, (char *)stack + SPAWN_STACK_SIZE,
+                 CLONE_VM | CLONE_VFORK | SIGCHLD, spawn);
+    sigprocmask (SIG_SETMASK, &old, NULL);
+
+    hev_free (stack);
+    hev_task_call_set_retval (call, (pid < 0) ? NULL : spawn);
+}
+
+static int
+spawn_pty (HevTaskCallSpawn *spawn, char *tty, size_t len)
+{
+    int fd;
+
+    fd = posix_openpt (O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+
+    if (grantpt (fd) < 0 || unlockpt (fd) < 0 || ptsname_r (fd, tty, len)) {
+        close (fd);
+        return -1;
+    }
+
+    spawn->tty = tty;
+
+    return fd;
+}
+#else
+static void
+exec_shell (HevTaskCallSpawn *spawn)
+{
+    if (spawn->ids) {
+        if (setgid (spawn->gid) < 0 || setuid (spawn->uid) < 0)
+            exit (127);
+    } else if (getuid () == 0) {
+        setsid ();
+    }
+
+    if (!getenv ("TERM"))
+        setenv ("TERM", "linux", 1);
+
+    execl (spawn->argv[0], spawn->argv[0], NULL);
+    exit (0);
+}
+
+static void
+spawn_entry (HevTaskCall *call)
+{
+    HevTaskCallSpawn *spawn = (HevTaskCallSpawn *)call;
+    pid_t pid;
+
+    pid = forkpty (&spawn->pfd, NULL, NULL, NULL);
+    if (pid < 0)
+        hev_task_call_set_retval (call, NULL);
+    else if (pid == 0)
+        exec_shell (spawn);
+    else
+        hev_task_call_set_retval (call, spawn);
+}
+
+static int
+spawn_ids (HevTaskCallSpawn *spawn, const char *user)
+{
+    struct passwd *pwd;
+
+    pwd = getpwnam (user);
+    if (!pwd)
+        return -1;
+
+    spawn->ids = 1;
+    spawn->uid = pwd->pw_uid;
+    spawn->gid = pwd->pw_gid;
+
+    return 0;
+}
+#endif
+
+int
+hev_fsh_shell_pool_spawn (const char *user)
+{
+    HevTaskCallSpawn *spawn;
+    HevTaskCall *call;
+    char *argv[2];
+    void *ptr;
+    int pfd = -1;
+#if defined(__linux__)
+    char tty[64];
+#endif
+
+    call = hev_task_call_new (sizeof (HevTaskCallSpawn), 16384);
+    if (!call)
+        return -1;
+
+    spawn = (HevTaskCallSpawn *)call;
+    spawn->argv = argv;
+    argv[0] = "/bin/bash";
+    argv[1] = NULL;
+
+    if (access (argv[0], X_OK) < 0)
+        argv[0] = "/bin/sh";
+
+    if (getuid () == 0) {
+        if (!user)
+            argv[0] = "/bin/login";
+        else if (spawn_ids (spawn, user) < 0)
+            goto exit;
+    }
+
+#if defined(__linux__)
+    spawn->envp = spawn_envp ();
+    if (!spawn->envp)
+        goto exit;
+
+    pfd = spawn_pty (spawn, tty, sizeof (tty));
+    if (pfd >= 0) {
+        ptr = hev_task_call_jump (call, spawn_entry);
+        if (!ptr) {
+            close (pfd);
+            pfd = -1;
+        }
+    }
+
+    hev_free (spawn->envp);
+#else
+    ptr = hev_task_call_jump (call, spawn_entry);
+    if (ptr) {
+        pfd = spawn->pfd;
+        /* shells forked later must not hold on to this one's master */
+        if (fcntl (pfd, F_SETFL, O_NONBLOCK) < 0 ||
+            fcntl (pfd, F_SETFD, FD_CLOEXEC) < 0) {
+            close (pfd);
+            pfd = -1;
+        }
+    }
+#endif
+
+exit:
+    hev_task_call_destroy (call);
+    if (pfd < 0)
+        LOG_E ("fsh shell pool spawn %s", argv[0]);
+
+    return pfd;
+}
+
+static int
+hev_fsh_shell_pool_alive (int fd)
+{
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+
+    /* the master hangs up once the shell and all it started are gone */
+    if (poll (&pfd, 1, 0) < 0)
+        return 0;
+
+    return !(pfd.revents & (POLLHUP | POLLERR | POLLNVAL));
+}
+
+static void
+hev_fsh_shell_pool_sweep (HevFshShellPool *self)
+{
+    unsigned int i, n = 0;
+
+    for (i = 0; i < self->count; i++) {
+        unsigned int j = (self->head + i) % HEV_FSH_SHELL_POOL_SIZE_MAX;
+        unsigned int k = (self->head + n) % HEV_FSH_SHELL_POOL_SIZE_MAX;
+
+        if (hev_fsh_shell_pool_alive (self->fds[j])) {
+            self->fds[k] = self->fds[j];
+            n++;
+        } else {
+            close (self->fds[j]);
+        }
+    }
+
+    self->count = n;
+}
+
+static void
+hev_fsh_shell_pool_task_entry (void *data)
+{
+    HevFshShellPool *self = data;
+
+    for (;;) {
+        unsigned int i;
+        int fd;
+
+        hev_fsh_shell_pool_sweep (self);
+
+        if (self->count == self->size) {
+            hev_task_sleep (HEV_FSH_SHELL_POOL_CHECK);
+            continue;
+        }
+
+        fd = hev_fsh_shell_pool_spawn (self->user);
+        if (fd < 0) {
+            hev_task_sleep (HEV_FSH_SHELL_POOL_RETRY);
+            continue;
+        }
+
+        i = (self->head + self->count) % HEV_FSH_SHELL_POOL_SIZE_MAX;
+        self->fds[i] = fd;
+        self->count++;
+    }
+}
+
+HevFshShellPool *
+hev_fsh_shell_pool_new (const char *user, unsigned int size)
+{
+    HevFshShellPool *self;
+
+    self = hev_malloc0 (sizeof (HevFshShellPool));
+    if (!self)
+        return NULL;
+
+    self->task = hev_task_new (HEV_FSH_CONFIG_TASK_STACK_SIZE);
+    if (!self->task) {
+        hev_free (self);
+        return NULL;
+    }
+
+    LOG_D ("%p fsh shell pool new", self);
+
+    if (size > HEV_FSH_SHELL_POOL_SIZE_MAX)
+        size = HEV_FSH_SHELL_POOL_SIZE_MAX;
+
+    self->user = user;
+    self->size = size;
+
+    hev_task_run (self->task, hev_fsh_shell_pool_task_entry, self);
+
+    return self;
+}
+
+void
+hev_fsh_shell_pool_destroy (HevFshShellPool *self)
+{
+    LOG_D ("%p fsh shell pool destroy", self);
+
+    while (self->count) {
+        close (self->fds[self->head]);
+        self->head = (self->head + 1) % HEV_FSH_SHELL_POOL_SIZE_MAX;
+        self->count--;
+    }
+
+    hev_free (self);
+}
+
+int
+hev_fsh_shell_pool_get (HevFshShellPool *self)
+{
+    int fd = -1;
+
+    while (self->count) {
+        int i = self->head;
+
+        self->head = (i + 1) % HEV_FSH_SHELL_POOL_SIZE_MAX;
+        self->count--;
+
+        if (hev_fsh_shell_pool_alive (self->fds[i])) {
+            fd = self->fds[i];
+            break;
+        }
+
+        close (self->fds[i]);
+    }
+
+    hev_task_wakeup (self->task);
+
+    LOG_D ("%p fsh shell pool %s", self, (fd < 0) ? "miss" : "hit");
+
+    return fd;
+}
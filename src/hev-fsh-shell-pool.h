@@ -0,0 +1,36 @@
+/*
+ ============================================================================
+ Name        : hev-fsh-shell-pool.h
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Fsh forwarder pre-spawned shell pool
+ ============================================================================
+ */
+
+#ifndef __HEV_FSH_SHELL_POOL_H__
+#define __HEV_FSH_SHELL_POOL_H__
+
+#define HEV_FSH_SHELL_POOL_SIZE_MAX (16)
+
+typedef struct _HevFshShellPool HevFshShellPool;
+
+/*
+ * Keeps size shells for user (NULL: the caller's, or /bin/login as root)
+ * running on ptys of their own, ready to be handed to a terminal session.
+ */
+HevFshShellPool *hev_fsh_shell_pool_new (const char *user, unsigned int size);
+void hev_fsh_shell_pool_destroy (HevFshShellPool *self);
+
+/*
+ * Returns the non-blocking pty master of a live shell, or -1 on a miss.
+ * Either way the pool is refilled in the background.
+ */
+int hev_fsh_shell_pool_get (HevFshShellPool *self);
+
+/*
+ * Forks a shell for user on a new pty, off the task stack. Returns its
+ * non-blocking pty master, or -1.
+ */
+int hev_fsh_shell_pool_spawn (const char *user);
+
+#endif /* __HEV_FSH_SHELL_POOL_H__ */
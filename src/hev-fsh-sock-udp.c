@@ -0,0 +1,716 @@
+/*
+ ============================================================================
+ Name        : hev-fsh-sock-udp.c
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Fsh SOCKS5 UDP relay
+ ============================================================================
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+
+#include <hev-task.h>
+#include <hev-memory-allocator.h>
+
+#include "hev-logger.h"
+
+#include "hev-fsh-sock-udp.h"
+
+/* ATYP, a name of up to 255 bytes with its length, port */
+#define HEV_FSH_SOCK_UDP_ADDR_MAX (1 + 1 + 255 + 2)
+#define HEV_FSH_SOCK_UDP_FRAME_MAX \
+    (2 + HEV_FSH_SOCK_UDP_ADDR_MAX + HEV_FSH_SOCK_UDP_PAYLOAD)
+/* a client datagram: RSV, FRAG, address, payload */
+#define HEV_FSH_SOCK_UDP_SLOT \
+    (3 + HEV_FSH_SOCK_UDP_ADDR_MAX + HEV_FSH_SOCK_UDP_PAYLOAD)
+
+#ifdef __linux__
+typedef struct mmsghdr HevFshSockUdpMsg;
+#else
+typedef struct _HevFshSockUdpMsg HevFshSockUdpMsg;
+
+struct _HevFshSockUdpMsg
+{
+    struct msghdr msg_hdr;
+    unsigned int msg_len;
+};
+#endif
+
+typedef struct _HevFshSockUdp HevFshSockUdp;
+
+struct _HevFshSockUdp
+{
+    /* per socket on the forwarder: IPv4, IPv6 */
+    HevFshSockUdpMsg msgs[2][HEV_FSH_SOCK_UDP_BATCH];
+    struct iovec iovs[2][HEV_FSH_SOCK_UDP_BATCH][2];
+    struct sockaddr_storage addrs[2][HEV_FSH_SOCK_UDP_BATCH];
+
+    /* frames to the tunnel; datagrams are received in place */
+    size_t trp;
+    size_t tuse;
+    /* frames from the tunnel */
+    size_t rrp;
+    size_t ruse;
+
+    unsigned char tbuf[HEV_FSH_SOCK_UDP_SLOT * HEV_FSH_SOCK_UDP_BATCH];
+    unsigned char rbuf[HEV_FSH_SOCK_UDP_FRAME_MAX * 2];
+};
+
+static const unsigned char zeros[3];
+
+static int
+sock_udp_recv (int fd, HevFshSockUdpMsg *msgs, int count)
+{
+#ifdef __linux__
+    return recvmmsg (fd, msgs, count, 0, NULL);
+#else
+    int i;
+
+    for (i = 0; i < count; i++) {
+        ssize_t res = recvmsg (fd, &msgs[i].msg_hdr, 0);
+
+        if (res < 0)
+            return i ? i : -1;
+        msgs[i].msg_len = res;
+    }
+
+    return count;
+#endif
+}
+
+static int
+sock_udp_send (int fd, HevFshSockUdpMsg *msgs, int count)
+{
+#ifdef __linux__
+    return sendmmsg (fd, msgs, count, 0);
+#else
+    int i;
+
+    for (i = 0; i < count; i++) {
+        ssize_t res = sendmsg (fd, &msgs[i].msg_hdr, 0);
+
+        if (res < 0)
+            return i ? i : -1;
+        msgs[i].msg_len = res;
+    }
+
+    return count;
+#endif
+}
+
+static void
+sock_udp_flush (int fd, HevFshSockUdpMsg *msgs, int count)
+{
+    int i = 0;
+
+    while (i < count) {
+        int res = sock_udp_send (fd, msgs + i, count - i);
+
+        if (res < 0) {
+            /* a full socket drops the rest, as the network would */
+            if (errno == EAGAIN)
+                break;
+            /* and one the target refuses is dropped alone */
+            res = 1;
+        }
+        i += res;
+    }
+}
+
+static void
+sock_udp_msg (HevFshSockUdpMsg *msg, struct iovec *iov, int iovlen,
+              struct sockaddr_storage *addr)
+{
+    __builtin_bzero (msg, sizeof (HevFshSockUdpMsg));
+    msg->msg_hdr.msg_name = addr;
+    msg->msg_hdr.msg_namelen = sizeof (struct sockaddr_storage);
+    if (addr->ss_family == AF_INET6)
+        msg->msg_hdr.msg_namelen = sizeof (struct sockaddr_in6);
+    else if (addr->ss_family == AF_INET)
+        msg->msg_hdr.msg_namelen = sizeof (struct sockaddr_in);
+    msg->msg_hdr.msg_iov = iov;
+    msg->msg_hdr.msg_iovlen = iovlen;
+}
+
+/* Size of the SOCKS5 address at buf, within len bytes, or -1. */
+static int
+sock_udp_addr_size (const unsigned char *buf, size_t len)
+{
+    size_t size;
+
+    if (len < 2)
+        return -1;
+
+    switch (buf[0]) {
+    case 1:
+        size = 1 + 4 + 2;
+        break;
+    case 4:
+        size = 1 + 16 + 2;
+        break;
+    case 3:
+        size = 1 + 1 + buf[1] + 2;
+        break;
+    default:
+        return -1;
+    }
+
+    if (size > len)
+        return -1;
+
+    return size;
+}
+
+int
+hev_fsh_sock_udp_put_addr (unsigned char *buf,
+                           const struct sockaddr_storage *addr)
+{
+    if (addr->ss_family == AF_INET) {
+        const struct sockaddr_in *addr4 = (const struct sockaddr_in *)addr;
+
+        buf[0] = 1;
+        memcpy (buf + 1, &addr4->sin_addr, 4);
+        memcpy (buf + 5, &addr4->sin_port, 2);
+        return 1 + 4 + 2;
+    }
+
+    if (addr->ss_family == AF_INET6) {
+        const struct sockaddr_in6 *addr6 = (const struct sockaddr_in6 *)addr;
+
+        buf[0] = 4;
+        memcpy (buf + 1, &addr6->sin6_addr, 16);
+        memcpy (buf + 17, &addr6->sin6_port, 2);
+        return 1 + 16 + 2;
+    }
+
+    return -1;
+}
+
+void
+hev_fsh_sock_udp_unmap (struct sockaddr_storage *addr)
+{
+    struct sockaddr_in6 *addr6 = (struct sockaddr_in6 *)addr;
+    struct sockaddr_in addr4;
+
+    if (addr->ss_family != AF_INET6 ||
+        !IN6_IS_ADDR_V4MAPPED (&addr6->sin6_addr))
+        return;
+
+    __builtin_bzero (&addr4, sizeof (addr4));
+    addr4.sin_family = AF_INET;
+    addr4.sin_port = addr6->sin6_port;
+    memcpy (&addr4.sin_addr, &addr6->sin6_addr.s6_addr[12], 4);
+    memcpy (addr, &addr4, sizeof (addr4));
+}
+
+static int
+sock_udp_same_host (const struct sockaddr_storage *a,
+                    const struct sockaddr_storage *b)
+{
+    if (a->ss_family != b->ss_family)
+        return 0;
+
+    if (a->ss_family == AF_INET6)
+        return !memcmp (&((struct sockaddr_in6 *)a)->sin6_addr,
+                        &((struct sockaddr_in6 *)b)->sin6_addr, 16);
+
+    return !memcmp (&((struct sockaddr_in *)a)->sin_addr,
+                    &((struct sockaddr_in *)b)->sin_addr, 4);
+}
+
+/* Room for count more slots of size bytes at the end of tbuf. */
+static int
+sock_udp_room (HevFshSockUdp *self, size_t size)
+{
+    size_t count;
+
+    if (self->trp) {
+        memmove (self->tbuf, self->tbuf + self->trp, self->tuse);
+        self->trp = 0;
+    }
+
+    count = (sizeof (self->tbuf) - self->tuse) / size;
+    if (count > HEV_FSH_SOCK_UDP_BATCH)
+        count = HEV_FSH_SOCK_UDP_BATCH;
+
+    return count;
+}
+
+/* 1 on progress, 0 on none, -1 once tfd is gone. */
+static int
+sock_udp_write (HevFshSockUdp *self, int tfd)
+{
+    ssize_t res;
+
+    if (!self->tuse)
+        return 0;
+
+    res = write (tfd, self->tbuf + self->trp, self->tuse);
+    if (res < 0)
+        return (errno == EAGAIN) ? 0 : -1;
+
+    self->trp += res;
+    self->tuse -= res;
+    if (!self->tuse)
+        self->trp = 0;
+
+    return 1;
+}
+
+/* 1 on progress, 0 on none, -1 once tfd is gone. */
+static int
+sock_udp_read (HevFshSockUdp *self, int tfd)
+{
+    ssize_t res;
+
+    if (self->rrp &&
+        (self->rrp + self->ruse + HEV_FSH_SOCK_UDP_FRAME_MAX >
+         sizeof (self->rbuf))) {
+        memmove (self->rbuf, self->rbuf + self->rrp, self->ruse);
+        self->rrp = 0;
+    }
+
+    if (self->rrp + self->ruse == sizeof (self->rbuf))
+        return 0;
+
+    res = read (tfd, self->rbuf + self->rrp + self->ruse,
+                sizeof (self->rbuf) - self->rrp - self->ruse);
+    if (res == 0)
+        return -1;
+    if (res < 0)
+        return (errno == EAGAIN) ? 0 : -1;
+
+    self->ruse += res;
+
+    return 1;
+}
+
+/* The next whole frame from the tunnel: its length, 0 if none, -1 if bad. */
+static int
+sock_udp_frame (HevFshSockUdp *self, unsigned char **frame)
+{
+    unsigned char *p = self->rbuf + self->rrp;
+    size_t len;
+
+    if (self->ruse < 2)
+        return 0;
+
+    len = (p[0] << 8) | p[1];
+    if (len < 2 || len > HEV_FSH_SOCK_UDP_FRAME_MAX - 2)
+        return -1;
+    if (self->ruse < 2 + len)
+        return 0;
+
+    *frame = p + 2;
+    self->rrp += 2 + len;
+    self->ruse -= 2 + len;
+
+    return len;
+}
+
+static int
+sock_udp_yield (HevTaskIOYielder yielder, void *data, int progress,
+                int *rounds)
+{
+    if (progress) {
+        /* share the worker with everything else once in a while */
+        if (++(*rounds) < 64)
+            return 0;
+        *rounds = 0;
+        if (yielder)
+            return yielder (HEV_TASK_YIELD, data);
+        hev_task_yield (HEV_TASK_YIELD);
+        return 0;
+    }
+
+    *rounds = 0;
+    if (yielder)
+        return yielder (HEV_TASK_WAITIO, data);
+    hev_task_yield (HEV_TASK_WAITIO);
+    return 0;
+}
+
+/* Client datagrams to tunnel frames: 1 on progress, 0 on none, -1 on error. */
+static int
+sock_udp_client_rx (HevFshSockUdp *self, int ufd,
+                    const struct sockaddr_storage *host,
+                    struct sockaddr_storage *peer)
+{
+    HevFshSockUdpMsg *msgs = self->msgs[0];
+    unsigned char *base;
+    int count;
+    int i;
+
+    count = sock_udp_room (self, HEV_FSH_SOCK_UDP_SLOT);
+    if (!count)
+        return 0;
+
+    base = self->tbuf + self->tuse;
+    for (i = 0; i < count; i++) {
+        struct iovec *iov = &self->iovs[0][i][0];
+
+        iov->iov_base = base + i * HEV_FSH_SOCK_UDP_SLOT;
+        iov->iov_len = HEV_FSH_SOCK_UDP_SLOT;
+        sock_udp_msg (&msgs[i], iov, 1, &self->addrs[0][i]);
+    }
+
+    count = sock_udp_recv (ufd, msgs, count);
+    if (count < 0)
+        return (errno == EAGAIN) ? 0 : -1;
+
+    for (i = 0; i < count; i++) {
+        unsigned char *p = base + i * HEV_FSH_SOCK_UDP_SLOT;
+        size_t len = msgs[i].msg_len;
+        unsigned char *frame;
+
+        /* only the client, and no fragments: nobody sends those */
+        if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
+            continue;
+        if (!sock_udp_same_host (&self->addrs[0][i], host))
+            continue;
+        if (len < 3 || p[2] != 0)
+            continue;
+        if (sock_udp_addr_size (p + 3, len - 3) < 0)
+            continue;
+
+        if (!peer->ss_family)
+            memcpy (peer, &self->addrs[0][i], sizeof (*peer));
+
+        /* the length takes the place of RSV and FRAG */
+        len -= 3;
+        frame = self->tbuf + self->tuse;
+        memmove (frame + 2, p + 3, len);
+        frame[0] = len >> 8;
+        frame[1] = len;
+        self->tuse += 2 + len;
+    }
+
+    return 1;
+}
+
+/* Tunnel frames to client datagrams: 0 when done, -1 on a bad frame. */
+static int
+sock_udp_client_tx (HevFshSockUdp *self, int ufd,
+                    struct sockaddr_storage *peer)
+{
+    HevFshSockUdpMsg *msgs = self->msgs[0];
+    unsigned char *frame;
+    int count = 0;
+    int len;
+
+    while ((len = sock_udp_frame (self, &frame)) > 0) {
+        struct iovec *iov = self->iovs[0][count];
+
+        /* the client has not spoken yet: nowhere to send */
+        if (!peer->ss_family || sock_udp_addr_size (frame, len) < 0)
+            continue;
+
+        iov[0].iov_base = (void *)zeros;
+        iov[0].iov_len = 3;
+        iov[1].iov_base = frame;
+        iov[1].iov_len = len;
+        sock_udp_msg (&msgs[count], iov, 2, peer);
+
+        if (++count == HEV_FSH_SOCK_UDP_BATCH) {
+            sock_udp_flush (ufd, msgs, count);
+            count = 0;
+        }
+    }
+
+    if (count)
+        sock_udp_flush (ufd, msgs, count);
+
+    return len;
+}
+
+void
+hev_fsh_sock_udp_client_run (int cfd, int ufd, int tfd,
+                             HevTaskIOYielder yielder, void *data)
+{
+    struct sockaddr_storage host;
+    struct sockaddr_storage peer;
+    socklen_t len = sizeof (host);
+    HevFshSockUdp *self;
+    int rounds = 0;
+
+    if (getpeername (cfd, (struct sockaddr *)&host, &len) < 0)
+        return;
+    hev_fsh_sock_udp_unmap (&host);
+
+    self = hev_malloc0 (sizeof (HevFshSockUdp));
+    if (!self)
+        return;
+
+    LOG_D ("%p fsh sock udp client run", self);
+
+    __builtin_bzero (&peer, sizeof (peer));
+
+    for (;;) {
+        unsigned char junk[64];
+        int progress = 0;
+        ssize_t res;
+        int stat;
+
+        /* the association lasts as long as the control connection */
+        res = recv (cfd, junk, sizeof (junk), 0);
+        if (res == 0 || (res < 0 && errno != EAGAIN))
+            break;
+
+        stat = sock_udp_client_rx (self, ufd, &host, &peer);
+        if (stat < 0)
+            break;
+        progress |= stat;
+
+        stat = sock_udp_write (self, tfd);
+        if (stat < 0)
+            break;
+        progress |= stat;
+
+        stat = sock_udp_read (self, tfd);
+        if (stat < 0)
+            break;
+        progress |= stat;
+
+        if (sock_udp_client_tx (self, ufd, &peer) < 0)
+            break;
+
+        if (sock_udp_yield (yielder, data, progress, &rounds) < 0)
+            break;
+    }
+
+    LOG_D ("%p fsh sock udp client done", self);
+
+    hev_free (self);
+}
+
+static int
+sock_udp_server_socket (int *fds, int k)
+{
+    int fd;
+
+    if (fds[k] >= 0)
+        return fds[k];
+
+    fd = socket (k ? AF_INET6 : AF_INET,
+                 SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+
+    hev_task_add_fd (hev_task_self (), fd, POLLIN | POLLOUT);
+    fds[k] = fd;
+
+    return fd;
+}
+
+/* Resolves the SOCKS5 address of a frame into addr: 0, or -1. */
+static int
+sock_udp_server_resolve (HevFshDnsCache *cache, const unsigned char *buf,
+                         struct sockaddr_storage *addr)
+{
+    struct sockaddr_in6 *addr6 = (struct sockaddr_in6 *)addr;
+    struct sockaddr_in *addr4 = (struct sockaddr_in *)addr;
+    struct sockaddr_storage addrs[HEV_FSH_DNS_CACHE_ADDRS];
+    unsigned short port;
+    char name[256];
+    int count;
+
+    switch (buf[0]) {
+    case 1:
+        __builtin_bzero (addr4, sizeof (*addr4));
+        addr4->sin_family = AF_INET;
+        memcpy (&addr4->sin_addr, buf + 1, 4);
+        memcpy (&addr4->sin_port, buf + 5, 2);
+        return 0;
+    case 4:
+        __builtin_bzero (addr6, sizeof (*addr6));
+        addr6->sin6_family = AF_INET6;
+        memcpy (&addr6->sin6_addr, buf + 1, 16);
+        memcpy (&addr6->sin6_port, buf + 17, 2);
+        return 0;
+    }
+
+    if (!cache || !buf[1])
+        return -1;
+
+    memcpy (name, buf + 2, buf[1]);
+    name[buf[1]] = '\0';
+    memcpy (&port, buf + 2 + buf[1], 2);
+
+    count = hev_fsh_dns_cache_lookup (cache, name, addrs,
+                                      HEV_FSH_DNS_CACHE_ADDRS);
+    if (count <= 0)
+        return -1;
+
+    memcpy (addr, &addrs[0], sizeof (*addr));
+    if (addr->ss_family == AF_INET6)
+        addr6->sin6_port = port;
+    else
+        addr4->sin_port = port;
+
+    return 0;
+}
+
+/* Tunnel frames to their targets: 0 when done, -1 on a bad frame. */
+static int
+sock_udp_server_tx (HevFshSockUdp *self, int *fds, HevFshDnsCache *cache)
+{
+    int count[2] = { 0, 0 };
+    unsigned char *frame;
+    int len;
+    int k;
+
+    while ((len = sock_udp_frame (self, &frame)) > 0) {
+        struct sockaddr_storage *addr;
+        struct iovec *iov;
+        int size;
+
+        size = sock_udp_addr_size (frame, len);
+        if (size < 0)
+            continue;
+
+        k = frame[0] == 1 ? 0 : 1;
+        if (frame[0] == 3) {
+            struct sockaddr_storage target;
+
+            if (sock_udp_server_resolve (cache, frame, &target) < 0)
+                continue;
+            k = target.ss_family == AF_INET6;
+            memcpy (&self->addrs[k][count[k]], &target, sizeof (target));
+        } else if (sock_udp_server_resolve (cache, frame,
+                                            &self->addrs[k][count[k]]) < 0) {
+            continue;
+        }
+
+        if (sock_udp_server_socket (fds, k) < 0)
+            continue;
+
+        addr = &self->addrs[k][count[k]];
+        iov = self->iovs[k][count[k]];
+        iov->iov_base = frame + size;
+        iov->iov_len = len - size;
+        sock_udp_msg (&self->msgs[k][count[k]], iov, 1, addr);
+
+        if (++count[k] == HEV_FSH_SOCK_UDP_BATCH) {
+            sock_udp_flush (fds[k], self->msgs[k], count[k]);
+            count[k] = 0;
+        }
+    }
+
+    for (k = 0; k < 2; k++)
+        if (count[k])
+            sock_udp_flush (fds[k], self->msgs[k], count[k]);
+
+    return len;
+}
+
+/* Answers to tunnel frames: 1 on progress, 0 on none. */
+static int
+sock_udp_server_rx (HevFshSockUdp *self, int fd, int k)
+{
+    HevFshSockUdpMsg *msgs = self->msgs[k];
+    size_t hsize = k ? (2 + 1 + 16 + 2) : (2 + 1 + 4 + 2);
+    size_t size = hsize + HEV_FSH_SOCK_UDP_PAYLOAD;
+    unsigned char *base;
+    int count;
+    int i;
+
+    if (fd < 0)
+        return 0;
+
+    count = sock_udp_room (self, size);
+    if (!count)
+        return 0;
+
+    /* each payload lands after the room its frame header takes */
+    base = self->tbuf + self->tuse;
+    for (i = 0; i < count; i++) {
+        struct iovec *iov = &self->iovs[k][i][0];
+
+        iov->iov_base = base + i * size + hsize;
+        iov->iov_len = HEV_FSH_SOCK_UDP_PAYLOAD;
+        sock_udp_msg (&msgs[i], iov, 1, &self->addrs[k][i]);
+    }
+
+    count = sock_udp_recv (fd, msgs, count);
+    if (count <= 0)
+        return 0;
+
+    for (i = 0; i < count; i++) {
+        unsigned char *p = base + i * size;
+        size_t len = msgs[i].msg_len;
+        unsigned char *frame;
+        int asize;
+
+        if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
+            continue;
+
+        asize = hev_fsh_sock_udp_put_addr (p + 2, &self->addrs[k][i]);
+        if (asize < 0)
+            continue;
+
+        len += asize;
+        frame = self->tbuf + self->tuse;
+        memmove (frame + 2, p + 2, len);
+        frame[0] = len >> 8;
+        frame[1] = len;
+        self->tuse += 2 + len;
+    }
+
+    return 1;
+}
+
+void
+hev_fsh_sock_udp_server_run (int tfd, HevFshDnsCache *cache,
+                             HevTaskIOYielder yielder, void *data)
+{
+    HevFshSockUdp *self;
+    int fds[2] = { -1, -1 };
+    int rounds = 0;
+    int k;
+
+    self = hev_malloc0 (sizeof (HevFshSockUdp));
+    if (!self)
+        return;
+
+    LOG_D ("%p fsh sock udp server run", self);
+
+    for (;;) {
+        int progress = 0;
+        int stat;
+
+        stat = sock_udp_read (self, tfd);
+        if (stat < 0)
+            break;
+        progress |= stat;
+
+        if (sock_udp_server_tx (self, fds, cache) < 0)
+            break;
+
+        for (k = 0; k < 2; k++)
+            progress |= sock_udp_server_rx (self, fds[k], k);
+
+        stat = sock_udp_write (self, tfd);
+        if (stat < 0)
+            break;
+        progress |= stat;
+
+        if (sock_udp_yield (yielder, data, progress, &rounds) < 0)
+            break;
+    }
+
+    LOG_D ("%p fsh sock udp server done", self);
+
+    for (k = 0; k < 2; k++) {
+        if (fds[k] >= 0) {
+            hev_task_del_fd (hev_task_self (), fds[k]);
+            close (fds[k]);
+        }
+    }
+
+    hev_free (self);
+}
@@ -0,0 +1,48 @@
+/*
+ ============================================================================
+ Name        : hev-fsh-sock-udp.h
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Fsh SOCKS5 UDP relay
+ ============================================================================
+ */
+
+#ifndef __HEV_FSH_SOCK_UDP_H__
+#define __HEV_FSH_SOCK_UDP_H__
+
+#include <sys/socket.h>
+
+#include <hev-task-io.h>
+
+#include "hev-fsh-dns-cache.h"
+
+/* datagrams moved per system call, and the largest payload relayed */
+#define HEV_FSH_SOCK_UDP_BATCH (16)
+#define HEV_FSH_SOCK_UDP_PAYLOAD (8192)
+
+/* Turns a v4-mapped IPv6 address into the IPv4 one. */
+void hev_fsh_sock_udp_unmap (struct sockaddr_storage *addr);
+
+/* Writes addr as a SOCKS5 address (ATYP, address, port): its size, or -1. */
+int hev_fsh_sock_udp_put_addr (unsigned char *buf,
+                               const struct sockaddr_storage *addr);
+
+/*
+ * Connector end: relays the SOCKS5 datagrams the client sends to ufd from
+ * the address of its control connection cfd as frames on tfd, and the
+ * frames back, until cfd or tfd closes or the yielder gives up. The fds
+ * are non-blocking and registered with the current task.
+ */
+void hev_fsh_sock_udp_client_run (int cfd, int ufd, int tfd,
+                                  HevTaskIOYielder yielder, void *data);
+
+/*
+ * Forwarder end: sends the datagrams framed on tfd to their targets, names
+ * resolved through cache, and frames the answers back, until tfd closes or
+ * the yielder gives up. tfd is non-blocking and registered with the current
+ * task.
+ */
+void hev_fsh_sock_udp_server_run (int tfd, HevFshDnsCache *cache,
+                                  HevTaskIOYielder yielder, void *data);
+
+#endif /* __HEV_FSH_SOCK_UDP_H__ */
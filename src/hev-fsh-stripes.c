@@ -0,0 +1,262 @@
+/*
+ ============================================================================
+ Name        : hev-fsh-stripes.c
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Fsh striped tunnels being assembled
+ ============================================================================
+ */
+
+#include <time.h>
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include <hev-task.h>
+#include <hev-memory-allocator.h>
+
+#include "hev-logger.h"
+
+#include "hev-fsh-stripes.h"
+
+typedef struct _HevFshStripe HevFshStripe;
+
+struct _HevFshStripe
+{
+    HevFshStripe *next;
+    HevTask *task;
+    int64_t expire;
+
+    unsigned int count;
+    unsigned int joined;
+    unsigned int failed;
+    int fds[HEV_TASK_IO_STRIPE_MAX];
+
+    HevFshToken id;
+};
+
+struct _HevFshStripes
+{
+    HevFshStripe *list;
+    unsigned int count;
+    unsigned int timeout;
+};
+
+static int64_t
+hev_fsh_stripes_now (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void
+hev_fsh_stripe_free (HevFshStripe *stripe)
+{
+    int i;
+
+    for (i = 1; i < stripe->count; i++)
+        if (stripe->fds[i] >= 0)
+            close (stripe->fds[i]);
+
+    hev_free (stripe);
+}
+
+static void
+hev_fsh_stripes_remove (HevFshStripes *self, HevFshStripe *stripe)
+{
+    HevFshStripe **prev;
+
+    for (prev = &self->list; *prev; prev = &(*prev)->next) {
+        if (*prev == stripe) {
+            *prev = stripe->next;
+            self->count--;
+            break;
+        }
+    }
+}
+
+/* Drops the tunnels nobody waits for any more. */
+static void
+hev_fsh_stripes_purge (HevFshStripes *self, int64_t now)
+{
+    HevFshStripe **prev = &self->list;
+
+    while (*prev) {
+        HevFshStripe *stripe = *prev;
+
+        if (stripe->task || stripe->expire > now) {
+            prev = &stripe->next;
+            continue;
+        }
+
+        LOG_D ("%p fsh stripes expire %p", self, stripe);
+
+        *prev = stripe->next;
+        hev_fsh_stripe_free (stripe);
+        self->count--;
+    }
+}
+
+static HevFshStripe *
+hev_fsh_stripes_get (HevFshStripes *self, HevFshToken id, unsigned int count)
+{
+    HevFshStripe *stripe;
+    int64_t now;
+    int i;
+
+    if (count < 2 || count > HEV_TASK_IO_STRIPE_MAX)
+        return NULL;
+
+    now = hev_fsh_stripes_now ();
+    hev_fsh_stripes_purge (self, now);
+
+    for (stripe = self->list; stripe; stripe = stripe->next) {
+        if (memcmp (stripe->id, id, sizeof (HevFshToken)) == 0)
+            return (stripe->count == count) ? stripe : NULL;
+    }
+
+    if (self->count >= HEV_FSH_STRIPES_MAX)
+        return NULL;
+
+    stripe = hev_malloc0 (sizeof (HevFshStripe));
+    if (!stripe)
+        return NULL;
+
+    LOG_D ("%p fsh stripes new %p", self, stripe);
+
+    memcpy (stripe->id, id, sizeof (HevFshToken));
+    stripe->count = count;
+    stripe->expire = now + self->timeout;
+    for (i = 0; i < count; i++)
+        stripe->fds[i] = -1;
+
+    stripe->next = self->list;
+    self->list = stripe;
+    self->count++;
+
+    return stripe;
+}
+
+HevFshStripes *
+hev_fsh_stripes_new (unsigned int timeout)
+{
+    HevFshStripes *self;
+
+    self = hev_malloc0 (sizeof (HevFshStripes));
+    if (!self)
+        return NULL;
+
+    LOG_D ("%p fsh stripes new", self);
+
+    self->timeout = timeout;
+
+    return self;
+}
+
+void
+hev_fsh_stripes_destroy (HevFshStripes *self)
+{
+    LOG_D ("%p fsh stripes destroy", self);
+
+    while (self->list) {
+        HevFshStripe *stripe = self->list;
+
+        self->list = stripe->next;
+        hev_fsh_stripe_free (stripe);
+    }
+
+    hev_free (self);
+}
+
+int
+hev_fsh_stripes_join (HevFshStripes *self, HevFshToken id,
+                      unsigned int index, unsigned int count, int fd)
+{
+    HevFshStripe *stripe;
+
+    stripe = hev_fsh_stripes_get (self, id, count);
+    if (!stripe || !index || index >= count || stripe->fds[index] >= 0)
+        return -1;
+
+    LOG_D ("%p fsh stripes join %p %u", self, stripe, index);
+
+    stripe->fds[index] = fd;
+    stripe->joined++;
+
+    if (stripe->task && (stripe->joined == count - 1))
+        hev_task_wakeup (stripe->task);
+
+    return 0;
+}
+
+void
+hev_fsh_stripes_abort (HevFshStripes *self, HevFshToken id,
+                       unsigned int count)
+{
+    HevFshStripe *stripe;
+
+    stripe = hev_fsh_stripes_get (self, id, count);
+    if (!stripe)
+        return;
+
+    LOG_D ("%p fsh stripes abort %p", self, stripe);
+
+    stripe->failed = 1;
+    if (stripe->task)
+        hev_task_wakeup (stripe->task);
+}
+
+/* Whether the peer has closed fd: woken by its events, the waiter looks. */
+static int
+hev_fsh_stripes_closed (int fd)
+{
+    ssize_t res;
+    char c;
+
+    res = recv (fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+
+    return (res == 0) || (res < 0 && errno != EAGAIN);
+}
+
+int
+hev_fsh_stripes_wait (HevFshStripes *self, HevFshToken id,
+                      unsigned int count, int fd, int *fds)
+{
+    HevFshStripe *stripe;
+    int64_t now;
+    int i;
+
+    stripe = hev_fsh_stripes_get (self, id, count);
+    if (!stripe || stripe->task)
+        return -1;
+
+    LOG_D ("%p fsh stripes wait %p", self, stripe);
+
+    /* not purged while waited for: the waiter takes it out */
+    stripe->task = hev_task_self ();
+    now = hev_fsh_stripes_now ();
+    while (stripe->joined < count - 1 && stripe->expire > now) {
+        if (stripe->failed || hev_fsh_stripes_closed (fd))
+            break;
+        hev_task_sleep (stripe->expire - now);
+        now = hev_fsh_stripes_now ();
+    }
+
+    hev_fsh_stripes_remove (self, stripe);
+    if (stripe->joined < count - 1) {
+        LOG_D ("%p fsh stripes fail %p", self, stripe);
+        hev_fsh_stripe_free (stripe);
+        return -1;
+    }
+
+    for (i = 1; i < count; i++)
+        fds[i - 1] = stripe->fds[i];
+    hev_free (stripe);
+
+    return 0;
+}
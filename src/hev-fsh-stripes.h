@@ -0,0 +1,48 @@
+/*
+ ============================================================================
+ Name        : hev-fsh-stripes.h
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Fsh striped tunnels being assembled
+ ============================================================================
+ */
+
+#ifndef __HEV_FSH_STRIPES_H__
+#define __HEV_FSH_STRIPES_H__
+
+#include "hev-task-io-stripe.h"
+#include "hev-fsh-protocol.h"
+
+#define HEV_FSH_STRIPES_MAX (64)
+
+typedef struct _HevFshStripes HevFshStripes;
+
+/*
+ * Gathers the connections of striped tunnels, each handed in by a task of
+ * its own, for the task that runs the tunnel. A tunnel not complete within
+ * timeout ms is given up.
+ */
+HevFshStripes *hev_fsh_stripes_new (unsigned int timeout);
+void hev_fsh_stripes_destroy (HevFshStripes *self);
+
+/*
+ * Takes over fd, not registered with any task, as connection index of the
+ * count of tunnel id. Returns -1 if it does not fit: the caller still owns
+ * fd.
+ */
+int hev_fsh_stripes_join (HevFshStripes *self, HevFshToken id,
+                          unsigned int index, unsigned int count, int fd);
+
+/* Tells the waiter of tunnel id that one of its connections will not come. */
+void hev_fsh_stripes_abort (HevFshStripes *self, HevFshToken id,
+                            unsigned int count);
+
+/*
+ * Waits for connections 1 to count - 1 of tunnel id and hands them over in
+ * fds. Returns -1 if they do not all come in time, one is aborted, or the
+ * peer closes fd, connection 0.
+ */
+int hev_fsh_stripes_wait (HevFshStripes *self, HevFshToken id,
+                          unsigned int count, int fd, int *fds);
+
+#endif /* __HEV_FSH_STRIPES_H__ */
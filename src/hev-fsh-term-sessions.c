@@ -0,0 +1,271 @@
+/*
+ ============================================================================
+ Name        : hev-fsh-term-sessions.c
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Fsh forwarder detached terminal sessions
+ ============================================================================
+ */
+
+#include <time.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include <hev-task.h>
+#include <hev-memory-allocator.h>
+
+#include "hev-logger.h"
+#include "hev-fsh-config.h"
+
+#include "hev-fsh-term-sessions.h"
+
+typedef struct _HevFshTermSession HevFshTermSession;
+
+struct _HevFshTermSession
+{
+    HevFshTermSession *next;
+    HevTaskIOTerm *term;
+    HevTask *waiter;
+    int64_t expire;
+    int pfd;
+    int sfd;
+
+    HevFshToken id;
+};
+
+struct _HevFshTermSessions
+{
+    HevTask *task;
+    HevFshTermSession *list;
+    unsigned int count;
+    unsigned int grace;
+};
+
+static int64_t
+hev_fsh_term_sessions_now (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void
+hev_fsh_term_session_free (HevFshTermSession *session)
+{
+    /* the shell gets SIGHUP once its master is closed */
+    if (session->term) {
+        close (session->pfd);
+        hev_task_io_term_destroy (session->term);
+    }
+    hev_free (session);
+}
+
+static HevFshTermSession **
+hev_fsh_term_sessions_find (HevFshTermSessions *self, HevFshToken id)
+{
+    HevFshTermSession **prev;
+
+    for (prev = &self->list; *prev; prev = &(*prev)->next)
+        if (memcmp ((*prev)->id, id, sizeof (HevFshToken)) == 0)
+            break;
+
+    return prev;
+}
+
+static void
+hev_fsh_term_sessions_task_entry (void *data)
+{
+    HevFshTermSessions *self = data;
+
+    for (;;) {
+        HevFshTermSession **prev = &self->list;
+        int64_t next = 0;
+        int64_t now;
+
+        now = hev_fsh_term_sessions_now ();
+        while (*prev) {
+            HevFshTermSession *session = *prev;
+
+            /* attached: its link's task owns it */
+            if (!session->term) {
+                prev = &session->next;
+                continue;
+            }
+
+            if (session->expire > now) {
+                if (!next || session->expire < next)
+                    next = session->expire;
+                prev = &session->next;
+                continue;
+            }
+
+            LOG_D ("%p fsh term sessions expire %p", self, session);
+
+            *prev = session->next;
+            hev_fsh_term_session_free (session);
+            self->count--;
+        }
+
+        /* woken early by a park, the list is walked again */
+        if (next)
+            hev_task_sleep (next - now);
+        else
+            hev_task_yield (HEV_TASK_WAITIO);
+    }
+}
+
+HevFshTermSessions *
+hev_fsh_term_sessions_new (unsigned int grace)
+{
+    HevFshTermSessions *self;
+
+    self = hev_malloc0 (sizeof (HevFshTermSessions));
+    if (!self)
+        return NULL;
+
+    self->task = hev_task_new (HEV_FSH_CONFIG_TASK_STACK_SIZE);
+    if (!self->task) {
+        hev_free (self);
+        return NULL;
+    }
+
+    LOG_D ("%p fsh term sessions new", self);
+
+    self->grace = grace;
+
+    hev_task_run (self->task, hev_fsh_term_sessions_task_entry, self);
+
+    return self;
+}
+
+void
+hev_fsh_term_sessions_destroy (HevFshTermSessions *self)
+{
+    LOG_D ("%p fsh term sessions destroy", self);
+
+    while (self->list) {
+        HevFshTermSession *session = self->list;
+
+        self->list = session->next;
+        hev_fsh_term_session_free (session);
+    }
+
+    hev_free (self);
+}
+
+int
+hev_fsh_term_sessions_attach (HevFshTermSessions *self, HevFshToken id,
+                              int sfd)
+{
+    HevFshTermSession *session;
+
+    if (self->count >= HEV_FSH_TERM_SESSIONS_MAX)
+        return -1;
+
+    session = hev_malloc0 (sizeof (HevFshTermSession));
+    if (!session)
+        return -1;
+
+    LOG_D ("%p fsh term sessions attach %p", self, session);
+
+    memcpy (session->id, id, sizeof (HevFshToken));
+    session->pfd = -1;
+    session->sfd = sfd;
+
+    session->next = self->list;
+    self->list = session;
+    self->count++;
+
+    return 0;
+}
+
+void
+hev_fsh_term_sessions_detach (HevFshTermSessions *self, HevFshToken id)
+{
+    HevFshTermSession **prev;
+    HevFshTermSession *session;
+
+    prev = hev_fsh_term_sessions_find (self, id);
+    session = *prev;
+    if (!session || session->term)
+        return;
+
+    LOG_D ("%p fsh term sessions detach %p", self, session);
+
+    *prev = session->next;
+    if (session->waiter)
+        hev_task_wakeup (session->waiter);
+    hev_free (session);
+    self->count--;
+}
+
+int
+hev_fsh_term_sessions_park (HevFshTermSessions *self, HevFshToken id,
+                            HevTaskIOTerm *term, int pfd)
+{
+    HevFshTermSession *session;
+
+    session = *hev_fsh_term_sessions_find (self, id);
+    if (!session) {
+        if (hev_fsh_term_sessions_attach (self, id, -1) < 0)
+            return -1;
+        session = self->list;
+    }
+
+    LOG_D ("%p fsh term sessions park %p", self, session);
+
+    session->term = term;
+    session->pfd = pfd;
+    session->sfd = -1;
+    session->expire = hev_fsh_term_sessions_now ();
+    session->expire += (int64_t)self->grace * 1000;
+
+    if (session->waiter)
+        hev_task_wakeup (session->waiter);
+    hev_task_wakeup (self->task);
+
+    return 0;
+}
+
+int
+hev_fsh_term_sessions_take (HevFshTermSessions *self, HevFshToken id,
+                            int sfd, HevTaskIOTerm **term, int *pfd)
+{
+    HevFshTermSession *session;
+    unsigned int wait = HEV_FSH_TERM_SESSIONS_TAKEOVER;
+
+    /*
+     * The connector may see the link drop well before this end does: cut
+     * the old link, whose task parks the session on its way out.
+     */
+    session = *hev_fsh_term_sessions_find (self, id);
+    if (session && !session->term && !session->waiter) {
+        LOG_D ("%p fsh term sessions take over %p", self, session);
+
+        shutdown (session->sfd, SHUT_RDWR);
+        session->waiter = hev_task_self ();
+        while (wait && session && !session->term) {
+            wait = hev_task_sleep (wait);
+            session = *hev_fsh_term_sessions_find (self, id);
+        }
+        if (session)
+            session->waiter = NULL;
+    }
+
+    if (!session || !session->term)
+        return -1;
+
+    LOG_D ("%p fsh term sessions take %p", self, session);
+
+    *term = session->term;
+    *pfd = session->pfd;
+    session->term = NULL;
+    session->pfd = -1;
+    session->sfd = sfd;
+
+    return 0;
+}
@@ -0,0 +1,55 @@
+/*
+ ============================================================================
+ Name        : hev-fsh-term-sessions.h
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Fsh forwarder detached terminal sessions
+ ============================================================================
+ */
+
+#ifndef __HEV_FSH_TERM_SESSIONS_H__
+#define __HEV_FSH_TERM_SESSIONS_H__
+
+#include "hev-task-io-term.h"
+#include "hev-fsh-protocol.h"
+
+#define HEV_FSH_TERM_SESSIONS_MAX (64)
+#define HEV_FSH_TERM_SESSIONS_TAKEOVER (3000)
+
+typedef struct _HevFshTermSessions HevFshTermSessions;
+
+/*
+ * Holds terminal sessions whose link dropped for grace seconds, so that a
+ * reconnecting connector finds its shell and the output it missed.
+ */
+HevFshTermSessions *hev_fsh_term_sessions_new (unsigned int grace);
+void hev_fsh_term_sessions_destroy (HevFshTermSessions *self);
+
+/*
+ * Registers session id as attached to the link sfd, so that a resume over a
+ * new link can take it over. Returns -1 if full: the session then only
+ * resumes if it gets parked.
+ */
+int hev_fsh_term_sessions_attach (HevFshTermSessions *self, HevFshToken id,
+                                  int sfd);
+
+/* Forgets the attached session id: its shell is gone. */
+void hev_fsh_term_sessions_detach (HevFshTermSessions *self, HevFshToken id);
+
+/*
+ * Takes over term and the pty master pfd, neither registered with any task,
+ * until id is resumed or its grace runs out. Returns -1 if full: the caller
+ * still owns both.
+ */
+int hev_fsh_term_sessions_park (HevFshTermSessions *self, HevFshToken id,
+                                HevTaskIOTerm *term, int pfd);
+
+/*
+ * Hands session id back to the caller, attached to sfd from now on. One
+ * still attached to another link has that link cut and is waited for, up
+ * to HEV_FSH_TERM_SESSIONS_TAKEOVER ms. Returns -1 if there is none.
+ */
+int hev_fsh_term_sessions_take (HevFshTermSessions *self, HevFshToken id,
+                                int sfd, HevTaskIOTerm **term, int *pfd);
+
+#endif /* __HEV_FSH_TERM_SESSIONS_H__ */
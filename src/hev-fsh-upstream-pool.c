@@ -0,0 +1,316 @@
+/*
+ ============================================================================
+ Name        : hev-fsh-upstream-pool.c
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Fsh forwarder upstream connection pool
+ ============================================================================
+ */
+
+#include <time.h>
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+
+#include <hev-task.h>
+#include <hev-task-io.h>
+#include <hev-task-io-socket.h>
+#include <hev-memory-allocator.h>
+
+#include "hev-logger.h"
+#include "hev-fsh-config.h"
+
+#include "hev-fsh-upstream-pool.h"
+
+typedef struct _HevFshUpstreamTarget HevFshUpstreamTarget;
+
+struct _HevFshUpstreamTarget
+{
+    HevFshUpstreamTarget *next;
+    HevFshUpstreamPool *pool;
+    HevTask *task;
+
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+
+    int64_t used;
+    unsigned int depth;
+    unsigned int head;
+    unsigned int count;
+
+    int fds[HEV_FSH_UPSTREAM_POOL_DEPTH_MAX];
+    int64_t stamps[HEV_FSH_UPSTREAM_POOL_DEPTH_MAX];
+};
+
+struct _HevFshUpstreamPool
+{
+    HevFshUpstreamTarget *targets;
+
+    unsigned int timeout;
+    unsigned int idle;
+};
+
+static int64_t
+hev_fsh_upstream_pool_now (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+HevFshUpstreamPool *
+hev_fsh_upstream_pool_new (unsigned int timeout, unsigned int idle)
+{
+    HevFshUpstreamPool *self;
+
+    self = hev_malloc0 (sizeof (HevFshUpstreamPool));
+    if (!self)
+        return NULL;
+
+    LOG_D ("%p fsh upstream pool new", self);
+
+    self->timeout = timeout;
+    self->idle = idle;
+
+    return self;
+}
+
+static void
+hev_fsh_upstream_target_clear (HevFshUpstreamTarget *target)
+{
+    while (target->count) {
+        close (target->fds[target->head]);
+        target->head = (target->head + 1) % HEV_FSH_UPSTREAM_POOL_DEPTH_MAX;
+        target->count--;
+    }
+}
+
+void
+hev_fsh_upstream_pool_destroy (HevFshUpstreamPool *self)
+{
+    HevFshUpstreamTarget *iter = self->targets;
+
+    LOG_D ("%p fsh upstream pool destroy", self);
+
+    while (iter) {
+        HevFshUpstreamTarget *target = iter;
+
+        iter = iter->next;
+        hev_fsh_upstream_target_clear (target);
+        hev_free (target);
+    }
+
+    hev_free (self);
+}
+
+static int
+hev_fsh_upstream_pool_yielder (HevTaskYieldType type, void *data)
+{
+    HevFshUpstreamPool *self = data;
+
+    if (type == HEV_TASK_YIELD) {
+        hev_task_yield (HEV_TASK_YIELD);
+        return 0;
+    }
+
+    if (hev_task_sleep (self->timeout) == 0)
+        return -1;
+
+    return 0;
+}
+
+static int
+hev_fsh_upstream_target_connect (HevFshUpstreamTarget *target)
+{
+    struct sockaddr *addr = (struct sockaddr *)&target->addr;
+    int res;
+    int fd;
+
+    fd = hev_task_io_socket_socket (addr->sa_family, SOCK_STREAM,
+                                    IPPROTO_TCP);
+    if (fd < 0)
+        return -1;
+
+    hev_task_add_fd (hev_task_self (), fd, POLLIN | POLLOUT);
+    res = hev_task_io_socket_connect (fd, addr, target->addr_len,
+                                      hev_fsh_upstream_pool_yielder,
+                                      target->pool);
+    hev_task_del_fd (hev_task_self (), fd);
+    if (res < 0) {
+        close (fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static int
+hev_fsh_upstream_target_alive (int fd)
+{
+    char c;
+    int res;
+
+    /* A peer that spoke first (e.g. SSH) is fine, one that hung up is not. */
+    res = recv (fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (res > 0)
+        return 1;
+    if (res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        return 1;
+
+    return 0;
+}
+
+static void
+hev_fsh_upstream_target_expire (HevFshUpstreamTarget *target, int64_t now)
+{
+    HevFshUpstreamPool *self = target->pool;
+
+    while (target->count) {
+        unsigned int i = target->head;
+
+        if (target->stamps[i] + self->idle > now)
+            break;
+
+        close (target->fds[i]);
+        target->head = (i + 1) % HEV_FSH_UPSTREAM_POOL_DEPTH_MAX;
+        target->count--;
+    }
+}
+
+static void
+hev_fsh_upstream_target_task_entry (void *data)
+{
+    HevFshUpstreamTarget *target = data;
+    HevFshUpstreamPool *self = target->pool;
+    HevFshUpstreamTarget **prev;
+
+    for (;;) {
+        int64_t now = hev_fsh_upstream_pool_now ();
+        int64_t wait;
+
+        hev_fsh_upstream_target_expire (target, now);
+        if (target->used + self->idle <= now)
+            break;
+
+        if (target->count < target->depth) {
+            unsigned int i;
+            int fd;
+
+            fd = hev_fsh_upstream_target_connect (target);
+            if (fd < 0) {
+                LOG_D ("%p fsh upstream pool connect", self);
+                break;
+            }
+
+            i = (target->head + target->count);
+            i %= HEV_FSH_UPSTREAM_POOL_DEPTH_MAX;
+            target->fds[i] = fd;
+            target->stamps[i] = hev_fsh_upstream_pool_now ();
+            target->count++;
+            continue;
+        }
+
+        wait = target->used + self->idle - now;
+        if (target->count) {
+            int64_t e = target->stamps[target->head] + self->idle - now;
+            if (e < wait)
+                wait = e;
+        }
+        hev_task_sleep (wait);
+    }
+
+    hev_fsh_upstream_target_clear (target);
+
+    for (prev = &self->targets; *prev; prev = &(*prev)->next) {
+        if (*prev == target) {
+            *prev = target->next;
+            break;
+        }
+    }
+
+    hev_free (target);
+}
+
+static HevFshUpstreamTarget *
+hev_fsh_upstream_pool_target_new (HevFshUpstreamPool *self,
+                                  const struct sockaddr *addr, socklen_t len)
+{
+    HevFshUpstreamTarget *target;
+
+    if (len > sizeof (target->addr))
+        return NULL;
+
+    target = hev_malloc0 (sizeof (HevFshUpstreamTarget));
+    if (!target)
+        return NULL;
+
+    target->task = hev_task_new (HEV_FSH_CONFIG_TASK_STACK_SIZE);
+    if (!target->task) {
+        hev_free (target);
+        return NULL;
+    }
+
+    target->pool = self;
+    target->addr_len = len;
+    memcpy (&target->addr, addr, len);
+
+    target->next = self->targets;
+    self->targets = target;
+
+    hev_task_run (target->task, hev_fsh_upstream_target_task_entry, target);
+
+    return target;
+}
+
+int
+hev_fsh_upstream_pool_get (HevFshUpstreamPool *self,
+                           const struct sockaddr *addr, socklen_t len,
+                           unsigned int depth)
+{
+    HevFshUpstreamTarget *target;
+    int64_t now;
+    int fd = -1;
+
+    for (target = self->targets; target; target = target->next) {
+        if (target->addr_len == len && memcmp (&target->addr, addr, len) == 0)
+            break;
+    }
+
+    if (!target) {
+        target = hev_fsh_upstream_pool_target_new (self, addr, len);
+        if (!target)
+            return -1;
+    }
+
+    now = hev_fsh_upstream_pool_now ();
+    hev_fsh_upstream_target_expire (target, now);
+
+    while (target->count) {
+        int i = target->head;
+
+        target->head = (i + 1) % HEV_FSH_UPSTREAM_POOL_DEPTH_MAX;
+        target->count--;
+
+        if (hev_fsh_upstream_target_alive (target->fds[i])) {
+            fd = target->fds[i];
+            break;
+        }
+
+        close (target->fds[i]);
+    }
+
+    if (depth > HEV_FSH_UPSTREAM_POOL_DEPTH_MAX)
+        depth = HEV_FSH_UPSTREAM_POOL_DEPTH_MAX;
+
+    target->used = now;
+    target->depth = depth;
+    hev_task_wakeup (target->task);
+
+    LOG_D ("%p fsh upstream pool %s", self, (fd < 0) ? "miss" : "hit");
+
+    return fd;
+}
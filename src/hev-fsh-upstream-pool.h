@@ -0,0 +1,36 @@
+/*
+ ============================================================================
+ Name        : hev-fsh-upstream-pool.h
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Fsh forwarder upstream connection pool
+ ============================================================================
+ */
+
+#ifndef __HEV_FSH_UPSTREAM_POOL_H__
+#define __HEV_FSH_UPSTREAM_POOL_H__
+
+#include <sys/socket.h>
+
+#define HEV_FSH_UPSTREAM_POOL_DEPTH_MAX (16)
+
+typedef struct _HevFshUpstreamPool HevFshUpstreamPool;
+
+/*
+ * Keeps up to depth pre-connected sockets per target, each at most idle ms
+ * old. A target's sockets are dropped once it has not been asked for in
+ * idle ms.
+ */
+HevFshUpstreamPool *hev_fsh_upstream_pool_new (unsigned int timeout,
+                                               unsigned int idle);
+void hev_fsh_upstream_pool_destroy (HevFshUpstreamPool *self);
+
+/*
+ * Returns a connected socket to addr, registered with no task, or -1 on a
+ * miss. Either way the pool for addr is (re)filled in the background.
+ */
+int hev_fsh_upstream_pool_get (HevFshUpstreamPool *self,
+                               const struct sockaddr *addr, socklen_t len,
+                               unsigned int depth);
+
+#endif /* __HEV_FSH_UPSTREAM_POOL_H__ */
@@ -21,7 +21,10 @@
 #include <hev-task-system.h>
 
 #include "hev-logger.h"
+#include "hev-object-pool.h"
+#include "hev-task-io-uring.h"
 #include "hev-fsh-config.h"
+#include "hev-fsh-context.h"
 #include "hev-fsh-server.h"
 #include "hev-fsh-client.h"
 
@@ -34,17 +37,20 @@ show_help (void)
 {
     fprintf (stderr,
              "Common: [-4 | -6] [-k KEY] [-t TIMEOUT] [-l LOG] "
-             "[-c TCP_CONGESTION] [-v] [-U]\n"
-             "Server: -s [SERVER_ADDR:SERVER_PORT] [-a TOKENS_FILE]\n"
+             "[-c TCP_CONGESTION] [-m POOL_SIZE] [-B BUF_MIN[:BUF_MAX]] "
+             "[-i] [-I URING_TUNNELS] [-v] [-U] [-z] [-M]\n"
+             "Server: -s [SERVER_ADDR:SERVER_PORT] [-a TOKENS_FILE] [-R]\n"
              "Terminal:\n"
-             "  Forwarder: -f [-u USER] SERVER_ADDR[:SERVER_PORT/TOKEN]\n"
-             "  Connector: SERVER_ADDR[:SERVER_PORT]/TOKEN\n"
+             "  Forwarder: -f [-u USER] [-S SHELLS] [-g GRACE] "
+             "SERVER_ADDR[:SERVER_PORT/TOKEN]\n"
+             "  Connector: [-e] SERVER_ADDR[:SERVER_PORT]/TOKEN\n"
              "TCP Port:\n"
              "  Forwarder: -f -p [-w ADDR:PORT,... | -b ADDR:PORT,...] "
              "SERVER_ADDR[:SERVER_PORT/TOKEN]\n"
-             "  Connector: -p [LOCAL_ADDR:]LOCAL_PORT:REMOTE_ADDR:REMOTE_PORT "
+             "  Connector: -p [-n STREAMS] "
+             "[LOCAL_ADDR:]LOCAL_PORT:REMOTE_ADDR:REMOTE_PORT "
              "SERVER_ADDR[:SERVER_PORT]/TOKEN\n"
-             "             -p REMOTE_ADDR:REMOTE_PORT "
+             "             -p [-n STREAMS] REMOTE_ADDR:REMOTE_PORT "
              "SERVER_ADDR[:SERVER_PORT]/TOKEN\n"
              "Socks v5:\n"
              "  Forwarder: -f -x SERVER_ADDR[:SERVER_PORT/TOKEN]\n"
@@ -130,40 +136,7 @@ error:
 }
 
 static int
-set_addr_list (HevFshConfig *config, const char *str, int action)
-{
-    const char *addr = NULL;
-    const char *port = NULL;
-    char iaddr[16] = { 0 };
-    int nport;
-    char *b;
-
-    b = parse_addr (str, &addr, &port, NULL);
-    if (!b || !addr || !port) {
-        free (b);
-        return -1;
-    }
-
-    nport = htons (atoi (port));
-    if (inet_pton (AF_INET, addr, &iaddr[12]) == 1) {
-        ((uint16_t *)iaddr)[5] = 0xffff;
-        hev_fsh_config_addr_list_add (config, 4, &iaddr[12], nport, action);
-        hev_fsh_config_addr_list_add (config, 6, iaddr, nport, action);
-    } else {
-        if (inet_pton (AF_INET6, addr, iaddr) != 1) {
-            free (b);
-            return -1;
-        }
-        hev_fsh_config_addr_list_add (config, 6, iaddr, nport, action);
-        if (IN6_IS_ADDR_V4MAPPED ((struct in6_addr *)iaddr))
-            hev_fsh_config_addr_list_add (config, 4, &iaddr[12], nport, action);
-    }
-
-    return 0;
-}
-
-static int
-parse_set_addr_list (HevFshConfig *config, const char *str, int action)
+parse_set_addr_list (HevFshAcl *acl, const char *str, int action)
 {
     int s = 0;
 
@@ -178,7 +151,7 @@ parse_set_addr_list (HevFshConfig *config, const char *str, int action)
             break;
         default:
             if (s == 0) {
-                if (set_addr_list (config, str, action) < 0)
+                if (hev_fsh_acl_add_rule (acl, str, action) < 0)
                     return -1;
                 s = 1;
             } else {
@@ -321,8 +294,25 @@ parse_server (HevFshConfig *config, const char *sa)
 }
 
 static int
-parse_client (HevFshConfig *config, int f, int p, int x, const char *t1,
-              const char *t2, const char *w, const char *b, const char *u)
+parse_set_stripes (HevFshConfig *config, HevFshContext *context)
+{
+    HevFshStripes *stripes;
+    unsigned int timeout;
+
+    timeout = hev_fsh_config_get_timeout (config) * 1000;
+    stripes = hev_fsh_stripes_new (timeout);
+    if (!stripes)
+        return -1;
+    hev_fsh_context_set_stripes (context, stripes);
+
+    return 0;
+}
+
+static int
+parse_client (HevFshConfig *config, HevFshContext *context, int f, int p,
+              int x, const char *t1, const char *t2, const char *w,
+              const char *b, const char *u, unsigned int S, unsigned int g,
+              unsigned int n)
 {
     const char *addr = NULL;
     const char *port = NULL;
@@ -348,25 +338,65 @@ parse_client (HevFshConfig *config, int f, int p, int x, const char *t1,
 
     if (f) {
         if (p) {
+            HevFshUpstreamPool *pool;
+            HevFshDnsCache *cache;
+            unsigned int timeout;
+            HevFshAcl *acl;
+
             if (w && b)
                 return -1;
 
-            if (w) {
-                hev_fsh_config_addr_list_add (config, 0, NULL, 0, 0);
-                if (parse_set_addr_list (config, w, 1) < 0)
-                    return -1;
-            } else if (b) {
-                hev_fsh_config_addr_list_add (config, 0, NULL, 0, 1);
-                if (parse_set_addr_list (config, b, 0) < 0)
-                    return -1;
-            } else {
-                hev_fsh_config_addr_list_add (config, 0, NULL, 0, 1);
-            }
+            acl = hev_fsh_acl_new (w ? 0 : HEV_FSH_ACL_ALLOW);
+            if (!acl)
+                return -1;
+            hev_fsh_context_set_acl (context, acl);
+
+            if (w && parse_set_addr_list (acl, w, HEV_FSH_ACL_ALLOW) < 0)
+                return -1;
+            if (b && parse_set_addr_list (acl, b, 0) < 0)
+                return -1;
+
+            timeout = hev_fsh_config_get_timeout (config) * 1000;
+            pool = hev_fsh_upstream_pool_new (timeout, timeout);
+            if (!pool)
+                return -1;
+            hev_fsh_context_set_upstream_pool (context, pool);
+
+            cache = hev_fsh_dns_cache_new (HEV_FSH_DNS_CACHE_TTL);
+            if (!cache)
+                return -1;
+            hev_fsh_context_set_dns_cache (context, cache);
+
+            if (parse_set_stripes (config, context) < 0)
+                return -1;
             mode = HEV_FSH_CONFIG_MODE_FORWARDER_PORT;
         } else if (x) {
+            HevFshDnsCache *cache;
+
+            /* names in CONNECT requests and UDP datagrams */
+            cache = hev_fsh_dns_cache_new (HEV_FSH_DNS_CACHE_TTL);
+            if (!cache)
+                return -1;
+            hev_fsh_context_set_dns_cache (context, cache);
             mode = HEV_FSH_CONFIG_MODE_FORWARDER_SOCK;
         } else {
             hev_fsh_config_set_user (config, u);
+            if (S) {
+                HevFshShellPool *pool;
+
+                pool = hev_fsh_shell_pool_new (u, S);
+                if (!pool)
+                    return -1;
+                hev_fsh_context_set_shell_pool (context, pool);
+            }
+            if (g) {
+                HevFshTermSessions *sessions;
+
+                sessions = hev_fsh_term_sessions_new (g);
+                if (!sessions)
+                    return -1;
+                hev_fsh_context_set_term_sessions (context, sessions);
+            }
             mode = HEV_FSH_CONFIG_MODE_FORWARDER_TERM;
         }
     } else {
@@ -376,6 +406,13 @@ parse_client (HevFshConfig *config, int f, int p, int x, const char *t1,
         if (p) {
             if (parse_set_addr_pair (config, ap) < 0)
                 return -1;
+            if (n > HEV_TASK_IO_STRIPE_MAX)
+                return -1;
+            if (n > 1) {
+                hev_fsh_config_set_streams (config, n);
+                if (parse_set_stripes (config, context) < 0)
+                    return -1;
+            }
             mode = HEV_FSH_CONFIG_MODE_CONNECTOR_PORT;
         } else if (x) {
             if (parse_set_addr (config, ap) < 0)
@@ -395,6 +432,7 @@ static int
 parse_key (HevFshConfig *config, const char *key, int ugly_ktls)
 {
 #ifdef __linux__
+    unsigned char buf[41];
     HevFshConfigKey k;
     int res;
     int fd;
@@ -403,14 +441,27 @@ parse_key (HevFshConfig *config, const char *key, int ugly_ktls)
     if (fd < 0)
         return -1;
 
-    res = read (fd, &k, sizeof (k));
-    if (res != sizeof (k)) {
-        close (fd);
+    res = read (fd, buf, sizeof (buf));
+    close (fd);
+
+    /* "fsh" ciphers key[32] salt[4] */
+    if (res >= 40 && memcmp (buf, "fsh", 3) == 0) {
+        k.ciphers = buf[3] & HEV_FSH_CONFIG_CIPHER_ALL;
+        if (!k.ciphers)
+            k.ciphers = HEV_FSH_CONFIG_CIPHER_ALL;
+        memcpy (k.key, buf + 4, 32);
+        memcpy (k.salt, buf + 36, 4);
+    }
+    /* legacy: key[16] salt[4], trailing bytes ignored as before */
+    else if (res >= 20) {
+        k.ciphers = 0;
+        memcpy (k.key, buf, 16);
+        memcpy (k.salt, buf + 16, 4);
+    } else {
         return -1;
     }
 
     hev_fsh_config_set_key (config, &k, ugly_ktls);
-    close (fd);
 
     return 0;
 #else
@@ -419,7 +470,35 @@ parse_key (HevFshConfig *config, const char *key, int ugly_ktls)
 }
 
 static int
-parse_args (HevFshConfig *config, int argc, char *argv[])
+parse_buf_size (HevFshConfig *config, const char *str)
+{
+    unsigned long min, max;
+    char *end;
+
+    min = strtoul (str, &end, 10);
+    if (!min)
+        return -1;
+
+    if (*end == ':') {
+        max = strtoul (end + 1, &end, 10);
+        if (!max)
+            return -1;
+    } else {
+        max = min;
+    }
+
+    if (*end != '\0')
+        return -1;
+
+    hev_fsh_config_set_buf_min (config, min);
+    hev_fsh_config_set_buf_max (config, max);
+
+    return 0;
+}
+
+static int
+parse_args (HevFshConfig *config, HevFshContext *context, int argc,
+            char *argv[])
 {
     int opt;
     int v = 0;
@@ -428,15 +507,20 @@ parse_args (HevFshConfig *config, int argc, char *argv[])
     int p = 0;
     int x = 0;
     int U = 0;
+    unsigned int S = 0;
+    unsigned int g = 0;
+    unsigned int n = 0;
     const char *k = NULL;
     const char *l = NULL;
+    const char *B = NULL;
     const char *u = NULL;
     const char *w = NULL;
     const char *b = NULL;
     const char *t1 = NULL;
     const char *t2 = NULL;
 
-    while ((opt = getopt (argc, argv, "46k:t:vsfpxl:u:w:b:a:c:")) != -1) {
+    while ((opt = getopt (argc, argv,
+                          "46k:t:vsfpxl:u:w:b:a:c:m:B:iI:URzS:g:en:M")) != -1) {
         switch (opt) {
         case '4':
             hev_fsh_config_set_ip_type (config, 4);
@@ -483,9 +567,44 @@ parse_args (HevFshConfig *config, int argc, char *argv[])
         case 'c':
             hev_fsh_config_set_tcp_cc (config, optarg);
             break;
+        case 'm':
+            hev_fsh_config_set_pool_size (config, strtoul (optarg, NULL, 10));
+            break;
+        case 'B':
+            B = optarg;
+            break;
+        case 'i':
+            hev_fsh_config_set_io_uring (config, 1);
+            break;
+        case 'I':
+            hev_fsh_config_set_io_uring (config, 1);
+            hev_fsh_config_set_uring_tunnels (config,
+                                              strtoul (optarg, NULL, 10));
+            break;
         case 'U':
             U = 1;
             break;
+        case 'R':
+            hev_fsh_config_set_relay (config, 1);
+            break;
+        case 'z':
+            hev_fsh_config_set_compress (config, 1);
+            break;
+        case 'S':
+            S = strtoul (optarg, NULL, 10);
+            break;
+        case 'g':
+            g = strtoul (optarg, NULL, 10);
+            break;
+        case 'e':
+            hev_fsh_config_set_predict (config, 1);
+            break;
+        case 'n':
+            n = strtoul (optarg, NULL, 10);
+            break;
+        case 'M':
+            hev_fsh_config_set_mptcp (config, 1);
+            break;
         default:
             return -1;
         }
@@ -500,7 +619,8 @@ parse_args (HevFshConfig *config, int argc, char *argv[])
         if (parse_server (config, t1) < 0)
             return -1;
     } else {
-        if (parse_client (config, f, p, x, t1, t2, w, b, u) < 0)
+        if (parse_client (config, context, f, p, x, t1, t2, w, b, u, S, g,
+                          n) < 0)
             return -1;
     }
 
@@ -509,6 +629,11 @@ parse_args (HevFshConfig *config, int argc, char *argv[])
             return -1;
     }
 
+    if (B) {
+        if (parse_buf_size (config, B) < 0)
+            return -1;
+    }
+
     hev_fsh_config_set_log_path (config, l);
     if (v)
         hev_fsh_config_set_log_level (config, HEV_LOGGER_DEBUG);
@@ -548,6 +673,7 @@ int
 main (int argc, char *argv[])
 {
     HevFshConfig *config = NULL;
+    HevFshContext *context = NULL;
     const char *path;
     int timeout;
     int level;
@@ -560,7 +686,11 @@ main (int argc, char *argv[])
     if (!config)
         return -1;
 
-    if (parse_args (config, argc, argv) < 0) {
+    context = hev_fsh_context_new ();
+    if (!context)
+        return -1;
+
+    if (parse_args (config, context, argc, argv) < 0) {
         show_help ();
         return -1;
     }
@@ -573,6 +703,8 @@ main (int argc, char *argv[])
     timeout = hev_fsh_config_get_timeout (config);
     timeout *= 1000;
 
+    hev_object_pool_set_high_watermark (hev_fsh_config_get_pool_size (config));
+
     if (hev_logger_init (level, path) < 0)
         return -1;
 
@@ -580,6 +712,14 @@ main (int argc, char *argv[])
     hev_socks5_set_tcp_timeout (timeout);
     hev_socks5_set_udp_timeout (timeout);
 
+    if (hev_fsh_config_get_io_uring (config)) {
+        size_t size = hev_fsh_config_get_buf_min (config);
+        unsigned int tunnels = hev_fsh_config_get_uring_tunnels (config);
+
+        if (hev_task_io_uring_init (size, tunnels) < 0)
+            LOG_W ("io_uring unavailable, using poll");
+    }
+
     if (signal (SIGPIPE, SIG_IGN) == SIG_ERR)
         return -1;
     if (signal (SIGINT, signal_handler) == SIG_ERR)
@@ -592,7 +732,7 @@ main (int argc, char *argv[])
     if (HEV_FSH_CONFIG_MODE_SERVER == mode)
         instance = hev_fsh_server_new (config);
     else
-        instance = hev_fsh_client_new (config);
+        instance = hev_fsh_client_new (config, context);
 
     if (!instance)
         return -1;
@@ -602,7 +742,9 @@ main (int argc, char *argv[])
     hev_task_system_run ();
 
     hev_object_unref (HEV_OBJECT (instance));
+    hev_fsh_context_destroy (context);
     hev_fsh_config_destroy (config);
+    hev_object_pool_purge ();
     hev_task_system_fini ();
     hev_logger_fini ();
 
@@ -0,0 +1,722 @@
+/*
+ ============================================================================
+ Name        : hev-aead.c
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : AEAD ciphers (AES-GCM, ChaCha20-Poly1305)
+ ============================================================================
+ */
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define HEV_AEAD_AESNI
+#endif
+
+#include "hev-aead.h"
+
+typedef uint32_t v4u32 __attribute__ ((vector_size (16)));
+
+static inline uint32_t
+load32_le (const unsigned char *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+           ((uint32_t)p[3] << 24);
+}
+
+static inline void
+store32_le (unsigned char *p, uint32_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+static inline void
+store64_le (unsigned char *p, uint64_t v)
+{
+    store32_le (p, v);
+    store32_le (p + 4, v >> 32);
+}
+
+static int
+hev_aead_memneq (const unsigned char *a, const unsigned char *b, size_t len)
+{
+    unsigned char d = 0;
+    size_t i;
+
+    for (i = 0; i < len; i++)
+        d |= a[i] ^ b[i];
+
+    return d;
+}
+
+/* ChaCha20 (RFC 8439), four blocks per pass in 128-bit vector lanes. */
+
+#define ROTL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+#define QR(a, b, c, d)                                                         \
+    a += b;                                                                    \
+    d ^= a;                                                                    \
+    d = ROTL (d, 16);                                                          \
+    c += d;                                                                    \
+    b ^= c;                                                                    \
+    b = ROTL (b, 12);                                                          \
+    a += b;                                                                    \
+    d ^= a;                                                                    \
+    d = ROTL (d, 8);                                                           \
+    c += d;                                                                    \
+    b ^= c;                                                                    \
+    b = ROTL (b, 7);
+
+#define DOUBLE_ROUND(x)                                                        \
+    QR (x[0], x[4], x[8], x[12]);                                              \
+    QR (x[1], x[5], x[9], x[13]);                                              \
+    QR (x[2], x[6], x[10], x[14]);                                             \
+    QR (x[3], x[7], x[11], x[15]);                                             \
+    QR (x[0], x[5], x[10], x[15]);                                             \
+    QR (x[1], x[6], x[11], x[12]);                                             \
+    QR (x[2], x[7], x[8], x[13]);                                              \
+    QR (x[3], x[4], x[9], x[14]);
+
+static void
+chacha20_init (uint32_t s[16], const unsigned char *key,
+               const unsigned char *nonce, uint32_t counter)
+{
+    int i;
+
+    s[0] = 0x61707865;
+    s[1] = 0x3320646e;
+    s[2] = 0x79622d32;
+    s[3] = 0x6b206574;
+    for (i = 0; i < 8; i++)
+        s[4 + i] = load32_le (key + i * 4);
+    s[12] = counter;
+    s[13] = load32_le (nonce);
+    s[14] = load32_le (nonce + 4);
+    s[15] = load32_le (nonce + 8);
+}
+
+static void
+chacha20_block (const uint32_t s[16], unsigned char out[64])
+{
+    uint32_t x[16];
+    int i;
+
+    memcpy (x, s, sizeof (x));
+    for (i = 0; i < 10; i++) {
+        DOUBLE_ROUND (x);
+    }
+    for (i = 0; i < 16; i++)
+        store32_le (out + i * 4, x[i] + s[i]);
+}
+
+static void
+chacha20_blocks4 (const uint32_t s[16], unsigned char *data)
+{
+    const v4u32 inc = { 0, 1, 2, 3 };
+    v4u32 x[16], o[16];
+    int i, b;
+
+    for (i = 0; i < 16; i++)
+        o[i] = (v4u32){ s[i], s[i], s[i], s[i] };
+    o[12] += inc;
+
+    memcpy (x, o, sizeof (x));
+    for (i = 0; i < 10; i++) {
+        DOUBLE_ROUND (x);
+    }
+
+    for (i = 0; i < 16; i++)
+        x[i] += o[i];
+
+    for (b = 0; b < 4; b++) {
+        for (i = 0; i < 16; i++) {
+            unsigned char *p = data + b * 64 + i * 4;
+            store32_le (p, load32_le (p) ^ x[i][b]);
+        }
+    }
+}
+
+static void
+chacha20_xor (const unsigned char *key, const unsigned char *nonce,
+              uint32_t counter, unsigned char *data, size_t len)
+{
+    unsigned char ks[64];
+    uint32_t s[16];
+    size_t i;
+
+    chacha20_init (s, key, nonce, counter);
+
+    for (; len >= 256; len -= 256, data += 256) {
+        chacha20_blocks4 (s, data);
+        s[12] += 4;
+    }
+
+    while (len) {
+        size_t n = len < 64 ? len : 64;
+
+        chacha20_block (s, ks);
+        for (i = 0; i < n; i++)
+            data[i] ^= ks[i];
+        s[12]++;
+        data += n;
+        len -= n;
+    }
+}
+
+/* Poly1305, 26-bit limbs. */
+
+typedef struct _Poly1305 Poly1305;
+
+struct _Poly1305
+{
+    uint32_t r[5];
+    uint32_t h[5];
+    uint32_t pad[4];
+};
+
+static void
+poly1305_init (Poly1305 *p, const unsigned char key[32])
+{
+    uint32_t t0 = load32_le (key + 0);
+    uint32_t t1 = load32_le (key + 4);
+    uint32_t t2 = load32_le (key + 8);
+    uint32_t t3 = load32_le (key + 12);
+
+    p->r[0] = t0 & 0x3ffffff;
+    p->r[1] = ((t0 >> 26) | (t1 << 6)) & 0x3ffff03;
+    p->r[2] = ((t1 >> 20) | (t2 << 12)) & 0x3ffc0ff;
+    p->r[3] = ((t2 >> 14) | (t3 << 18)) & 0x3f03fff;
+    p->r[4] = (t3 >> 8) & 0x00fffff;
+
+    memset (p->h, 0, sizeof (p->h));
+
+    p->pad[0] = load32_le (key + 16);
+    p->pad[1] = load32_le (key + 20);
+    p->pad[2] = load32_le (key + 24);
+    p->pad[3] = load32_le (key + 28);
+}
+
+static void
+poly1305_blocks (Poly1305 *p, const unsigned char *m, size_t len)
+{
+    const uint32_t r0 = p->r[0], r1 = p->r[1], r2 = p->r[2];
+    const uint32_t r3 = p->r[3], r4 = p->r[4];
+    const uint32_t s1 = r1 * 5, s2 = r2 * 5, s3 = r3 * 5, s4 = r4 * 5;
+    uint32_t h0 = p->h[0], h1 = p->h[1], h2 = p->h[2];
+    uint32_t h3 = p->h[3], h4 = p->h[4];
+
+    for (; len >= 16; len -= 16, m += 16) {
+        uint64_t d0, d1, d2, d3, d4;
+        uint32_t c;
+
+        h0 += load32_le (m + 0) & 0x3ffffff;
+        h1 += (load32_le (m + 3) >> 2) & 0x3ffffff;
+        h2 += (load32_le (m + 6) >> 4) & 0x3ffffff;
+        h3 += (load32_le (m + 9) >> 6) & 0x3ffffff;
+        h4 += (load32_le (m + 12) >> 8) | (1 << 24);
+
+        d0 = (uint64_t)h0 * r0 + (uint64_t)h1 * s4 + (uint64_t)h2 * s3 +
+             (uint64_t)h3 * s2 + (uint64_t)h4 * s1;
+        d1 = (uint64_t)h0 * r1 + (uint64_t)h1 * r0 + (uint64_t)h2 * s4 +
+             (uint64_t)h3 * s3 + (uint64_t)h4 * s2;
+        d2 = (uint64_t)h0 * r2 + (uint64_t)h1 * r1 + (uint64_t)h2 * r0 +
+             (uint64_t)h3 * s4 + (uint64_t)h4 * s3;
+        d3 = (uint64_t)h0 * r3 + (uint64_t)h1 * r2 + (uint64_t)h2 * r1 +
+             (uint64_t)h3 * r0 + (uint64_t)h4 * s4;
+        d4 = (uint64_t)h0 * r4 + (uint64_t)h1 * r3 + (uint64_t)h2 * r2 +
+             (uint64_t)h3 * r1 + (uint64_t)h4 * r0;
+
+        c = d0 >> 26;
+        h0 = d0 & 0x3ffffff;
+        d1 += c;
+        c = d1 >> 26;
+        h1 = d1 & 0x3ffffff;
+        d2 += c;
+        c = d2 >> 26;
+        h2 = d2 & 0x3ffffff;
+        d3 += c;
+        c = d3 >> 26;
+        h3 = d3 & 0x3ffffff;
+        d4 += c;
+        c = d4 >> 26;
+        h4 = d4 & 0x3ffffff;
+        h0 += c * 5;
+        c = h0 >> 26;
+        h0 &= 0x3ffffff;
+        h1 += c;
+    }
+
+    p->h[0] = h0;
+    p->h[1] = h1;
+    p->h[2] = h2;
+    p->h[3] = h3;
+    p->h[4] = h4;
+}
+
+/* Feed len bytes, zero-padded to a 16-byte boundary as RFC 8439 wants. */
+static void
+poly1305_update_padded (Poly1305 *p, const unsigned char *m, size_t len)
+{
+    unsigned char block[16];
+    size_t n = len & ~(size_t)15;
+
+    poly1305_blocks (p, m, n);
+    if (len == n)
+        return;
+
+    memset (block, 0, sizeof (block));
+    memcpy (block, m + n, len - n);
+    poly1305_blocks (p, block, 16);
+}
+
+static void
+poly1305_finish (Poly1305 *p, unsigned char tag[16])
+{
+    uint32_t h0 = p->h[0], h1 = p->h[1], h2 = p->h[2];
+    uint32_t h3 = p->h[3], h4 = p->h[4];
+    uint32_t g0, g1, g2, g3, g4;
+    uint32_t c, mask;
+    uint64_t f;
+
+    c = h1 >> 26;
+    h1 &= 0x3ffffff;
+    h2 += c;
+    c = h2 >> 26;
+    h2 &= 0x3ffffff;
+    h3 += c;
+    c = h3 >> 26;
+    h3 &= 0x3ffffff;
+    h4 += c;
+    c = h4 >> 26;
+    h4 &= 0x3ffffff;
+    h0 += c * 5;
+    c = h0 >> 26;
+    h0 &= 0x3ffffff;
+    h1 += c;
+
+    /* h - p, selected in constant time if non-negative */
+    g0 = h0 + 5;
+    c = g0 >> 26;
+    g0 &= 0x3ffffff;
+    g1 = h1 + c;
+    c = g1 >> 26;
+    g1 &= 0x3ffffff;
+    g2 = h2 + c;
+    c = g2 >> 26;
+    g2 &= 0x3ffffff;
+    g3 = h3 + c;
+    c = g3 >> 26;
+    g3 &= 0x3ffffff;
+    g4 = h4 + c - (1 << 26);
+
+    mask = (g4 >> 31) - 1;
+    h0 = (h0 & ~mask) | (g0 & mask);
+    h1 = (h1 & ~mask) | (g1 & mask);
+    h2 = (h2 & ~mask) | (g2 & mask);
+    h3 = (h3 & ~mask) | (g3 & mask);
+    h4 = (h4 & ~mask) | (g4 & mask);
+
+    h0 = h0 | (h1 << 26);
+    h1 = (h1 >> 6) | (h2 << 20);
+    h2 = (h2 >> 12) | (h3 << 14);
+    h3 = (h3 >> 18) | (h4 << 8);
+
+    f = (uint64_t)h0 + p->pad[0];
+    store32_le (tag + 0, f);
+    f = (uint64_t)h1 + p->pad[1] + (f >> 32);
+    store32_le (tag + 4, f);
+    f = (uint64_t)h2 + p->pad[2] + (f >> 32);
+    store32_le (tag + 8, f);
+    f = (uint64_t)h3 + p->pad[3] + (f >> 32);
+    store32_le (tag + 12, f);
+}
+
+static void
+chacha20_poly1305_tag (HevAEAD *self, const unsigned char *nonce,
+                       const unsigned char *aad, size_t aad_len,
+                       const unsigned char *data, size_t len,
+                       unsigned char *tag)
+{
+    unsigned char block[64];
+    uint32_t s[16];
+    Poly1305 p;
+
+    chacha20_init (s, self->key, nonce, 0);
+    chacha20_block (s, block);
+    poly1305_init (&p, block);
+
+    poly1305_update_padded (&p, aad, aad_len);
+    poly1305_update_padded (&p, data, len);
+    store64_le (block, aad_len);
+    store64_le (block + 8, len);
+    poly1305_blocks (&p, block, 16);
+
+    poly1305_finish (&p, tag);
+}
+
+/* AES-GCM on AES-NI and PCLMULQDQ. */
+
+#ifdef HEV_AEAD_AESNI
+
+#define HEV_AEAD_TARGET __attribute__ ((target ("aes,pclmul,ssse3")))
+
+static HEV_AEAD_TARGET __m128i
+aes_128_assist (__m128i k, __m128i t)
+{
+    t = _mm_shuffle_epi32 (t, 0xff);
+    k = _mm_xor_si128 (k, _mm_slli_si128 (k, 4));
+    k = _mm_xor_si128 (k, _mm_slli_si128 (k, 4));
+    k = _mm_xor_si128 (k, _mm_slli_si128 (k, 4));
+    return _mm_xor_si128 (k, t);
+}
+
+static HEV_AEAD_TARGET __m128i
+aes_256_assist (__m128i k, __m128i t)
+{
+    t = _mm_shuffle_epi32 (t, 0xaa);
+    k = _mm_xor_si128 (k, _mm_slli_si128 (k, 4));
+    k = _mm_xor_si128 (k, _mm_slli_si128 (k, 4));
+    k = _mm_xor_si128 (k, _mm_slli_si128 (k, 4));
+    return _mm_xor_si128 (k, t);
+}
+
+#define AES_128_EXPAND(rk, i, rcon)                                            \
+    rk[i] = aes_128_assist (rk[i - 1],                                         \
+                            _mm_aeskeygenassist_si128 (rk[i - 1], rcon))
+
+#define AES_256_EXPAND(rk, i, rcon)                                            \
+    rk[i] = aes_128_assist (rk[i - 2],                                         \
+                            _mm_aeskeygenassist_si128 (rk[i - 1], rcon));      \
+    if (i + 1 < 15)                                                            \
+        rk[i + 1] = aes_256_assist (                                           \
+            rk[i - 1], _mm_aeskeygenassist_si128 (rk[i], 0));
+
+static HEV_AEAD_TARGET void
+aes_expand_128 (__m128i rk[11], const unsigned char *key)
+{
+    rk[0] = _mm_loadu_si128 ((const __m128i *)key);
+    AES_128_EXPAND (rk, 1, 0x01);
+    AES_128_EXPAND (rk, 2, 0x02);
+    AES_128_EXPAND (rk, 3, 0x04);
+    AES_128_EXPAND (rk, 4, 0x08);
+    AES_128_EXPAND (rk, 5, 0x10);
+    AES_128_EXPAND (rk, 6, 0x20);
+    AES_128_EXPAND (rk, 7, 0x40);
+    AES_128_EXPAND (rk, 8, 0x80);
+    AES_128_EXPAND (rk, 9, 0x1b);
+    AES_128_EXPAND (rk, 10, 0x36);
+}
+
+static HEV_AEAD_TARGET void
+aes_expand_256 (__m128i rk[15], const unsigned char *key)
+{
+    rk[0] = _mm_loadu_si128 ((const __m128i *)key);
+    rk[1] = _mm_loadu_si128 ((const __m128i *)(key + 16));
+    AES_256_EXPAND (rk, 2, 0x01);
+    AES_256_EXPAND (rk, 4, 0x02);
+    AES_256_EXPAND (rk, 6, 0x04);
+    AES_256_EXPAND (rk, 8, 0x08);
+    AES_256_EXPAND (rk, 10, 0x10);
+    AES_256_EXPAND (rk, 12, 0x20);
+    AES_256_EXPAND (rk, 14, 0x40);
+}
+
+static HEV_AEAD_TARGET __m128i
+aes_encrypt (const __m128i *rk, int rounds, __m128i b)
+{
+    int i;
+
+    b = _mm_xor_si128 (b, rk[0]);
+    for (i = 1; i < rounds; i++)
+        b = _mm_aesenc_si128 (b, rk[i]);
+    return _mm_aesenclast_si128 (b, rk[rounds]);
+}
+
+/* Carry-less multiply in GF(2^128), operands byte-reflected. */
+static HEV_AEAD_TARGET __m128i
+gf_mul (__m128i a, __m128i b)
+{
+    __m128i t2, t3, t4, t5, t6, t7, t8, t9;
+
+    t3 = _mm_clmulepi64_si128 (a, b, 0x00);
+    t4 = _mm_clmulepi64_si128 (a, b, 0x10);
+    t5 = _mm_clmulepi64_si128 (a, b, 0x01);
+    t6 = _mm_clmulepi64_si128 (a, b, 0x11);
+
+    t4 = _mm_xor_si128 (t4, t5);
+    t5 = _mm_slli_si128 (t4, 8);
+    t4 = _mm_srli_si128 (t4, 8);
+    t3 = _mm_xor_si128 (t3, t5);
+    t6 = _mm_xor_si128 (t6, t4);
+
+    /* shift the 256-bit product left by one */
+    t7 = _mm_srli_epi32 (t3, 31);
+    t8 = _mm_srli_epi32 (t6, 31);
+    t3 = _mm_slli_epi32 (t3, 1);
+    t6 = _mm_slli_epi32 (t6, 1);
+    t9 = _mm_srli_si128 (t7, 12);
+    t8 = _mm_slli_si128 (t8, 4);
+    t7 = _mm_slli_si128 (t7, 4);
+    t3 = _mm_or_si128 (t3, t7);
+    t6 = _mm_or_si128 (t6, t8);
+    t6 = _mm_or_si128 (t6, t9);
+
+    /* reduce modulo x^128 + x^7 + x^2 + x + 1 */
+    t7 = _mm_slli_epi32 (t3, 31);
+    t8 = _mm_slli_epi32 (t3, 30);
+    t9 = _mm_slli_epi32 (t3, 25);
+    t7 = _mm_xor_si128 (t7, t8);
+    t7 = _mm_xor_si128 (t7, t9);
+    t8 = _mm_srli_si128 (t7, 4);
+    t7 = _mm_slli_si128 (t7, 12);
+    t3 = _mm_xor_si128 (t3, t7);
+
+    t2 = _mm_srli_epi32 (t3, 1);
+    t4 = _mm_srli_epi32 (t3, 2);
+    t5 = _mm_srli_epi32 (t3, 7);
+    t2 = _mm_xor_si128 (t2, t4);
+    t2 = _mm_xor_si128 (t2, t5);
+    t2 = _mm_xor_si128 (t2, t8);
+    t3 = _mm_xor_si128 (t3, t2);
+
+    return _mm_xor_si128 (t6, t3);
+}
+
+static HEV_AEAD_TARGET __m128i
+ghash_padded (__m128i x, __m128i h, const unsigned char *m, size_t len)
+{
+    const __m128i bswap = _mm_set_epi8 (0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11,
+                                        12, 13, 14, 15);
+    unsigned char block[16];
+    __m128i b;
+
+    for (; len >= 16; len -= 16, m += 16) {
+        b = _mm_loadu_si128 ((const __m128i *)m);
+        x = gf_mul (_mm_xor_si128 (x, _mm_shuffle_epi8 (b, bswap)), h);
+    }
+
+    if (len) {
+        memset (block, 0, sizeof (block));
+        memcpy (block, m, len);
+        b = _mm_loadu_si128 ((const __m128i *)block);
+        x = gf_mul (_mm_xor_si128 (x, _mm_shuffle_epi8 (b, bswap)), h);
+    }
+
+    return x;
+}
+
+static HEV_AEAD_TARGET void
+aes_gcm_init (HevAEAD *self, const unsigned char *key)
+{
+    const __m128i bswap = _mm_set_epi8 (0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11,
+                                        12, 13, 14, 15);
+    __m128i *rk = (__m128i *)self->key;
+    __m128i h;
+
+    if (self->type == HEV_AEAD_AES_128_GCM) {
+        self->rounds = 10;
+        aes_expand_128 (rk, key);
+    } else {
+        self->rounds = 14;
+        aes_expand_256 (rk, key);
+    }
+
+    h = aes_encrypt (rk, self->rounds, _mm_setzero_si128 ());
+    _mm_store_si128 ((__m128i *)self->h, _mm_shuffle_epi8 (h, bswap));
+}
+
+static HEV_AEAD_TARGET void
+aes_gcm_ctr (HevAEAD *self, __m128i j0, unsigned char *data, size_t len)
+{
+    const __m128i bswap = _mm_set_epi8 (0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11,
+                                        12, 13, 14, 15);
+    const __m128i *rk = (const __m128i *)self->key;
+    const __m128i one = _mm_set_epi32 (0, 0, 0, 1);
+    const int rounds = self->rounds;
+    unsigned char block[16];
+    __m128i ctr, k[4], *p;
+    size_t i;
+    int r;
+
+    /* byte-swapped, the big-endian counter word is lane 0 */
+    ctr = _mm_add_epi32 (_mm_shuffle_epi8 (j0, bswap), one);
+
+    for (; len >= 64; len -= 64, data += 64) {
+        for (i = 0; i < 4; i++) {
+            k[i] = _mm_xor_si128 (_mm_shuffle_epi8 (ctr, bswap), rk[0]);
+            ctr = _mm_add_epi32 (ctr, one);
+        }
+        for (r = 1; r < rounds; r++) {
+            k[0] = _mm_aesenc_si128 (k[0], rk[r]);
+            k[1] = _mm_aesenc_si128 (k[1], rk[r]);
+            k[2] = _mm_aesenc_si128 (k[2], rk[r]);
+            k[3] = _mm_aesenc_si128 (k[3], rk[r]);
+        }
+        p = (__m128i *)data;
+        for (i = 0; i < 4; i++) {
+            __m128i b = _mm_aesenclast_si128 (k[i], rk[rounds]);
+            b = _mm_xor_si128 (b, _mm_loadu_si128 (p + i));
+            _mm_storeu_si128 (p + i, b);
+        }
+    }
+
+    while (len) {
+        size_t n = len < 16 ? len : 16;
+        __m128i c;
+
+        c = aes_encrypt (rk, rounds, _mm_shuffle_epi8 (ctr, bswap));
+        _mm_storeu_si128 ((__m128i *)block, c);
+        for (i = 0; i < n; i++)
+            data[i] ^= block[i];
+        ctr = _mm_add_epi32 (ctr, one);
+        data += n;
+        len -= n;
+    }
+}
+
+static HEV_AEAD_TARGET void
+aes_gcm_tag (HevAEAD *self, __m128i j0, const unsigned char *aad,
+             size_t aad_len, const unsigned char *data, size_t len,
+             unsigned char *tag)
+{
+    const __m128i bswap = _mm_set_epi8 (0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11,
+                                        12, 13, 14, 15);
+    const __m128i *rk = (const __m128i *)self->key;
+    __m128i h = _mm_load_si128 ((const __m128i *)self->h);
+    __m128i x = _mm_setzero_si128 ();
+    __m128i l;
+
+    x = ghash_padded (x, h, aad, aad_len);
+    x = ghash_padded (x, h, data, len);
+    l = _mm_set_epi64x ((uint64_t)aad_len * 8, (uint64_t)len * 8);
+    x = gf_mul (_mm_xor_si128 (x, l), h);
+
+    x = _mm_shuffle_epi8 (x, bswap);
+    x = _mm_xor_si128 (x, aes_encrypt (rk, self->rounds, j0));
+    _mm_storeu_si128 ((__m128i *)tag, x);
+}
+
+static HEV_AEAD_TARGET __m128i
+aes_gcm_j0 (const unsigned char *nonce)
+{
+    unsigned char block[16];
+
+    memcpy (block, nonce, 12);
+    block[12] = 0;
+    block[13] = 0;
+    block[14] = 0;
+    block[15] = 1;
+
+    return _mm_loadu_si128 ((const __m128i *)block);
+}
+
+static int
+aes_gcm_supported (void)
+{
+    static int supported = -1;
+    unsigned int a, b, c, d;
+
+    if (supported < 0) {
+        supported = 0;
+        if (__get_cpuid (1, &a, &b, &c, &d))
+            supported = (c & bit_AES) && (c & bit_PCLMUL) && (c & bit_SSSE3);
+    }
+
+    return supported;
+}
+
+#endif /* HEV_AEAD_AESNI */
+
+int
+hev_aead_supported (HevAEADType type)
+{
+    switch (type) {
+    case HEV_AEAD_CHACHA20_POLY1305:
+        return 1;
+    case HEV_AEAD_AES_128_GCM:
+    case HEV_AEAD_AES_256_GCM:
+#ifdef HEV_AEAD_AESNI
+        return aes_gcm_supported ();
+#endif
+    default:
+        return 0;
+    }
+}
+
+int
+hev_aead_init (HevAEAD *self, HevAEADType type, const unsigned char *key)
+{
+    if (!hev_aead_supported (type))
+        return -1;
+
+    self->type = type;
+
+    switch (type) {
+    case HEV_AEAD_CHACHA20_POLY1305:
+        memcpy (self->key, key, 32);
+        break;
+    default:
+#ifdef HEV_AEAD_AESNI
+        aes_gcm_init (self, key);
+#endif
+        break;
+    }
+
+    return 0;
+}
+
+void
+hev_aead_seal (HevAEAD *self, const unsigned char *nonce,
+               const unsigned char *aad, size_t aad_len, unsigned char *data,
+               size_t len, unsigned char *tag)
+{
+    if (self->type == HEV_AEAD_CHACHA20_POLY1305) {
+        chacha20_xor (self->key, nonce, 1, data, len);
+        chacha20_poly1305_tag (self, nonce, aad, aad_len, data, len, tag);
+        return;
+    }
+
+#ifdef HEV_AEAD_AESNI
+    {
+        __m128i j0 = aes_gcm_j0 (nonce);
+
+        aes_gcm_ctr (self, j0, data, len);
+        aes_gcm_tag (self, j0, aad, aad_len, data, len, tag);
+    }
+#endif
+}
+
+int
+hev_aead_open (HevAEAD *self, const unsigned char *nonce,
+               const unsigned char *aad, size_t aad_len, unsigned char *data,
+               size_t len, const unsigned char *tag)
+{
+    unsigned char calc[HEV_AEAD_TAG_SIZE];
+
+    if (self->type == HEV_AEAD_CHACHA20_POLY1305) {
+        chacha20_poly1305_tag (self, nonce, aad, aad_len, data, len, calc);
+        if (hev_aead_memneq (calc, tag, sizeof (calc)))
+            return -1;
+        chacha20_xor (self->key, nonce, 1, data, len);
+        return 0;
+    }
+
+#ifdef HEV_AEAD_AESNI
+    {
+        __m128i j0 = aes_gcm_j0 (nonce);
+
+        aes_gcm_tag (self, j0, aad, aad_len, data, len, calc);
+        if (hev_aead_memneq (calc, tag, sizeof (calc)))
+            return -1;
+        aes_gcm_ctr (self, j0, data, len);
+        return 0;
+    }
+#else
+    return -1;
+#endif
+}
@@ -0,0 +1,62 @@
+/*
+ ============================================================================
+ Name        : hev-aead.h
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : AEAD ciphers (AES-GCM, ChaCha20-Poly1305)
+ ============================================================================
+ */
+
+#ifndef __HEV_AEAD_H__
+#define __HEV_AEAD_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HEV_AEAD_NONCE_SIZE (12)
+#define HEV_AEAD_TAG_SIZE (16)
+
+typedef struct _HevAEAD HevAEAD;
+typedef enum _HevAEADType HevAEADType;
+
+enum _HevAEADType
+{
+    HEV_AEAD_AES_128_GCM,
+    HEV_AEAD_AES_256_GCM,
+    HEV_AEAD_CHACHA20_POLY1305,
+};
+
+struct _HevAEAD
+{
+    HevAEADType type;
+    int rounds;
+
+    /* AES round keys or ChaCha20 key, and the GHASH key */
+    unsigned char key[15 * 16] __attribute__ ((aligned (16)));
+    unsigned char h[16] __attribute__ ((aligned (16)));
+};
+
+/* Non-zero if this CPU has an implementation of the given type. */
+int hev_aead_supported (HevAEADType type);
+
+int hev_aead_init (HevAEAD *self, HevAEADType type, const unsigned char *key);
+
+/* In-place encrypt of data[len], appending nothing: the tag goes to tag. */
+void hev_aead_seal (HevAEAD *self, const unsigned char *nonce,
+                    const unsigned char *aad, size_t aad_len,
+                    unsigned char *data, size_t len, unsigned char *tag);
+
+/* In-place decrypt of data[len]; -1 and data undefined on a tag mismatch. */
+int hev_aead_open (HevAEAD *self, const unsigned char *nonce,
+                   const unsigned char *aad, size_t aad_len,
+                   unsigned char *data, size_t len, const unsigned char *tag);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HEV_AEAD_H__ */
@@ -0,0 +1,227 @@
+/*
+ ============================================================================
+ Name        : hev-hkdf.c
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : HKDF-SHA256 (RFC 5869)
+ ============================================================================
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "hev-hkdf.h"
+
+#define SHA256_BLOCK_SIZE (64)
+#define SHA256_DIGEST_SIZE (32)
+
+typedef struct _HevSHA256 HevSHA256;
+
+struct _HevSHA256
+{
+    uint32_t h[8];
+    uint64_t len;
+    unsigned char buf[SHA256_BLOCK_SIZE];
+    size_t use;
+};
+
+static const uint32_t k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static inline uint32_t
+ror (uint32_t x, int n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+static void
+sha256_block (HevSHA256 *self, const unsigned char *p)
+{
+    uint32_t w[64];
+    uint32_t a, b, c, d, e, f, g, h;
+    int i;
+
+    for (i = 0; i < 16; i++)
+        w[i] = (uint32_t)p[i * 4] << 24 | (uint32_t)p[i * 4 + 1] << 16 |
+               (uint32_t)p[i * 4 + 2] << 8 | p[i * 4 + 3];
+
+    for (; i < 64; i++) {
+        uint32_t s0, s1;
+
+        s0 = ror (w[i - 15], 7) ^ ror (w[i - 15], 18) ^ (w[i - 15] >> 3);
+        s1 = ror (w[i - 2], 17) ^ ror (w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    a = self->h[0];
+    b = self->h[1];
+    c = self->h[2];
+    d = self->h[3];
+    e = self->h[4];
+    f = self->h[5];
+    g = self->h[6];
+    h = self->h[7];
+
+    for (i = 0; i < 64; i++) {
+        uint32_t t1, t2;
+
+        t1 = h + (ror (e, 6) ^ ror (e, 11) ^ ror (e, 25)) +
+             ((e & f) ^ (~e & g)) + k[i] + w[i];
+        t2 = (ror (a, 2) ^ ror (a, 13) ^ ror (a, 22)) +
+             ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    self->h[0] += a;
+    self->h[1] += b;
+    self->h[2] += c;
+    self->h[3] += d;
+    self->h[4] += e;
+    self->h[5] += f;
+    self->h[6] += g;
+    self->h[7] += h;
+}
+
+static void
+sha256_init (HevSHA256 *self)
+{
+    static const uint32_t iv[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+
+    memcpy (self->h, iv, sizeof (iv));
+    self->len = 0;
+    self->use = 0;
+}
+
+static void
+sha256_update (HevSHA256 *self, const void *data, size_t size)
+{
+    const unsigned char *p = data;
+
+    self->len += size;
+
+    while (size) {
+        size_t n = SHA256_BLOCK_SIZE - self->use;
+
+        if (n > size)
+            n = size;
+
+        memcpy (self->buf + self->use, p, n);
+        self->use += n;
+        p += n;
+        size -= n;
+
+        if (self->use == SHA256_BLOCK_SIZE) {
+            sha256_block (self, self->buf);
+            self->use = 0;
+        }
+    }
+}
+
+static void
+sha256_final (HevSHA256 *self, unsigned char *out)
+{
+    uint64_t bits = self->len * 8;
+    unsigned char pad[SHA256_BLOCK_SIZE + 8] = { 0x80 };
+    unsigned char len[8];
+    size_t n;
+    int i;
+
+    n = (self->use < 56) ? 56 - self->use : 120 - self->use;
+    for (i = 0; i < 8; i++)
+        len[i] = bits >> (56 - i * 8);
+
+    sha256_update (self, pad, n);
+    sha256_update (self, len, sizeof (len));
+
+    for (i = 0; i < 8; i++) {
+        out[i * 4] = self->h[i] >> 24;
+        out[i * 4 + 1] = self->h[i] >> 16;
+        out[i * 4 + 2] = self->h[i] >> 8;
+        out[i * 4 + 3] = self->h[i];
+    }
+}
+
+static void
+hmac_sha256 (const void *key, size_t key_len, const void *d1, size_t l1,
+             const void *d2, size_t l2, const void *d3, size_t l3,
+             unsigned char *out)
+{
+    unsigned char kb[SHA256_BLOCK_SIZE] = { 0 };
+    unsigned char pad[SHA256_BLOCK_SIZE];
+    HevSHA256 ctx;
+    int i;
+
+    if (key_len > SHA256_BLOCK_SIZE) {
+        sha256_init (&ctx);
+        sha256_update (&ctx, key, key_len);
+        sha256_final (&ctx, kb);
+    } else {
+        memcpy (kb, key, key_len);
+    }
+
+    for (i = 0; i < SHA256_BLOCK_SIZE; i++)
+        pad[i] = kb[i] ^ 0x36;
+
+    sha256_init (&ctx);
+    sha256_update (&ctx, pad, sizeof (pad));
+    sha256_update (&ctx, d1, l1);
+    sha256_update (&ctx, d2, l2);
+    sha256_update (&ctx, d3, l3);
+    sha256_final (&ctx, out);
+
+    for (i = 0; i < SHA256_BLOCK_SIZE; i++)
+        pad[i] = kb[i] ^ 0x5c;
+
+    sha256_init (&ctx);
+    sha256_update (&ctx, pad, sizeof (pad));
+    sha256_update (&ctx, out, SHA256_DIGEST_SIZE);
+    sha256_final (&ctx, out);
+}
+
+void
+hev_hkdf_sha256 (const void *salt, size_t salt_len, const void *ikm,
+                 size_t ikm_len, const void *info, size_t info_len, void *okm,
+                 size_t okm_len)
+{
+    unsigned char prk[SHA256_DIGEST_SIZE];
+    unsigned char t[SHA256_DIGEST_SIZE];
+    unsigned char *out = okm;
+    unsigned char c;
+    size_t t_len = 0;
+
+    /* extract */
+    hmac_sha256 (salt, salt_len, ikm, ikm_len, NULL, 0, NULL, 0, prk);
+
+    /* expand */
+    for (c = 1; okm_len; c++) {
+        size_t n = okm_len < SHA256_DIGEST_SIZE ? okm_len : SHA256_DIGEST_SIZE;
+
+        hmac_sha256 (prk, sizeof (prk), t, t_len, info, info_len, &c, 1, t);
+        t_len = SHA256_DIGEST_SIZE;
+
+        memcpy (out, t, n);
+        out += n;
+        okm_len -= n;
+    }
+}
@@ -0,0 +1,19 @@
+/*
+ ============================================================================
+ Name        : hev-hkdf.h
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : HKDF-SHA256 (RFC 5869)
+ ============================================================================
+ */
+
+#ifndef __HEV_HKDF_H__
+#define __HEV_HKDF_H__
+
+#include <stddef.h>
+
+void hev_hkdf_sha256 (const void *salt, size_t salt_len, const void *ikm,
+                      size_t ikm_len, const void *info, size_t info_len,
+                      void *okm, size_t okm_len);
+
+#endif /* __HEV_HKDF_H__ */
@@ -0,0 +1,212 @@
+/*
+ ============================================================================
+ Name        : hev-lz4.c
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : LZ4 block format codec
+ ============================================================================
+ */
+
+#include <string.h>
+
+#include "hev-lz4.h"
+
+#define LZ4_MIN_MATCH (4)
+#define LZ4_LAST_LITERALS (5)
+#define LZ4_MF_LIMIT (12)
+#define LZ4_SKIP_TRIGGER (6)
+
+static inline uint32_t
+read32 (const unsigned char *p)
+{
+    uint32_t v;
+
+    memcpy (&v, p, sizeof (v));
+    return v;
+}
+
+static inline unsigned int
+hash32 (uint32_t v)
+{
+    return (v * 2654435761u) >> (32 - 12);
+}
+
+static unsigned char *
+write_length (unsigned char *op, size_t len)
+{
+    for (; len >= 255; len -= 255)
+        *op++ = 255;
+    *op++ = len;
+
+    return op;
+}
+
+/* token, literals, and for mlen != 0 the offset and match length */
+static unsigned char *
+write_sequence (unsigned char *op, unsigned char *oend,
+                const unsigned char *lit, size_t lit_len, size_t off,
+                size_t mlen)
+{
+    unsigned char *token = op++;
+    size_t need;
+
+    need = 1 + lit_len / 255 + 1 + lit_len + 2 + mlen / 255 + 1;
+    if (need > (size_t)(oend - token))
+        return NULL;
+
+    if (lit_len >= 15) {
+        *token = 15 << 4;
+        op = write_length (op, lit_len - 15);
+    } else {
+        *token = lit_len << 4;
+    }
+
+    memcpy (op, lit, lit_len);
+    op += lit_len;
+
+    if (!mlen)
+        return op;
+
+    *op++ = off;
+    *op++ = off >> 8;
+
+    mlen -= LZ4_MIN_MATCH;
+    if (mlen >= 15) {
+        *token |= 15;
+        op = write_length (op, mlen - 15);
+    } else {
+        *token |= mlen;
+    }
+
+    return op;
+}
+
+size_t
+hev_lz4_compress (const unsigned char *src, size_t len, unsigned char *dst,
+                  size_t cap, uint16_t *table)
+{
+    unsigned char *op = dst;
+    unsigned char *oend = dst + cap;
+    size_t anchor = 0;
+    size_t ip = 0;
+
+    if (len > HEV_LZ4_BLOCK_MAX)
+        return 0;
+
+    if (len > LZ4_MF_LIMIT) {
+        const size_t limit = len - LZ4_MF_LIMIT;
+        const size_t mlimit = len - LZ4_LAST_LITERALS;
+        unsigned int attempts = 1 << LZ4_SKIP_TRIGGER;
+
+        memset (table, 0, sizeof (uint16_t) * HEV_LZ4_HASH_SIZE);
+
+        for (ip = 1; ip < limit;) {
+            unsigned int h = hash32 (read32 (src + ip));
+            size_t ref = table[h];
+            size_t mlen;
+
+            table[h] = ip;
+            if (ref >= ip || read32 (src + ref) != read32 (src + ip)) {
+                /* step faster through data that does not match */
+                ip += attempts++ >> LZ4_SKIP_TRIGGER;
+                continue;
+            }
+            attempts = 1 << LZ4_SKIP_TRIGGER;
+
+            while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1]) {
+                ip--;
+                ref--;
+            }
+
+            mlen = LZ4_MIN_MATCH;
+            while (ip + mlen < mlimit && src[ip + mlen] == src[ref + mlen])
+                mlen++;
+
+            op = write_sequence (op, oend, src + anchor, ip - anchor, ip - ref,
+                                 mlen);
+            if (!op)
+                return 0;
+
+            ip += mlen;
+            anchor = ip;
+            if (ip < limit)
+                table[hash32 (read32 (src + ip - 2))] = ip - 2;
+        }
+    }
+
+    op = write_sequence (op, oend, src + anchor, len - anchor, 0, 0);
+    if (!op)
+        return 0;
+
+    return op - dst;
+}
+
+long
+hev_lz4_decompress (const unsigned char *src, size_t len, unsigned char *dst,
+                    size_t cap)
+{
+    const unsigned char *ip = src;
+    const unsigned char *iend = src + len;
+    unsigned char *op = dst;
+    unsigned char *oend = dst + cap;
+
+    while (ip < iend) {
+        unsigned int token = *ip++;
+        size_t lit = token >> 4;
+        size_t mlen = token & 15;
+        size_t off;
+
+        if (lit == 15) {
+            unsigned int b;
+
+            do {
+                if (ip >= iend)
+                    return -1;
+                b = *ip++;
+                lit += b;
+            } while (b == 255);
+        }
+
+        if (lit > (size_t)(iend - ip) || lit > (size_t)(oend - op))
+            return -1;
+        memcpy (op, ip, lit);
+        ip += lit;
+        op += lit;
+
+        /* the last sequence has literals only */
+        if (ip == iend)
+            break;
+
+        if (iend - ip < 2)
+            return -1;
+        off = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (!off || off > (size_t)(op - dst))
+            return -1;
+
+        if (mlen == 15) {
+            unsigned int b;
+
+            do {
+                if (ip >= iend)
+                    return -1;
+                b = *ip++;
+                mlen += b;
+            } while (b == 255);
+        }
+        mlen += LZ4_MIN_MATCH;
+
+        if (mlen > (size_t)(oend - op))
+            return -1;
+
+        if (off >= mlen) {
+            memcpy (op, op - off, mlen);
+            op += mlen;
+        } else {
+            for (; mlen; mlen--, op++)
+                *op = *(op - off);
+        }
+    }
+
+    return op - dst;
+}
@@ -0,0 +1,40 @@
+/*
+ ============================================================================
+ Name        : hev-lz4.h
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : LZ4 block format codec
+ ============================================================================
+ */
+
+#ifndef __HEV_LZ4_H__
+#define __HEV_LZ4_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HEV_LZ4_BLOCK_MAX (65536)
+#define HEV_LZ4_HASH_SIZE (4096)
+#define HEV_LZ4_BOUND(n) ((n) + (n) / 255 + 16)
+
+/*
+ * Compresses one independent block of at most HEV_LZ4_BLOCK_MAX bytes; table
+ * is HEV_LZ4_HASH_SIZE entries of scratch. Returns the compressed size, or 0
+ * if it would not fit in cap.
+ */
+size_t hev_lz4_compress (const unsigned char *src, size_t len,
+                         unsigned char *dst, size_t cap, uint16_t *table);
+
+/* Returns the decompressed size, or -1 on a malformed or oversized block. */
+long hev_lz4_decompress (const unsigned char *src, size_t len,
+                         unsigned char *dst, size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HEV_LZ4_H__ */
@@ -0,0 +1,136 @@
+/*
+ ============================================================================
+ Name        : hev-object-pool.c
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Object pool
+ ============================================================================
+ */
+
+#include <string.h>
+
+#include <hev-memory-allocator.h>
+
+#include "hev-object-pool.h"
+
+#define HEV_OBJECT_POOL_LISTS (32)
+
+typedef union _HevObjectPoolHead HevObjectPoolHead;
+typedef struct _HevObjectPoolList HevObjectPoolList;
+
+union _HevObjectPoolHead
+{
+    HevObjectPoolHead *next;
+    size_t size;
+    unsigned char align[16];
+};
+
+struct _HevObjectPoolList
+{
+    size_t size;
+    unsigned int count;
+    HevObjectPoolHead *head;
+};
+
+static unsigned int high_watermark = 64;
+static __thread HevObjectPoolList lists[HEV_OBJECT_POOL_LISTS];
+
+static HevObjectPoolList *
+hev_object_pool_list_get (size_t size)
+{
+    int i;
+
+    for (i = 0; i < HEV_OBJECT_POOL_LISTS; i++) {
+        HevObjectPoolList *list = &lists[i];
+
+        if (list->size == size)
+            return list;
+
+        if (list->size == 0) {
+            list->size = size;
+            return list;
+        }
+    }
+
+    return NULL;
+}
+
+void *
+hev_object_pool_malloc (size_t size)
+{
+    HevObjectPoolList *list;
+    HevObjectPoolHead *head;
+
+    list = hev_object_pool_list_get (size);
+    if (list && list->head) {
+        head = list->head;
+        list->head = head->next;
+        list->count--;
+    } else {
+        head = hev_malloc (sizeof (HevObjectPoolHead) + size);
+        if (!head)
+            return NULL;
+    }
+
+    head->size = size;
+
+    return head + 1;
+}
+
+void *
+hev_object_pool_malloc0 (size_t size)
+{
+    void *ptr;
+
+    ptr = hev_object_pool_malloc (size);
+    if (ptr)
+        memset (ptr, 0, size);
+
+    return ptr;
+}
+
+void
+hev_object_pool_free (void *ptr)
+{
+    HevObjectPoolList *list;
+    HevObjectPoolHead *head;
+
+    if (!ptr)
+        return;
+
+    head = (HevObjectPoolHead *)ptr - 1;
+    list = hev_object_pool_list_get (head->size);
+    if (!list || list->count >= high_watermark) {
+        hev_free (head);
+        return;
+    }
+
+    head->next = list->head;
+    list->head = head;
+    list->count++;
+}
+
+void
+hev_object_pool_set_high_watermark (unsigned int count)
+{
+    high_watermark = count;
+}
+
+void
+hev_object_pool_purge (void)
+{
+    int i;
+
+    for (i = 0; i < HEV_OBJECT_POOL_LISTS; i++) {
+        HevObjectPoolList *list = &lists[i];
+
+        while (list->head) {
+            HevObjectPoolHead *head = list->head;
+
+            list->head = head->next;
+            hev_free (head);
+        }
+
+        list->count = 0;
+    }
+}
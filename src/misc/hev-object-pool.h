@@ -0,0 +1,30 @@
+/*
+ ============================================================================
+ Name        : hev-object-pool.h
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Object pool
+ ============================================================================
+ */
+
+#ifndef __HEV_OBJECT_POOL_H__
+#define __HEV_OBJECT_POOL_H__
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void *hev_object_pool_malloc (size_t size);
+void *hev_object_pool_malloc0 (size_t size);
+void hev_object_pool_free (void *ptr);
+
+void hev_object_pool_set_high_watermark (unsigned int count);
+void hev_object_pool_purge (void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HEV_OBJECT_POOL_H__ */
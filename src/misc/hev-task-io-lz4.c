@@ -0,0 +1,301 @@
+/*
+ ============================================================================
+ Name        : hev-task-io-lz4.c
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Task I/O operations (LZ4 compressed stream)
+ ============================================================================
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include <hev-task.h>
+#include <hev-memory-allocator.h>
+
+#include "hev-lz4.h"
+#include "hev-logger.h"
+#include "hev-task-io-pump.h"
+
+#include "hev-task-io-lz4.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL (0)
+#endif
+
+/* frame: type, reserved, big-endian payload length, payload */
+#define LZ4_HEADER_SIZE (4)
+#define LZ4_BLOCK_SIZE (16384)
+#define LZ4_FRAME_MAX (LZ4_HEADER_SIZE + HEV_LZ4_BOUND (LZ4_BLOCK_SIZE))
+
+#define LZ4_TYPE_RAW (0)
+#define LZ4_TYPE_LZ4 (1)
+
+/* keystrokes and the like are not worth a try */
+#define LZ4_MIN_SIZE (64)
+/* blocks sent raw after one that did not shrink (already compressed data) */
+#define LZ4_BACKOFF (16)
+
+typedef struct _HevTaskIOLZ4 HevTaskIOLZ4;
+typedef struct _HevTaskIOLZ4Dir HevTaskIOLZ4Dir;
+
+struct _HevTaskIOLZ4Dir
+{
+    size_t rp;
+    size_t use;
+
+    /* rx: payload of the frame at rp still to be written out */
+    unsigned char *out;
+    size_t out_len;
+    size_t rec;
+
+    size_t bytes;
+    size_t wire;
+
+    unsigned int eof : 1;
+    unsigned int done : 1;
+};
+
+struct _HevTaskIOLZ4
+{
+    HevTaskIOPump base;
+
+    unsigned int backoff;
+
+    HevTaskIOLZ4Dir tx;
+    HevTaskIOLZ4Dir rx;
+
+    uint16_t table[HEV_LZ4_HASH_SIZE];
+    unsigned char ibuf[LZ4_BLOCK_SIZE];
+    unsigned char obuf[LZ4_BLOCK_SIZE];
+    unsigned char tbuf[LZ4_FRAME_MAX];
+    unsigned char rbuf[LZ4_FRAME_MAX * 2];
+};
+
+static void
+task_io_lz4_pack (HevTaskIOLZ4 *self, size_t len)
+{
+    HevTaskIOLZ4Dir *d = &self->tx;
+    unsigned char *frame = self->tbuf;
+    unsigned char *data = frame + LZ4_HEADER_SIZE;
+    size_t clen = 0;
+
+    if (self->backoff) {
+        self->backoff--;
+    } else if (len >= LZ4_MIN_SIZE) {
+        clen = hev_lz4_compress (self->ibuf, len, data, len - 1, self->table);
+        if (!clen)
+            self->backoff = LZ4_BACKOFF;
+    }
+
+    if (clen) {
+        frame[0] = LZ4_TYPE_LZ4;
+    } else {
+        frame[0] = LZ4_TYPE_RAW;
+        memcpy (data, self->ibuf, len);
+        clen = len;
+    }
+
+    frame[1] = 0;
+    frame[2] = clen >> 8;
+    frame[3] = clen;
+
+    d->rp = 0;
+    d->use = LZ4_HEADER_SIZE + clen;
+    d->bytes += len;
+    d->wire += d->use;
+}
+
+/* Expand the whole frame at rx.rp; -1 on a bad frame. */
+static int
+task_io_lz4_unpack (HevTaskIOLZ4 *self, size_t len)
+{
+    HevTaskIOLZ4Dir *d = &self->rx;
+    unsigned char *frame = self->rbuf + d->rp;
+    unsigned char *data = frame + LZ4_HEADER_SIZE;
+    long res;
+
+    switch (frame[0]) {
+    case LZ4_TYPE_RAW:
+        d->out = data;
+        d->out_len = len;
+        break;
+    case LZ4_TYPE_LZ4:
+        res = hev_lz4_decompress (data, len, self->obuf, sizeof (self->obuf));
+        if (res < 0) {
+            LOG_E ("%p task io lz4 bad frame", self);
+            return -1;
+        }
+        d->out = self->obuf;
+        d->out_len = res;
+        break;
+    default:
+        return -1;
+    }
+
+    d->rec = LZ4_HEADER_SIZE + len;
+    d->bytes += d->out_len;
+    d->wire += d->rec;
+
+    return 0;
+}
+
+static int
+task_io_lz4_tx (HevTaskIOLZ4 *self)
+{
+    HevTaskIOLZ4Dir *d = &self->tx;
+    int progress = 0;
+    ssize_t s;
+
+    if (d->done)
+        return 0;
+
+    if (!d->use) {
+        if (d->eof) {
+            shutdown (self->base.fd, SHUT_WR);
+            d->done = 1;
+            return 1;
+        }
+
+        /* a short read means nothing more is pending: flush it now */
+        s = recv (self->base.pfd, self->ibuf, sizeof (self->ibuf), 0);
+        if (s == 0) {
+            d->eof = 1;
+            return 1;
+        }
+        if (s < 0)
+            return (errno == EAGAIN) ? 0 : -1;
+
+        task_io_lz4_pack (self, s);
+        progress = 1;
+    }
+
+    s = send (self->base.fd, self->tbuf + d->rp, d->use, MSG_NOSIGNAL);
+    if (s < 0)
+        return (errno == EAGAIN) ? progress : -1;
+
+    d->rp += s;
+    d->use -= s;
+
+    return 1;
+}
+
+static int
+task_io_lz4_rx (HevTaskIOLZ4 *self)
+{
+    HevTaskIOLZ4Dir *d = &self->rx;
+    size_t len;
+    ssize_t s;
+
+    if (d->done)
+        return 0;
+
+    if (d->out_len) {
+        s = send (self->base.pfd, d->out, d->out_len, MSG_NOSIGNAL);
+        if (s < 0)
+            return (errno == EAGAIN) ? 0 : -1;
+        d->out += s;
+        d->out_len -= s;
+        if (d->out_len)
+            return 1;
+    }
+
+    if (d->rec) {
+        d->rp += d->rec;
+        d->use -= d->rec;
+        d->rec = 0;
+        return 1;
+    }
+
+    if (d->use >= LZ4_HEADER_SIZE) {
+        unsigned char *frame = self->rbuf + d->rp;
+
+        len = (frame[2] << 8) | frame[3];
+        if (len > LZ4_FRAME_MAX - LZ4_HEADER_SIZE)
+            return -1;
+
+        if (d->use >= LZ4_HEADER_SIZE + len)
+            return (task_io_lz4_unpack (self, len) < 0) ? -1 : 1;
+    }
+
+    if (d->eof) {
+        if (d->use)
+            return -1;
+        shutdown (self->base.pfd, SHUT_WR);
+        d->done = 1;
+        return 1;
+    }
+
+    if (d->rp && (d->rp + LZ4_FRAME_MAX > sizeof (self->rbuf))) {
+        memmove (self->rbuf, self->rbuf + d->rp, d->use);
+        d->rp = 0;
+    }
+
+    s = recv (self->base.fd, self->rbuf + d->rp + d->use,
+              sizeof (self->rbuf) - d->rp - d->use, 0);
+    if (s == 0) {
+        d->eof = 1;
+        return 1;
+    }
+    if (s < 0)
+        return (errno == EAGAIN) ? 0 : -1;
+
+    d->use += s;
+
+    return 1;
+}
+
+static int
+task_io_lz4_step (HevTaskIOPump *base)
+{
+    HevTaskIOLZ4 *self = (HevTaskIOLZ4 *)base;
+    int tx, rx;
+
+    if (self->tx.done && self->rx.done)
+        return -1;
+
+    tx = task_io_lz4_tx (self);
+    rx = task_io_lz4_rx (self);
+    if ((tx < 0) || (rx < 0))
+        return -1;
+
+    return tx || rx;
+}
+
+static void
+task_io_lz4_done (HevTaskIOPump *base)
+{
+    HevTaskIOLZ4 *self = (HevTaskIOLZ4 *)base;
+
+    LOG_D ("%p task io lz4 done, tx %zu -> %zu bytes, rx %zu -> %zu bytes",
+           self, self->tx.bytes, self->tx.wire, self->rx.wire,
+           self->rx.bytes);
+
+    hev_free (self);
+}
+
+int
+hev_task_io_lz4_start (int fd, int stack_size, unsigned int timeout)
+{
+    HevTaskIOLZ4 *self;
+    int pfd;
+
+    self = hev_malloc0 (sizeof (HevTaskIOLZ4));
+    if (!self)
+        return -1;
+
+    self->base.step = task_io_lz4_step;
+    self->base.done = task_io_lz4_done;
+    pfd = hev_task_io_pump_start (&self->base, fd, stack_size, timeout);
+    if (pfd < 0) {
+        hev_free (self);
+        return -1;
+    }
+
+    LOG_D ("%p task io lz4 start", self);
+
+    return pfd;
+}
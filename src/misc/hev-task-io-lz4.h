@@ -0,0 +1,30 @@
+/*
+ ============================================================================
+ Name        : hev-task-io-lz4.h
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Task I/O operations (LZ4 compressed stream)
+ ============================================================================
+ */
+
+#ifndef __HEV_TASK_IO_LZ4_H__
+#define __HEV_TASK_IO_LZ4_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Run LZ4 framing for fd in a task of its own: whatever is pending on the
+ * returned end is sent as one frame as soon as no more is ready, so nothing
+ * waits on a timer. Returns the plain end of a socket pair to use in place
+ * of fd, or -1. On success fd belongs to that task, which gives up after
+ * timeout ms without traffic; the caller must not have fd registered.
+ */
+int hev_task_io_lz4_start (int fd, int stack_size, unsigned int timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HEV_TASK_IO_LZ4_H__ */
@@ -0,0 +1,632 @@
+/*
+ ============================================================================
+ Name        : hev-task-io-mux.c
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Task I/O operations (stream multiplexer)
+ ============================================================================
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include <hev-task.h>
+#include <hev-memory-allocator.h>
+
+#include "hev-logger.h"
+
+#include "hev-task-io-mux.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL (0)
+#endif
+
+#define MUX_HEADER_SIZE (8)
+#define MUX_FRAME_MAX (MUX_HEADER_SIZE + HEV_TASK_IO_MUX_FRAME)
+#define MUX_BUCKETS (64)
+/* tbuf kept free of data for RST and WINDOW_UPDATE */
+#define MUX_RESERVE (MUX_HEADER_SIZE * 64)
+#define MUX_ROUNDS (64)
+
+/* credit goes back in steps, not per frame */
+#define MUX_CREDIT_STEP (HEV_TASK_IO_MUX_WINDOW / 4)
+
+typedef struct _HevTaskIOMuxStream HevTaskIOMuxStream;
+
+struct _HevTaskIOMuxStream
+{
+    HevTaskIOMuxStream *prev;
+    HevTaskIOMuxStream *next;
+    HevTaskIOMuxStream *hnext;
+
+    unsigned int id;
+    unsigned int kind;
+    int fd;
+
+    /* to the peer: bytes it still has room for */
+    unsigned int credit;
+
+    /* from the peer: waiting for fd, and handed on but not credited back */
+    unsigned char *buf;
+    size_t cap;
+    size_t rp;
+    size_t use;
+    unsigned int consumed;
+
+    unsigned int opened : 1;
+    /* fd hit EOF and FIN is out; FIN came in; and was passed on to fd */
+    unsigned int lfin : 1;
+    unsigned int rfin : 1;
+    unsigned int shut : 1;
+    /* fd is closed, RST waits for room in tbuf */
+    unsigned int reset : 1;
+};
+
+struct _HevTaskIOMux
+{
+    HevTask *task;
+    HevTaskIOMuxAccept accept;
+    void *data;
+
+    HevTaskIOMuxStream *head;
+    HevTaskIOMuxStream *tail;
+    HevTaskIOMuxStream *buckets[MUX_BUCKETS];
+    unsigned int next_id;
+    unsigned int done : 1;
+
+    size_t trp;
+    size_t tuse;
+    size_t rrp;
+    size_t ruse;
+
+    unsigned char tbuf[MUX_FRAME_MAX * 4 + MUX_RESERVE];
+    unsigned char rbuf[MUX_FRAME_MAX * 2];
+};
+
+static unsigned int
+mux_get32 (const unsigned char *p)
+{
+    return ((unsigned int)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+static void
+mux_put32 (unsigned char *p, unsigned int v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+/* Free space for a frame of size bytes at the end of tbuf, or NULL. */
+static unsigned char *
+mux_tail (HevTaskIOMux *self, size_t size)
+{
+    if (self->trp && (self->trp + self->tuse + size > sizeof (self->tbuf))) {
+        memmove (self->tbuf, self->tbuf + self->trp, self->tuse);
+        self->trp = 0;
+    }
+
+    if (self->trp + self->tuse + size > sizeof (self->tbuf))
+        return NULL;
+
+    return self->tbuf + self->trp + self->tuse;
+}
+
+/* Like mux_tail, for OPEN and DATA: they leave the reserve alone. */
+static unsigned char *
+mux_tail_data (HevTaskIOMux *self, size_t size)
+{
+    if (!mux_tail (self, size + MUX_RESERVE))
+        return NULL;
+
+    return self->tbuf + self->trp + self->tuse;
+}
+
+/* Queues the frame whose payload has been put after its header at tail. */
+static void
+mux_commit (HevTaskIOMux *self, unsigned char *tail, int type,
+            unsigned int kind, unsigned int id, size_t len)
+{
+    tail[0] = type;
+    tail[1] = kind;
+    tail[2] = len >> 8;
+    tail[3] = len;
+    mux_put32 (tail + 4, id);
+
+    self->tuse += MUX_HEADER_SIZE + len;
+}
+
+static HevTaskIOMuxStream *
+mux_stream_find (HevTaskIOMux *self, unsigned int id)
+{
+    HevTaskIOMuxStream *s;
+
+    for (s = self->buckets[id % MUX_BUCKETS]; s; s = s->hnext)
+        if (s->id == id)
+            return s;
+
+    return NULL;
+}
+
+static HevTaskIOMuxStream *
+mux_stream_new (HevTaskIOMux *self, unsigned int id, int fd)
+{
+    HevTaskIOMuxStream *s;
+    unsigned int i = id % MUX_BUCKETS;
+
+    s = hev_malloc0 (sizeof (HevTaskIOMuxStream));
+    if (!s)
+        return NULL;
+
+    s->id = id;
+    s->fd = fd;
+    s->credit = HEV_TASK_IO_MUX_WINDOW;
+
+    s->hnext = self->buckets[i];
+    self->buckets[i] = s;
+
+    s->prev = self->tail;
+    if (self->tail)
+        self->tail->next = s;
+    else
+        self->head = s;
+    self->tail = s;
+
+    if (self->task)
+        hev_task_add_fd (self->task, fd, POLLIN | POLLOUT);
+
+    return s;
+}
+
+static void
+mux_stream_unlink (HevTaskIOMux *self, HevTaskIOMuxStream *s)
+{
+    HevTaskIOMuxStream **prev = &self->buckets[s->id % MUX_BUCKETS];
+
+    while (*prev != s)
+        prev = &(*prev)->hnext;
+    *prev = s->hnext;
+
+    if (s->prev)
+        s->prev->next = s->next;
+    else
+        self->head = s->next;
+    if (s->next)
+        s->next->prev = s->prev;
+    else
+        self->tail = s->prev;
+}
+
+static void
+mux_stream_close (HevTaskIOMux *self, HevTaskIOMuxStream *s)
+{
+    mux_stream_unlink (self, s);
+
+    if (s->fd >= 0) {
+        if (self->task)
+            hev_task_del_fd (self->task, s->fd);
+        close (s->fd);
+    }
+
+    if (s->buf)
+        hev_free (s->buf);
+    hev_free (s);
+}
+
+/* Sends RST for s and drops it: 1 if it has to wait for room, 0 if gone. */
+static int
+mux_stream_reset (HevTaskIOMux *self, HevTaskIOMuxStream *s)
+{
+    unsigned char *tail;
+
+    tail = mux_tail (self, MUX_HEADER_SIZE);
+    if (!tail && s->opened) {
+        /* the peer's end holds its connection until told */
+        if (s->fd >= 0) {
+            if (self->task)
+                hev_task_del_fd (self->task, s->fd);
+            close (s->fd);
+            s->fd = -1;
+        }
+        if (s->buf) {
+            hev_free (s->buf);
+            s->buf = NULL;
+        }
+        s->reset = 1;
+        return 1;
+    }
+
+    if (s->opened)
+        mux_commit (self, tail, HEV_TASK_IO_MUX_RST, 0, s->id, 0);
+    mux_stream_close (self, s);
+
+    return 0;
+}
+
+static int
+mux_stream_queue (HevTaskIOMuxStream *s, const unsigned char *data,
+                  size_t len)
+{
+    size_t need = s->use + len;
+
+    if (s->rp && (s->rp + need > s->cap)) {
+        memmove (s->buf, s->buf + s->rp, s->use);
+        s->rp = 0;
+    }
+
+    if (need > s->cap) {
+        size_t cap = s->cap ? s->cap : (HEV_TASK_IO_MUX_FRAME * 2);
+        unsigned char *buf;
+
+        /* grows with a slow reader, up to what the window lets in */
+        while (cap < need)
+            cap *= 2;
+
+        buf = hev_realloc (s->buf, cap);
+        if (!buf)
+            return -1;
+
+        s->buf = buf;
+        s->cap = cap;
+    }
+
+    memcpy (s->buf + s->rp + s->use, data, len);
+    s->use += len;
+
+    return 0;
+}
+
+static int
+mux_handle_data (HevTaskIOMux *self, HevTaskIOMuxStream *s,
+                 const unsigned char *data, size_t len)
+{
+    ssize_t w = 0;
+
+    /* all the peer may have out: buffered, or handed on but not credited */
+    if (s->use + s->consumed + len > HEV_TASK_IO_MUX_WINDOW) {
+        LOG_E ("%p task io mux window overrun", self);
+        return -1;
+    }
+
+    if (!s->use) {
+        w = write (s->fd, data, len);
+        if (w < 0) {
+            if (errno != EAGAIN)
+                return -1;
+            w = 0;
+        }
+        s->consumed += w;
+    }
+
+    if ((size_t)w == len)
+        return 0;
+
+    return mux_stream_queue (s, data + w, len - w);
+}
+
+static int
+mux_handle (HevTaskIOMux *self, const unsigned char *frame, size_t len)
+{
+    const unsigned char *data = frame + MUX_HEADER_SIZE;
+    unsigned int id = mux_get32 (frame + 4);
+    HevTaskIOMuxStream *s;
+    unsigned char *tail;
+    int fd;
+
+    s = mux_stream_find (self, id);
+
+    switch (frame[0]) {
+    case HEV_TASK_IO_MUX_OPEN:
+        if (s || !self->accept) {
+            LOG_E ("%p task io mux open", self);
+            return -1;
+        }
+        fd = self->accept (self->data, frame[1]);
+        if (fd >= 0)
+            s = mux_stream_new (self, id, fd);
+        if (s) {
+            s->opened = 1;
+            break;
+        }
+        if (fd >= 0)
+            close (fd);
+        /* the caller has made room for it */
+        tail = mux_tail (self, MUX_HEADER_SIZE);
+        mux_commit (self, tail, HEV_TASK_IO_MUX_RST, 0, id, 0);
+        break;
+    case HEV_TASK_IO_MUX_DATA:
+        /* streams reset here may still have data in flight */
+        if (!s || s->rfin || s->reset)
+            break;
+        if (mux_handle_data (self, s, data, len) < 0)
+            mux_stream_reset (self, s);
+        break;
+    case HEV_TASK_IO_MUX_FIN:
+        if (s)
+            s->rfin = 1;
+        break;
+    case HEV_TASK_IO_MUX_RST:
+        if (s)
+            mux_stream_close (self, s);
+        break;
+    case HEV_TASK_IO_MUX_WINDOW_UPDATE:
+        if (s && len >= 4)
+            s->credit += mux_get32 (data);
+        break;
+    }
+
+    return 0;
+}
+
+/* Moves what it can of one stream: 1 on progress, -1 once it is closed. */
+static int
+mux_stream_io (HevTaskIOMux *self, HevTaskIOMuxStream *s)
+{
+    unsigned char *tail;
+    int progress = 0;
+    ssize_t res;
+
+    if (s->reset)
+        return mux_stream_reset (self, s) ? 0 : -1;
+
+    if (!s->opened) {
+        tail = mux_tail_data (self, MUX_HEADER_SIZE);
+        if (!tail)
+            return 0;
+        mux_commit (self, tail, HEV_TASK_IO_MUX_OPEN, s->kind, s->id, 0);
+        s->opened = 1;
+        progress = 1;
+    }
+
+    if (s->use) {
+        res = write (s->fd, s->buf + s->rp, s->use);
+        if (res < 0 && errno != EAGAIN)
+            goto reset;
+        if (res > 0) {
+            s->rp += res;
+            s->use -= res;
+            s->consumed += res;
+            progress = 1;
+        }
+    }
+
+    if (s->consumed >= MUX_CREDIT_STEP) {
+        tail = mux_tail (self, MUX_HEADER_SIZE + 4);
+        if (tail) {
+            mux_put32 (tail + MUX_HEADER_SIZE, s->consumed);
+            mux_commit (self, tail, HEV_TASK_IO_MUX_WINDOW_UPDATE, 0, s->id,
+                        4);
+            s->consumed = 0;
+            progress = 1;
+        }
+    }
+
+    if (s->rfin && !s->use && !s->shut) {
+        shutdown (s->fd, SHUT_WR);
+        s->shut = 1;
+        progress = 1;
+    }
+
+    if (!s->lfin && s->credit) {
+        size_t len = HEV_TASK_IO_MUX_FRAME;
+
+        if (len > s->credit)
+            len = s->credit;
+
+        tail = mux_tail_data (self, MUX_HEADER_SIZE + len);
+        if (tail) {
+            res = read (s->fd, tail + MUX_HEADER_SIZE, len);
+            if (res < 0 && errno != EAGAIN)
+                goto reset;
+            if (res > 0) {
+                mux_commit (self, tail, HEV_TASK_IO_MUX_DATA, 0, s->id, res);
+                s->credit -= res;
+                progress = 1;
+            } else if (res == 0) {
+                mux_commit (self, tail, HEV_TASK_IO_MUX_FIN, 0, s->id, 0);
+                s->lfin = 1;
+                progress = 1;
+            }
+        }
+    }
+
+    if (s->lfin && s->shut) {
+        mux_stream_close (self, s);
+        return -1;
+    }
+
+    return progress;
+
+reset:
+    return mux_stream_reset (self, s) ? 0 : -1;
+}
+
+HevTaskIOMux *
+hev_task_io_mux_new (HevTaskIOMuxAccept accept, void *data)
+{
+    HevTaskIOMux *self;
+
+    self = hev_malloc0 (sizeof (HevTaskIOMux));
+    if (!self)
+        return NULL;
+
+    LOG_D ("%p task io mux new", self);
+
+    self->accept = accept;
+    self->data = data;
+    self->next_id = 1;
+
+    return self;
+}
+
+void
+hev_task_io_mux_destroy (HevTaskIOMux *self)
+{
+    LOG_D ("%p task io mux destroy", self);
+
+    while (self->head)
+        mux_stream_close (self, self->head);
+
+    hev_free (self);
+}
+
+int
+hev_task_io_mux_open (HevTaskIOMux *self, int fd, unsigned int kind)
+{
+    HevTaskIOMuxStream *s;
+
+    if (self->done)
+        return -1;
+
+    s = mux_stream_new (self, self->next_id, fd);
+    if (!s)
+        return -1;
+
+    s->kind = kind;
+    self->next_id++;
+    if (self->task)
+        hev_task_wakeup (self->task);
+
+    return 0;
+}
+
+int
+hev_task_io_mux_steal (HevTaskIOMux *self)
+{
+    HevTaskIOMuxStream *s;
+    int fd;
+
+    for (s = self->head; s; s = s->next)
+        if (!s->opened)
+            break;
+
+    if (!s)
+        return -1;
+
+    fd = s->fd;
+    mux_stream_unlink (self, s);
+    if (self->task)
+        hev_task_del_fd (self->task, fd);
+    hev_free (s);
+
+    return fd;
+}
+
+void
+hev_task_io_mux_run (HevTaskIOMux *self, int fd, HevTaskIOYielder yielder,
+                     void *yielder_data)
+{
+    HevTaskIOMuxStream *s;
+    int rounds = 0;
+
+    LOG_D ("%p task io mux run", self);
+
+    self->task = hev_task_self ();
+    for (s = self->head; s; s = s->next)
+        hev_task_add_fd (self->task, s->fd, POLLIN | POLLOUT);
+
+    for (;;) {
+        HevTaskIOMuxStream *next;
+        int progress = 0;
+        ssize_t res;
+
+        if (self->rrp &&
+            (self->rrp + self->ruse + MUX_FRAME_MAX > sizeof (self->rbuf))) {
+            memmove (self->rbuf, self->rbuf + self->rrp, self->ruse);
+            self->rrp = 0;
+        }
+
+        if (self->rrp + self->ruse < sizeof (self->rbuf)) {
+            res = recv (fd, self->rbuf + self->rrp + self->ruse,
+                        sizeof (self->rbuf) - self->rrp - self->ruse, 0);
+            if (res == 0 || (res < 0 && errno != EAGAIN))
+                break;
+            if (res > 0) {
+                self->ruse += res;
+                progress = 1;
+            }
+        }
+
+        while (self->ruse >= MUX_HEADER_SIZE) {
+            unsigned char *frame = self->rbuf + self->rrp;
+            size_t len = (frame[2] << 8) | frame[3];
+
+            if (len > HEV_TASK_IO_MUX_FRAME)
+                goto exit;
+            if (self->ruse < MUX_HEADER_SIZE + len)
+                break;
+            /* only a refused OPEN needs an answer: wait for room */
+            if (frame[0] == HEV_TASK_IO_MUX_OPEN &&
+                !mux_tail (self, MUX_HEADER_SIZE))
+                break;
+            if (mux_handle (self, frame, len) < 0)
+                goto exit;
+
+            self->rrp += MUX_HEADER_SIZE + len;
+            self->ruse -= MUX_HEADER_SIZE + len;
+            progress = 1;
+        }
+        if (!self->ruse)
+            self->rrp = 0;
+
+        for (s = self->head; s; s = next) {
+            next = s->next;
+            if (mux_stream_io (self, s))
+                progress = 1;
+        }
+
+        /* whoever went first lines up last: no stream hogs tbuf */
+        s = self->head;
+        if (s && s->next) {
+            self->head = s->next;
+            self->head->prev = NULL;
+            s->prev = self->tail;
+            s->next = NULL;
+            self->tail->next = s;
+            self->tail = s;
+        }
+
+        if (self->tuse) {
+            res = send (fd, self->tbuf + self->trp, self->tuse, MSG_NOSIGNAL);
+            if (res < 0 && errno != EAGAIN)
+                break;
+            if (res > 0) {
+                self->trp += res;
+                self->tuse -= res;
+                if (!self->tuse)
+                    self->trp = 0;
+                progress = 1;
+            }
+        }
+
+        if (progress) {
+            if (++rounds == MUX_ROUNDS) {
+                if (yielder)
+                    yielder (HEV_TASK_YIELD, yielder_data);
+                else
+                    hev_task_yield (HEV_TASK_YIELD);
+                rounds = 0;
+            }
+            continue;
+        }
+        rounds = 0;
+
+        if (yielder) {
+            if (yielder (HEV_TASK_WAITIO, yielder_data) < 0)
+                break;
+        } else {
+            hev_task_yield (HEV_TASK_WAITIO);
+        }
+    }
+
+exit:
+    LOG_D ("%p task io mux done", self);
+
+    self->done = 1;
+    while (self->head)
+        mux_stream_close (self, self->head);
+    self->task = NULL;
+}
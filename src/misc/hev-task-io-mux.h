@@ -0,0 +1,69 @@
+/*
+ ============================================================================
+ Name        : hev-task-io-mux.h
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Task I/O operations (stream multiplexer)
+ ============================================================================
+ */
+
+#ifndef __HEV_TASK_IO_MUX_H__
+#define __HEV_TASK_IO_MUX_H__
+
+#include <hev-task-io.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* bytes a stream may have in flight each way, and per frame */
+#define HEV_TASK_IO_MUX_WINDOW (262144)
+#define HEV_TASK_IO_MUX_FRAME (16384)
+
+/*
+ * Frames: type, a byte for OPEN to tell the kind of stream, big-endian
+ * 16-bit payload length and 32-bit stream id, payload. OPEN starts a
+ * stream, DATA carries its bytes, FIN ends one direction, RST aborts it,
+ * WINDOW returns 32-bit big-endian credit for bytes handed on. Streams are
+ * opened by one end only.
+ */
+#define HEV_TASK_IO_MUX_OPEN (0)
+#define HEV_TASK_IO_MUX_DATA (1)
+#define HEV_TASK_IO_MUX_FIN (2)
+#define HEV_TASK_IO_MUX_RST (3)
+#define HEV_TASK_IO_MUX_WINDOW_UPDATE (4)
+
+typedef struct _HevTaskIOMux HevTaskIOMux;
+
+/*
+ * A stream of kind the peer opened: returns the non-blocking fd to carry,
+ * or -1. It runs in the mux task and may wait there.
+ */
+typedef int (*HevTaskIOMuxAccept) (void *data, unsigned int kind);
+
+HevTaskIOMux *hev_task_io_mux_new (HevTaskIOMuxAccept accept, void *data);
+void hev_task_io_mux_destroy (HevTaskIOMux *self);
+
+/*
+ * Carries the non-blocking fd, taken over, as a new stream of kind (0 to
+ * 255); it is opened at once if the mux runs, else when it starts. Returns
+ * -1 once the mux has run, and the fd stays the caller's.
+ */
+int hev_task_io_mux_open (HevTaskIOMux *self, int fd, unsigned int kind);
+
+/* Takes back a stream not opened yet: its fd, or -1 if there is none. */
+int hev_task_io_mux_steal (HevTaskIOMux *self);
+
+/*
+ * Moves the streams over fd, registered with the current task, until it
+ * fails or the yielder gives up, then closes them all. A slow stream holds
+ * up no other: each has its own window.
+ */
+void hev_task_io_mux_run (HevTaskIOMux *self, int fd, HevTaskIOYielder yielder,
+                          void *yielder_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HEV_TASK_IO_MUX_H__ */
@@ -0,0 +1,85 @@
+/*
+ ============================================================================
+ Name        : hev-task-io-pump.c
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Task I/O operations (socket pair pump task)
+ ============================================================================
+ */
+
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include <hev-task.h>
+
+#include "hev-logger.h"
+
+#include "hev-task-io-pump.h"
+
+#define PUMP_ROUNDS (64)
+
+static void
+task_io_pump_entry (void *data)
+{
+    HevTaskIOPump *self = data;
+    HevTask *task = hev_task_self ();
+    int rounds = 0;
+
+    hev_task_add_fd (task, self->fd, POLLIN | POLLOUT);
+    hev_task_add_fd (task, self->pfd, POLLIN | POLLOUT);
+
+    for (;;) {
+        int res;
+
+        res = self->step (self);
+        if (res < 0)
+            break;
+
+        if (res) {
+            if (++rounds == PUMP_ROUNDS) {
+                hev_task_yield (HEV_TASK_YIELD);
+                rounds = 0;
+            }
+            continue;
+        }
+
+        /* a peer gone silent must not hold the fds and buffers forever */
+        rounds = 0;
+        if (hev_task_sleep (self->timeout) == 0) {
+            LOG_D ("%p task io pump timeout", self);
+            break;
+        }
+    }
+
+    hev_task_del_fd (task, self->fd);
+    hev_task_del_fd (task, self->pfd);
+    close (self->fd);
+    close (self->pfd);
+    self->done (self);
+}
+
+int
+hev_task_io_pump_start (HevTaskIOPump *self, int fd, int stack_size,
+                        unsigned int timeout)
+{
+    HevTask *task;
+    int fds[2];
+
+    if (socketpair (AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0,
+                    fds) < 0)
+        return -1;
+
+    task = hev_task_new (stack_size);
+    if (!task) {
+        close (fds[0]);
+        close (fds[1]);
+        return -1;
+    }
+
+    self->fd = fd;
+    self->pfd = fds[1];
+    self->timeout = timeout;
+    hev_task_run (task, task_io_pump_entry, self);
+
+    return fds[0];
+}
@@ -0,0 +1,50 @@
+/*
+ ============================================================================
+ Name        : hev-task-io-pump.h
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Task I/O operations (socket pair pump task)
+ ============================================================================
+ */
+
+#ifndef __HEV_TASK_IO_PUMP_H__
+#define __HEV_TASK_IO_PUMP_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct _HevTaskIOPump HevTaskIOPump;
+
+/* Moves what it can: 1 on progress, 0 if blocked, -1 once it is over. */
+typedef int (*HevTaskIOPumpStep) (HevTaskIOPump *self);
+/* Frees what embeds the pump, once the task is about to end. */
+typedef void (*HevTaskIOPumpDone) (HevTaskIOPump *self);
+
+/* Embedded first in the state of a stream filter run by the pump. */
+struct _HevTaskIOPump
+{
+    /* the wrapped fd, and the filter's end of the socket pair */
+    int fd;
+    int pfd;
+    unsigned int timeout;
+
+    HevTaskIOPumpStep step;
+    HevTaskIOPumpDone done;
+};
+
+/*
+ * Runs self->step for fd in a task of its own, between fd and a socket pair
+ * whose other end is returned, or -1. The task ends once step says so or
+ * nothing moves for timeout ms, as with the caller's own yielder: both fds
+ * are closed, then self->done is called. On success fd belongs to that
+ * task; the caller must not have it registered.
+ */
+int hev_task_io_pump_start (HevTaskIOPump *self, int fd, int stack_size,
+                            unsigned int timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HEV_TASK_IO_PUMP_H__ */
@@ -0,0 +1,135 @@
+/*
+ ============================================================================
+ Name        : hev-task-io-race.c
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Task I/O operations (racing connects)
+ ============================================================================
+ */
+
+#include <time.h>
+#include <errno.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <netinet/in.h>
+
+#include <hev-task.h>
+#include <hev-task-io.h>
+#include <hev-task-io-socket.h>
+
+#include "hev-task-io-race.h"
+
+static int64_t
+task_io_race_now (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static socklen_t
+task_io_race_len (const struct sockaddr_storage *addr)
+{
+    if (addr->ss_family == AF_INET6)
+        return sizeof (struct sockaddr_in6);
+
+    return sizeof (struct sockaddr_in);
+}
+
+/* 1 connected, 0 pending, -1 failed. */
+static int
+task_io_race_poll (int fd, const struct sockaddr_storage *addr)
+{
+    int res;
+
+    res = connect (fd, (struct sockaddr *)addr, task_io_race_len (addr));
+    if (res == 0 || errno == EISCONN)
+        return 1;
+    if (errno == EINPROGRESS || errno == EALREADY || errno == EINTR)
+        return 0;
+
+    return -1;
+}
+
+int
+hev_task_io_race_connect (const struct sockaddr_storage *addrs, int count,
+                          unsigned int delay, HevTaskIOYielder yielder,
+                          void *yielder_data)
+{
+    HevTask *task = hev_task_self ();
+    int fds[HEV_TASK_IO_RACE_MAX];
+    int started = 0;
+    int pending = 0;
+    int64_t next = 0;
+    int fd = -1;
+    int i;
+
+    if (count > HEV_TASK_IO_RACE_MAX)
+        count = HEV_TASK_IO_RACE_MAX;
+
+    for (;;) {
+        int64_t now = task_io_race_now ();
+
+        if (started < count && (!pending || now >= next)) {
+            const struct sockaddr_storage *addr = &addrs[started];
+            int s;
+
+            s = hev_task_io_socket_socket (addr->ss_family, SOCK_STREAM,
+                                           IPPROTO_TCP);
+            fds[started] = s;
+            if (s >= 0) {
+                hev_task_add_fd (task, s, POLLIN | POLLOUT);
+                pending++;
+            }
+            started++;
+            next = now + delay;
+        }
+
+        for (i = 0; i < started; i++) {
+            int res;
+
+            if (fds[i] < 0)
+                continue;
+
+            res = task_io_race_poll (fds[i], &addrs[i]);
+            if (res > 0) {
+                fd = fds[i];
+                fds[i] = -1;
+                goto exit;
+            }
+            if (res < 0) {
+                hev_task_del_fd (task, fds[i]);
+                close (fds[i]);
+                fds[i] = -1;
+                pending--;
+            }
+        }
+
+        if (!pending) {
+            if (started < count)
+                continue;
+            break;
+        }
+
+        if (started < count) {
+            hev_task_sleep (next - now);
+        } else if (yielder) {
+            if (yielder (HEV_TASK_WAITIO, yielder_data) < 0)
+                break;
+        } else {
+            hev_task_yield (HEV_TASK_WAITIO);
+        }
+    }
+
+exit:
+    for (i = 0; i < started; i++) {
+        if (fds[i] < 0)
+            continue;
+        hev_task_del_fd (task, fds[i]);
+        close (fds[i]);
+    }
+
+    return fd;
+}
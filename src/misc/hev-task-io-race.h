@@ -0,0 +1,38 @@
+/*
+ ============================================================================
+ Name        : hev-task-io-race.h
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Task I/O operations (racing connects)
+ ============================================================================
+ */
+
+#ifndef __HEV_TASK_IO_RACE_H__
+#define __HEV_TASK_IO_RACE_H__
+
+#include <sys/socket.h>
+
+#include <hev-task-io.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HEV_TASK_IO_RACE_MAX (8)
+#define HEV_TASK_IO_RACE_DELAY (250)
+
+/*
+ * Happy eyeballs (RFC 8305): connect to addrs in order, starting the next
+ * attempt every delay ms while earlier ones are still pending, and keep the
+ * first that completes. Returns it registered with the current task for
+ * POLLIN | POLLOUT, or -1 once all failed or the yielder gave up.
+ */
+int hev_task_io_race_connect (const struct sockaddr_storage *addrs,
+                              int count, unsigned int delay,
+                              HevTaskIOYielder yielder, void *yielder_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HEV_TASK_IO_RACE_H__ */
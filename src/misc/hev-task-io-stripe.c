@@ -0,0 +1,413 @@
+/*
+ ============================================================================
+ Name        : hev-task-io-stripe.c
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Task I/O operations (stream striping)
+ ============================================================================
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include <hev-task.h>
+#include <hev-memory-allocator.h>
+
+#include "hev-logger.h"
+
+#include "hev-task-io-stripe.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL (0)
+#endif
+
+#define STRIPE_HEADER_SIZE (6)
+#define STRIPE_ROUNDS (64)
+
+typedef struct _HevTaskIOStripe HevTaskIOStripe;
+typedef struct _HevTaskIOStripeLink HevTaskIOStripeLink;
+typedef struct _HevTaskIOStripeChunk HevTaskIOStripeChunk;
+
+struct _HevTaskIOStripeChunk
+{
+    unsigned int len;
+    unsigned int off;
+    unsigned char data[];
+};
+
+struct _HevTaskIOStripeLink
+{
+    int fd;
+
+    /* to the peer: a framed chunk and how much of it is out */
+    unsigned int tuse;
+    unsigned int toff;
+    unsigned char *tbuf;
+
+    /* from the peer: the header, then the payload it announced */
+    unsigned int hoff;
+    unsigned int roff;
+    unsigned char head[STRIPE_HEADER_SIZE];
+    HevTaskIOStripeChunk *chunk;
+
+    unsigned int reof : 1;
+};
+
+struct _HevTaskIOStripe
+{
+    int ifd;
+    int ofd;
+    int count;
+    int next;
+
+    /* sequence numbers of the next chunk to send, and to hand to ofd */
+    unsigned int tseq;
+    unsigned int rseq;
+
+    /* ifd hit EOF and its end is queued; the peer's end went to ofd */
+    unsigned int ieof : 1;
+    unsigned int fin : 1;
+    unsigned int oeof : 1;
+
+    HevTaskIOStripeLink links[HEV_TASK_IO_STRIPE_MAX];
+    HevTaskIOStripeChunk *slots[HEV_TASK_IO_STRIPE_WINDOW];
+};
+
+static unsigned int
+stripe_get32 (const unsigned char *p)
+{
+    return ((unsigned int)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+static void
+stripe_frame (HevTaskIOStripe *self, HevTaskIOStripeLink *link,
+              unsigned int len)
+{
+    unsigned int seq = self->tseq++;
+
+    link->tbuf[0] = seq >> 24;
+    link->tbuf[1] = seq >> 16;
+    link->tbuf[2] = seq >> 8;
+    link->tbuf[3] = seq;
+    link->tbuf[4] = len >> 8;
+    link->tbuf[5] = len;
+    link->tuse = STRIPE_HEADER_SIZE + len;
+    link->toff = 0;
+}
+
+/* Sends what link holds, refilled from ifd while it drains. */
+static int
+stripe_link_tx (HevTaskIOStripe *self, HevTaskIOStripeLink *link, int *idry)
+{
+    int progress = 0;
+    ssize_t res;
+
+    for (;;) {
+        if (!link->tuse) {
+            if (self->fin || *idry)
+                break;
+
+            if (!self->ieof) {
+                res = read (self->ifd, link->tbuf + STRIPE_HEADER_SIZE,
+                            HEV_TASK_IO_STRIPE_CHUNK);
+                if (res < 0) {
+                    if (errno != EAGAIN)
+                        return -1;
+                    *idry = 1;
+                    break;
+                }
+                if (res > 0) {
+                    stripe_frame (self, link, res);
+                    progress = 1;
+                } else {
+                    self->ieof = 1;
+                }
+            }
+
+            if (self->ieof) {
+                stripe_frame (self, link, 0);
+                self->fin = 1;
+                progress = 1;
+            }
+        }
+
+        res = send (link->fd, link->tbuf + link->toff,
+                    link->tuse - link->toff, MSG_NOSIGNAL);
+        if (res < 0) {
+            if (errno != EAGAIN)
+                return -1;
+            break;
+        }
+
+        progress = 1;
+        link->toff += res;
+        if (link->toff < link->tuse)
+            break;
+        link->tuse = 0;
+    }
+
+    return progress;
+}
+
+/* Reads chunks off link into their slots, while they fit the window. */
+static int
+stripe_link_rx (HevTaskIOStripe *self, HevTaskIOStripeLink *link)
+{
+    int progress = 0;
+    ssize_t res;
+
+    while (!link->reof) {
+        HevTaskIOStripeChunk *chunk = link->chunk;
+        unsigned int seq;
+
+        if (link->hoff < STRIPE_HEADER_SIZE) {
+            res = recv (link->fd, link->head + link->hoff,
+                        STRIPE_HEADER_SIZE - link->hoff, 0);
+            if (res == 0) {
+                /* between chunks only */
+                if (link->hoff)
+                    return -1;
+                link->reof = 1;
+                return 1;
+            }
+            if (res < 0) {
+                if (errno != EAGAIN)
+                    return -1;
+                break;
+            }
+
+            progress = 1;
+            link->hoff += res;
+            continue;
+        }
+
+        seq = stripe_get32 (link->head);
+        if (!chunk) {
+            unsigned int len = (link->head[4] << 8) | link->head[5];
+
+            if (len > HEV_TASK_IO_STRIPE_CHUNK)
+                return -1;
+            /* the chunk to hand on next is on another link: wait for it */
+            if ((seq - self->rseq) >= HEV_TASK_IO_STRIPE_WINDOW)
+                break;
+            if (self->slots[seq % HEV_TASK_IO_STRIPE_WINDOW])
+                return -1;
+
+            chunk = hev_malloc (sizeof (HevTaskIOStripeChunk) + len);
+            if (!chunk)
+                return -1;
+
+            chunk->len = len;
+            chunk->off = 0;
+            link->chunk = chunk;
+            link->roff = 0;
+        }
+
+        if (link->roff < chunk->len) {
+            res = recv (link->fd, chunk->data + link->roff,
+                        chunk->len - link->roff, 0);
+            if (res == 0)
+                return -1;
+            if (res < 0) {
+                if (errno != EAGAIN)
+                    return -1;
+                break;
+            }
+
+            progress = 1;
+            link->roff += res;
+            if (link->roff < chunk->len)
+                continue;
+        }
+
+        self->slots[seq % HEV_TASK_IO_STRIPE_WINDOW] = chunk;
+        link->chunk = NULL;
+        link->hoff = 0;
+        progress = 1;
+    }
+
+    return progress;
+}
+
+/* Writes the chunks to ofd in order, as far as they are in. */
+static int
+stripe_out (HevTaskIOStripe *self)
+{
+    int progress = 0;
+    ssize_t res;
+
+    while (!self->oeof) {
+        unsigned int i = self->rseq % HEV_TASK_IO_STRIPE_WINDOW;
+        HevTaskIOStripeChunk *chunk = self->slots[i];
+
+        if (!chunk)
+            break;
+
+        if (!chunk->len) {
+            /* ofd may be a pipe: then only closing it tells */
+            shutdown (self->ofd, SHUT_WR);
+            self->oeof = 1;
+        } else {
+            res = write (self->ofd, chunk->data + chunk->off,
+                         chunk->len - chunk->off);
+            if (res < 0) {
+                if (errno != EAGAIN)
+                    return -1;
+                break;
+            }
+
+            progress = 1;
+            chunk->off += res;
+            if (chunk->off < chunk->len)
+                break;
+        }
+
+        hev_free (chunk);
+        self->slots[i] = NULL;
+        self->rseq++;
+        progress = 1;
+    }
+
+    return progress;
+}
+
+static int
+stripe_done (HevTaskIOStripe *self)
+{
+    int i;
+
+    if (!self->oeof || !self->fin)
+        return 0;
+
+    for (i = 0; i < self->count; i++)
+        if (self->links[i].tuse)
+            return 0;
+
+    return 1;
+}
+
+static int
+stripe_io (HevTaskIOStripe *self)
+{
+    int progress = 0;
+    int reofs = 0;
+    int idry = 0;
+    int res;
+    int i;
+
+    /* whoever went first lines up last: no link gets all of ifd */
+    for (i = 0; i < self->count; i++) {
+        int k = (self->next + i) % self->count;
+
+        res = stripe_link_tx (self, &self->links[k], &idry);
+        if (res < 0)
+            return -1;
+        progress |= res;
+    }
+    self->next = (self->next + 1) % self->count;
+
+    for (i = 0; i < self->count; i++) {
+        HevTaskIOStripeLink *link = &self->links[i];
+
+        res = stripe_link_rx (self, link);
+        if (res < 0)
+            return -1;
+        progress |= res;
+        reofs += link->reof;
+    }
+
+    res = stripe_out (self);
+    if (res < 0)
+        return -1;
+    progress |= res;
+
+    /* every link closed before the peer's end came: it is gone */
+    if (reofs == self->count && !self->oeof)
+        return -1;
+
+    return progress;
+}
+
+static void
+stripe_free (HevTaskIOStripe *self)
+{
+    int i;
+
+    for (i = 0; i < self->count; i++) {
+        if (self->links[i].chunk)
+            hev_free (self->links[i].chunk);
+        if (self->links[i].tbuf)
+            hev_free (self->links[i].tbuf);
+    }
+
+    for (i = 0; i < HEV_TASK_IO_STRIPE_WINDOW; i++)
+        if (self->slots[i])
+            hev_free (self->slots[i]);
+
+    hev_free (self);
+}
+
+void
+hev_task_io_stripe_splice (int ifd, int ofd, const int *fds, int count,
+                           HevTaskIOYielder yielder, void *yielder_data)
+{
+    HevTaskIOStripe *self;
+    int rounds = 0;
+    int i;
+
+    if (count < 1 || count > HEV_TASK_IO_STRIPE_MAX)
+        return;
+
+    self = hev_malloc0 (sizeof (HevTaskIOStripe));
+    if (!self)
+        return;
+
+    LOG_D ("%p task io stripe splice %d", self, count);
+
+    self->ifd = ifd;
+    self->ofd = ofd;
+    self->count = count;
+
+    for (i = 0; i < count; i++) {
+        HevTaskIOStripeLink *link = &self->links[i];
+
+        link->fd = fds[i];
+        link->tbuf = hev_malloc (STRIPE_HEADER_SIZE + HEV_TASK_IO_STRIPE_CHUNK);
+        if (!link->tbuf)
+            goto exit;
+    }
+
+    while (!stripe_done (self)) {
+        int res;
+
+        res = stripe_io (self);
+        if (res < 0)
+            break;
+
+        if (res) {
+            if (++rounds == STRIPE_ROUNDS) {
+                if (yielder)
+                    yielder (HEV_TASK_YIELD, yielder_data);
+                else
+                    hev_task_yield (HEV_TASK_YIELD);
+                rounds = 0;
+            }
+            continue;
+        }
+        rounds = 0;
+
+        if (yielder) {
+            if (yielder (HEV_TASK_WAITIO, yielder_data) < 0)
+                break;
+        } else {
+            hev_task_yield (HEV_TASK_WAITIO);
+        }
+    }
+
+exit:
+    LOG_D ("%p task io stripe done", self);
+
+    stripe_free (self);
+}
@@ -0,0 +1,41 @@
+/*
+ ============================================================================
+ Name        : hev-task-io-stripe.h
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Task I/O operations (stream striping)
+ ============================================================================
+ */
+
+#ifndef __HEV_TASK_IO_STRIPE_H__
+#define __HEV_TASK_IO_STRIPE_H__
+
+#include <hev-task-io.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* links a stream may be striped across, bytes per chunk */
+#define HEV_TASK_IO_STRIPE_MAX (16)
+#define HEV_TASK_IO_STRIPE_CHUNK (16384)
+
+/* chunks held for reordering: a link further ahead is not read */
+#define HEV_TASK_IO_STRIPE_WINDOW (64)
+
+/*
+ * Moves a stream between ifd/ofd and a peer doing the same across the count
+ * links in fds, each chunk on whichever link has room for it. Chunks are a
+ * big-endian 32-bit sequence number and 16-bit length, then the payload;
+ * an empty one ends the stream. Returns once both ways have ended, a link
+ * fails or the yielder gives up. All fds are non-blocking and registered
+ * with the current task; the caller keeps them.
+ */
+void hev_task_io_stripe_splice (int ifd, int ofd, const int *fds, int count,
+                                HevTaskIOYielder yielder, void *yielder_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HEV_TASK_IO_STRIPE_H__ */
@@ -0,0 +1,698 @@
+/*
+ ============================================================================
+ Name        : hev-task-io-term.c
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Task I/O operations (terminal pump)
+ ============================================================================
+ */
+
+#include <time.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+
+#include <hev-task.h>
+#include <hev-memory-allocator.h>
+
+#include "hev-task-io-term.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL (0)
+#endif
+
+#define TERM_RECV_SIZE (16384)
+#define TERM_ROUNDS (64)
+
+typedef struct _HevTaskIOTermCtl HevTaskIOTermCtl;
+typedef struct _HevTaskIOTermEcho HevTaskIOTermEcho;
+
+enum
+{
+    TERM_CTL_DATA,
+    TERM_CTL_ESC,
+    TERM_CTL_LEN,
+    TERM_CTL_PAYLOAD,
+};
+
+struct _HevTaskIOTermCtl
+{
+    unsigned int state;
+    unsigned char type;
+    unsigned char len;
+    unsigned char pos;
+    unsigned char data[255];
+};
+
+struct _HevTaskIOTermEcho
+{
+    unsigned int offset;
+    unsigned char c;
+    unsigned char shown;
+};
+
+struct _HevTaskIOTerm
+{
+    int ifd;
+    int ofd;
+    int wfd;
+    int flags;
+
+    /* local input by stream offset: [head - kept, head) is still here */
+    unsigned char *ring;
+    unsigned int mask;
+    unsigned int head;
+    unsigned int sent;
+    unsigned int kept;
+
+    /* on its way to the link */
+    unsigned char sbuf[HEV_TASK_IO_TERM_SIZE * 2 + 8];
+    size_t srp;
+    size_t suse;
+
+    /* decoded from the link, on its way to ofd */
+    HevTaskIOTermCtl ctl;
+    unsigned int rx;
+    unsigned char rbuf[TERM_RECV_SIZE];
+    size_t rrp;
+    size_t ruse;
+
+    /* terminal: predicted keystrokes, those shown on screen come first */
+    HevTaskIOTermEcho echo[HEV_TASK_IO_TERM_ECHO_MAX];
+    unsigned int echo_head;
+    unsigned int echo_count;
+    unsigned int echo_shown;
+
+    /* terminal: written to ofd ahead of rbuf, takes predictions back */
+    unsigned char pre[16];
+    size_t pre_rp;
+    size_t pre_use;
+
+    /* pty: input written to it, acknowledged after the echo delay */
+    unsigned int acked;
+    unsigned int ack_off;
+    unsigned int echo_time;
+    int64_t ack_start;
+    int64_t ack_due;
+
+    int64_t first;
+    int64_t last;
+
+    unsigned int ieof : 1;
+    unsigned int shut : 1;
+    unsigned int winch : 1;
+    unsigned int trusted : 1;
+    unsigned int ack_wait : 1;
+    /* pty: END is on its way; terminal: END has arrived */
+    unsigned int end : 1;
+};
+
+static int64_t
+task_io_term_now (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int
+task_io_term_yield (HevTaskYieldType type, HevTaskIOYielder yielder,
+                    void *yielder_data)
+{
+    if (yielder)
+        return yielder (type, yielder_data);
+
+    hev_task_yield (type);
+    return 0;
+}
+
+static int
+task_io_term_escaped_in (HevTaskIOTerm *self)
+{
+    if (self->flags & HEV_TASK_IO_TERM_F_PTY)
+        return self->flags & HEV_TASK_IO_TERM_F_CTL;
+
+    return self->flags & (HEV_TASK_IO_TERM_F_RESUME | HEV_TASK_IO_TERM_F_ECHO);
+}
+
+static int
+task_io_term_escaped_out (HevTaskIOTerm *self)
+{
+    if (self->flags & HEV_TASK_IO_TERM_F_PTY)
+        return self->flags &
+               (HEV_TASK_IO_TERM_F_RESUME | HEV_TASK_IO_TERM_F_ECHO);
+
+    return self->flags & HEV_TASK_IO_TERM_F_CTL;
+}
+
+/* Takes back the keystrokes shown ahead of their echo. */
+static void
+task_io_term_echo_refute (HevTaskIOTerm *self)
+{
+    /* nothing else is pending for the screen while predictions are shown */
+    if (self->echo_shown && !self->pre_use) {
+        self->pre_rp = 0;
+        self->pre_use = snprintf ((char *)self->pre, sizeof (self->pre),
+                                  "\033[%uD\033[K", self->echo_shown);
+    }
+
+    self->echo_count = 0;
+    self->echo_shown = 0;
+    self->trusted = 0;
+}
+
+/* Matches pty output against the predictions: 0 if b is already shown. */
+static int
+task_io_term_echo_output (HevTaskIOTerm *self, unsigned char b)
+{
+    HevTaskIOTermEcho *e;
+
+    if (!self->echo_count)
+        return 1;
+
+    e = &self->echo[self->echo_head];
+    if (e->c != b) {
+        task_io_term_echo_refute (self);
+        return 1;
+    }
+
+    self->echo_head = (self->echo_head + 1) % HEV_TASK_IO_TERM_ECHO_MAX;
+    self->echo_count--;
+    /* echo works here: keystrokes from now on are shown at once */
+    self->trusted = 1;
+
+    if (!e->shown)
+        return 1;
+
+    self->echo_shown--;
+    return 0;
+}
+
+/* Predicts the echo of len keystrokes from stream offset head on. */
+static void
+task_io_term_echo_input (HevTaskIOTerm *self, const unsigned char *buf,
+                         size_t len)
+{
+    unsigned char show[HEV_TASK_IO_TERM_ECHO_MAX];
+    size_t i, n = 0;
+    ssize_t s;
+
+    for (i = 0; i < len; i++) {
+        HevTaskIOTermEcho *e;
+        unsigned int j;
+
+        /* Enter, editing keys, escapes: no telling what comes back */
+        if (buf[i] < 0x20 || buf[i] > 0x7e ||
+            self->echo_count == HEV_TASK_IO_TERM_ECHO_MAX) {
+            self->trusted = 0;
+            continue;
+        }
+
+        j = self->echo_head + self->echo_count++;
+        e = &self->echo[j % HEV_TASK_IO_TERM_ECHO_MAX];
+        e->offset = self->head + i;
+        e->c = buf[i];
+        e->shown = 0;
+
+        /* shown only right behind output and predictions already shown */
+        if (self->trusted && !self->ruse && !self->pre_use &&
+            (self->echo_shown + n + 1) == self->echo_count) {
+            e->shown = 1;
+            show[n++] = buf[i];
+        }
+    }
+
+    if (!n)
+        return;
+
+    s = write (self->ofd, show, n);
+    if (s < 0)
+        s = 0;
+
+    for (i = s; i < n; i++) {
+        unsigned int j = self->echo_head + self->echo_shown + i;
+
+        self->echo[j % HEV_TASK_IO_TERM_ECHO_MAX].shown = 0;
+        self->trusted = 0;
+    }
+    self->echo_shown += s;
+}
+
+/*
+ * Smooths the time from input to the first output after it, so that echo
+ * through a nested ssh is not refuted on every keystroke.
+ */
+static void
+task_io_term_echo_sample (HevTaskIOTerm *self, int64_t now)
+{
+    unsigned int t = now - self->ack_start;
+
+    self->ack_start = 0;
+    /* that late, it is output of its own rather than an echo */
+    if (t > HEV_TASK_IO_TERM_ECHO_DELAY_MAX)
+        return;
+
+    if (self->echo_time)
+        self->echo_time = (self->echo_time * 7 + t) / 8;
+    else
+        self->echo_time = t;
+}
+
+static unsigned int
+task_io_term_echo_delay (HevTaskIOTerm *self)
+{
+    unsigned int d = self->echo_time * 2;
+
+    if (d < HEV_TASK_IO_TERM_ECHO_DELAY)
+        return HEV_TASK_IO_TERM_ECHO_DELAY;
+    if (d > HEV_TASK_IO_TERM_ECHO_DELAY_MAX)
+        return HEV_TASK_IO_TERM_ECHO_DELAY_MAX;
+
+    return d;
+}
+
+static void
+task_io_term_ctl_apply (HevTaskIOTerm *self)
+{
+    HevTaskIOTermCtl *ctl = &self->ctl;
+    unsigned int offset;
+    struct winsize ws;
+
+    switch (ctl->type) {
+    case HEV_TASK_IO_TERM_CTL_WINSIZE:
+        if (!(self->flags & HEV_TASK_IO_TERM_F_PTY) || ctl->len < 4)
+            break;
+        memset (&ws, 0, sizeof (ws));
+        ws.ws_row = (ctl->data[0] << 8) | ctl->data[1];
+        ws.ws_col = (ctl->data[2] << 8) | ctl->data[3];
+        ioctl (self->ofd, TIOCSWINSZ, &ws);
+        break;
+    case HEV_TASK_IO_TERM_CTL_END:
+        if (!(self->flags & HEV_TASK_IO_TERM_F_PTY))
+            self->end = 1;
+        break;
+    case HEV_TASK_IO_TERM_CTL_ACK:
+        if ((self->flags & HEV_TASK_IO_TERM_F_PTY) || ctl->len < 4 ||
+            !self->echo_count)
+            break;
+        offset = ((unsigned int)ctl->data[0] << 24) | (ctl->data[1] << 16) |
+                 (ctl->data[2] << 8) | ctl->data[3];
+        /* the pty has had the oldest prediction a while, without echo */
+        if ((int)(offset - self->echo[self->echo_head].offset) > 0)
+            task_io_term_echo_refute (self);
+        break;
+    }
+}
+
+/*
+ * Acts on control messages in buf and leaves only data not shown already;
+ * returns its size.
+ */
+static size_t
+task_io_term_ctl_decode (HevTaskIOTerm *self, unsigned char *buf, size_t len)
+{
+    HevTaskIOTermCtl *ctl = &self->ctl;
+    size_t i, n = 0;
+
+    for (i = 0; i < len; i++) {
+        unsigned char b = buf[i];
+
+        switch (ctl->state) {
+        case TERM_CTL_DATA:
+            if (b == HEV_TASK_IO_TERM_ESC) {
+                ctl->state = TERM_CTL_ESC;
+                break;
+            }
+            self->rx++;
+            if (task_io_term_echo_output (self, b))
+                buf[n++] = b;
+            break;
+        case TERM_CTL_ESC:
+            if (b == HEV_TASK_IO_TERM_ESC) {
+                self->rx++;
+                if (task_io_term_echo_output (self, b))
+                    buf[n++] = b;
+                ctl->state = TERM_CTL_DATA;
+            } else {
+                ctl->type = b;
+                ctl->state = TERM_CTL_LEN;
+            }
+            break;
+        case TERM_CTL_LEN:
+            ctl->len = b;
+            ctl->pos = 0;
+            ctl->state = b ? TERM_CTL_PAYLOAD : TERM_CTL_DATA;
+            if (!b)
+                task_io_term_ctl_apply (self);
+            break;
+        default:
+            ctl->data[ctl->pos++] = b;
+            if (ctl->pos == ctl->len) {
+                task_io_term_ctl_apply (self);
+                ctl->state = TERM_CTL_DATA;
+            }
+            break;
+        }
+    }
+
+    return n;
+}
+
+static size_t
+task_io_term_escape (const unsigned char *src, size_t len, unsigned char *dst)
+{
+    size_t i, n = 0;
+
+    for (i = 0; i < len; i++) {
+        dst[n++] = src[i];
+        if (src[i] == HEV_TASK_IO_TERM_ESC)
+            dst[n++] = HEV_TASK_IO_TERM_ESC;
+    }
+
+    return n;
+}
+
+static size_t
+task_io_term_winsize (int fd, unsigned char *buf)
+{
+    struct winsize ws;
+
+    if (ioctl (fd, TIOCGWINSZ, &ws) < 0)
+        return 0;
+
+    buf[0] = HEV_TASK_IO_TERM_ESC;
+    buf[1] = HEV_TASK_IO_TERM_CTL_WINSIZE;
+    buf[2] = 4;
+    buf[3] = ws.ws_row >> 8;
+    buf[4] = ws.ws_row;
+    buf[5] = ws.ws_col >> 8;
+    buf[6] = ws.ws_col;
+
+    return 7;
+}
+
+HevTaskIOTerm *
+hev_task_io_term_new (int ifd, int ofd, int wfd, size_t replay, int flags)
+{
+    HevTaskIOTerm *self;
+
+    self = hev_malloc0 (sizeof (HevTaskIOTerm));
+    if (!self)
+        return NULL;
+
+    self->ring = hev_malloc (replay);
+    if (!self->ring) {
+        hev_free (self);
+        return NULL;
+    }
+
+    self->ifd = ifd;
+    self->ofd = ofd;
+    self->wfd = wfd;
+    self->flags = flags;
+    self->mask = replay - 1;
+
+    return self;
+}
+
+void
+hev_task_io_term_destroy (HevTaskIOTerm *self)
+{
+    hev_free (self->ring);
+    hev_free (self);
+}
+
+unsigned int
+hev_task_io_term_get_rx (HevTaskIOTerm *self)
+{
+    return self->rx;
+}
+
+int
+hev_task_io_term_rewind (HevTaskIOTerm *self, unsigned int offset)
+{
+    /* unsigned: an offset past head wraps to more than is ever kept */
+    if (self->head - offset > self->kept)
+        return -1;
+
+    self->sent = offset;
+    self->srp = 0;
+    self->suse = 0;
+    self->first = 0;
+    self->end = 0;
+    self->ack_wait = 0;
+    self->ack_start = 0;
+    memset (&self->ctl, 0, sizeof (self->ctl));
+    task_io_term_echo_refute (self);
+
+    return 0;
+}
+
+/* The next bytes for the link, if they are due: 1 staged, 0 not. */
+static int
+task_io_term_stage (HevTaskIOTerm *self, int64_t now, int idle)
+{
+    unsigned int pend = self->head - self->sent;
+    const unsigned char *src;
+    size_t len;
+
+    if (self->winch) {
+        self->winch = 0;
+        if (task_io_term_escaped_out (self)) {
+            self->suse = task_io_term_winsize (self->ifd, self->sbuf);
+            return 1;
+        }
+    }
+
+    if (!pend && self->ack_wait && now >= self->ack_due) {
+        unsigned int o = self->ack_off;
+
+        /* after all output read so far: the echo of input up to o */
+        self->sbuf[0] = HEV_TASK_IO_TERM_ESC;
+        self->sbuf[1] = HEV_TASK_IO_TERM_CTL_ACK;
+        self->sbuf[2] = 4;
+        self->sbuf[3] = o >> 24;
+        self->sbuf[4] = o >> 16;
+        self->sbuf[5] = o >> 8;
+        self->sbuf[6] = o;
+        self->suse = 7;
+        self->acked = o;
+        self->ack_wait = 0;
+        return 1;
+    }
+
+    if (!pend) {
+        /* the shell is gone and all it wrote is out: say so */
+        if (!self->ieof || self->end ||
+            !(self->flags & HEV_TASK_IO_TERM_F_RESUME))
+            return 0;
+        if (!(self->flags & HEV_TASK_IO_TERM_F_PTY))
+            return 0;
+
+        self->sbuf[0] = HEV_TASK_IO_TERM_ESC;
+        self->sbuf[1] = HEV_TASK_IO_TERM_CTL_END;
+        self->sbuf[2] = 0;
+        self->suse = 3;
+        self->end = 1;
+        return 1;
+    }
+
+    if (self->flags & HEV_TASK_IO_TERM_F_PTY) {
+        int flush = 0;
+
+        if (pend >= HEV_TASK_IO_TERM_SIZE || self->ieof)
+            flush = 1;
+        else if ((now - self->first) >= HEV_TASK_IO_TERM_DELAY)
+            flush = 1;
+        else if (idle && (now - self->last) >= HEV_TASK_IO_TERM_DELAY)
+            flush = 1;
+        if (!flush)
+            return 0;
+        self->last = now;
+    }
+
+    len = self->mask + 1 - (self->sent & self->mask);
+    if (len > pend)
+        len = pend;
+    if (len > HEV_TASK_IO_TERM_SIZE)
+        len = HEV_TASK_IO_TERM_SIZE;
+
+    src = self->ring + (self->sent & self->mask);
+    if (task_io_term_escaped_out (self)) {
+        self->suse = task_io_term_escape (src, len, self->sbuf);
+    } else {
+        memcpy (self->sbuf, src, len);
+        self->suse = len;
+    }
+    self->sent += len;
+
+    return 1;
+}
+
+int
+hev_task_io_term_run (HevTaskIOTerm *self, int sfd, HevTaskIOYielder yielder,
+                      void *yielder_data)
+{
+    int pty = self->flags & HEV_TASK_IO_TERM_F_PTY;
+    int rounds = 0;
+
+    for (;;) {
+        int progress = 0;
+        int idle = 0;
+        int64_t now = 0;
+        ssize_t s;
+
+        if (pty)
+            now = task_io_term_now ();
+
+        /* from the link, input goes to the pty right away */
+        if (!self->ruse && !self->pre_use && !self->end) {
+            s = recv (sfd, self->rbuf, sizeof (self->rbuf), 0);
+            if (s == 0) /* without END only a resumable session goes on */
+                return !(self->flags & HEV_TASK_IO_TERM_F_RESUME);
+            if (s < 0 && errno != EAGAIN)
+                return 0;
+            if (s > 0) {
+                if (task_io_term_escaped_in (self))
+                    s = task_io_term_ctl_decode (self, self->rbuf, s);
+                else
+                    self->rx += s;
+                self->rrp = 0;
+                self->ruse = s;
+                progress = 1;
+            }
+        }
+        if (self->pre_use) {
+            s = write (self->ofd, self->pre + self->pre_rp, self->pre_use);
+            if (s < 0 && errno != EAGAIN)
+                return 1;
+            if (s > 0) {
+                self->pre_rp += s;
+                self->pre_use -= s;
+                progress = 1;
+            }
+        } else if (self->ruse) {
+            s = write (self->ofd, self->rbuf + self->rrp, self->ruse);
+            if (s < 0 && errno != EAGAIN) {
+                if (!pty)
+                    return 1;
+                /* the shell is gone: its END follows */
+                self->ruse = 0;
+            } else if (s > 0) {
+                self->rrp += s;
+                self->ruse -= s;
+                progress = 1;
+            }
+        }
+        if (!pty && self->end && !self->ruse && !self->pre_use)
+            return 1;
+
+        /* acknowledged once the pty has had time to echo it */
+        if ((self->flags & HEV_TASK_IO_TERM_F_ECHO) && pty &&
+            !self->ack_wait && self->acked != (self->rx - self->ruse)) {
+            self->ack_off = self->rx - self->ruse;
+            self->ack_start = now;
+            self->ack_due = now + task_io_term_echo_delay (self);
+            self->ack_wait = 1;
+        }
+
+        if (self->wfd >= 0) {
+            char c[16];
+
+            while (read (self->wfd, c, sizeof (c)) > 0)
+                self->winch = 1;
+        }
+
+        /* local input, kept until the ring wraps over it */
+        if (!self->ieof) {
+            unsigned int pend = self->head - self->sent;
+            size_t off = self->head & self->mask;
+            size_t room = self->mask + 1 - pend;
+
+            if (room > self->mask + 1 - off)
+                room = self->mask + 1 - off;
+
+            if (room) {
+                s = read (self->ifd, self->ring + off, room);
+                if (s > 0 && !pty && (self->flags & HEV_TASK_IO_TERM_F_ECHO))
+                    task_io_term_echo_input (self, self->ring + off, s);
+                if (s > 0 && pty && self->ack_start)
+                    task_io_term_echo_sample (self, now);
+                if (s > 0) {
+                    if (!pend)
+                        self->first = now;
+                    self->head += s;
+                    self->kept += s;
+                    if (self->kept > self->mask + 1)
+                        self->kept = self->mask + 1;
+                    progress = 1;
+                } else if (s < 0 && errno == EAGAIN) {
+                    idle = 1;
+                } else { /* EIO once the shell is gone */
+                    self->ieof = 1;
+                    progress = 1;
+                }
+            }
+        }
+
+        if (!self->suse && task_io_term_stage (self, now, idle))
+            progress = 1;
+
+        if (self->suse) {
+            s = send (sfd, self->sbuf + self->srp, self->suse, MSG_NOSIGNAL);
+            if (s < 0 && errno != EAGAIN)
+                return 0;
+            if (s > 0) {
+                self->srp += s;
+                self->suse -= s;
+                if (!self->suse)
+                    self->srp = 0;
+                progress = 1;
+            }
+        }
+
+        if (self->ieof && !self->suse && self->head == self->sent) {
+            if (pty) {
+                if (self->end || !(self->flags & HEV_TASK_IO_TERM_F_RESUME))
+                    return 1;
+            } else if (!self->shut) {
+                shutdown (sfd, SHUT_WR);
+                self->shut = 1;
+            }
+        }
+
+        if (progress) {
+            if (++rounds == TERM_ROUNDS) {
+                task_io_term_yield (HEV_TASK_YIELD, yielder, yielder_data);
+                rounds = 0;
+            }
+            continue;
+        }
+        rounds = 0;
+
+        /* holding output or an ack: wake at the deadline or on I/O */
+        if (pty) {
+            int64_t due = 0;
+
+            /* the ack only leaves behind held output: flush that first */
+            if (!self->suse && self->head != self->sent)
+                due = self->first + HEV_TASK_IO_TERM_DELAY;
+            else if (self->ack_wait)
+                due = self->ack_due;
+
+            if (due > now) {
+                hev_task_sleep (due - now);
+                continue;
+            }
+        }
+
+        if (task_io_term_yield (HEV_TASK_WAITIO, yielder, yielder_data) < 0)
+            return 0;
+    }
+}
@@ -0,0 +1,101 @@
+/*
+ ============================================================================
+ Name        : hev-task-io-term.h
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Task I/O operations (terminal pump)
+ ============================================================================
+ */
+
+#ifndef __HEV_TASK_IO_TERM_H__
+#define __HEV_TASK_IO_TERM_H__
+
+#include <stddef.h>
+
+#include <hev-task-io.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* the latency budget (ms) and one full TLS record of payload */
+#define HEV_TASK_IO_TERM_DELAY (4)
+#define HEV_TASK_IO_TERM_SIZE (16384)
+
+/* bytes kept for replay (powers of two): pty output, terminal input */
+#define HEV_TASK_IO_TERM_REPLAY_PTY (65536)
+#define HEV_TASK_IO_TERM_REPLAY_TTY (16384)
+
+/* this end holds the pty: output is held briefly, WINSIZE is applied */
+#define HEV_TASK_IO_TERM_F_PTY (1 << 0)
+/* the stream towards the pty is escaped */
+#define HEV_TASK_IO_TERM_F_CTL (1 << 1)
+/* the stream from the pty is escaped too and closes with END */
+#define HEV_TASK_IO_TERM_F_RESUME (1 << 2)
+/* the stream from the pty is escaped too and acknowledges input */
+#define HEV_TASK_IO_TERM_F_ECHO (1 << 3)
+
+/*
+ * Time (ms) the pty has to echo input before it is acknowledged: twice the
+ * smoothed echo time seen on it, within these bounds.
+ */
+#define HEV_TASK_IO_TERM_ECHO_DELAY (50)
+#define HEV_TASK_IO_TERM_ECHO_DELAY_MAX (1000)
+/* keystrokes predicted ahead of their echo, at most */
+#define HEV_TASK_IO_TERM_ECHO_MAX (32)
+
+/*
+ * An escaped stream carries ESC ESC for a literal 0xff, and ESC TYPE LEN
+ * PAYLOAD[LEN] for a control message. Unknown types are skipped. WINSIZE
+ * carries rows and columns, big-endian 16-bit each; END says the shell has
+ * exited, as opposed to the link having dropped. ACK carries the stream
+ * offset of the input written to the pty at least the echo delay before,
+ * big-endian 32-bit: its echo, if any, came ahead of it.
+ */
+#define HEV_TASK_IO_TERM_ESC (0xff)
+#define HEV_TASK_IO_TERM_CTL_WINSIZE (1)
+#define HEV_TASK_IO_TERM_CTL_END (2)
+#define HEV_TASK_IO_TERM_CTL_ACK (3)
+
+typedef struct _HevTaskIOTerm HevTaskIOTerm;
+
+/*
+ * One end of a terminal stream with local side ifd / ofd: the pty with
+ * HEV_TASK_IO_TERM_F_PTY, otherwise a terminal whose size is sent each time
+ * wfd (written to on SIGWINCH, or -1) turns readable. The last replay bytes
+ * sent are kept, so the stream can go on over a new link. The fds are not
+ * owned.
+ *
+ * With HEV_TASK_IO_TERM_F_ECHO a terminal shows printable keystrokes before
+ * their echo arrives, once echo has been seen to work since the last other
+ * key, and takes them back if the output or an ACK disagrees.
+ */
+HevTaskIOTerm *hev_task_io_term_new (int ifd, int ofd, int wfd, size_t replay,
+                                     int flags);
+void hev_task_io_term_destroy (HevTaskIOTerm *self);
+
+/* Data bytes received so far: where the peer resumes sending. */
+unsigned int hev_task_io_term_get_rx (HevTaskIOTerm *self);
+
+/*
+ * Prepares a new link: sending restarts at offset, the data bytes the peer
+ * has received. Returns -1 if those are no longer kept.
+ */
+int hev_task_io_term_rewind (HevTaskIOTerm *self, unsigned int offset);
+
+/*
+ * Moves bytes between the local side and sfd, all registered with the
+ * current task. Input to the pty goes out at once; pty output is held for up
+ * to HEV_TASK_IO_TERM_DELAY ms or HEV_TASK_IO_TERM_SIZE bytes so a burst
+ * leaves in few records, but output after an idle spell (echo, a prompt) is
+ * flushed at once. Returns 1 once the session is over, 0 if the link was
+ * lost or the yielder gave up.
+ */
+int hev_task_io_term_run (HevTaskIOTerm *self, int sfd,
+                          HevTaskIOYielder yielder, void *yielder_data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HEV_TASK_IO_TERM_H__ */
@@ -0,0 +1,442 @@
+/*
+ ============================================================================
+ Name        : hev-task-io-tls.c
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Task I/O operations (user-space TLS records)
+ ============================================================================
+ */
+
+#include "hev-task-io-tls.h"
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include <hev-task.h>
+#include <hev-memory-allocator.h>
+
+#include "hev-aead.h"
+#include "hev-logger.h"
+#include "linux-tls.h"
+#include "hev-task-io-pump.h"
+
+#define TLS_HEADER_SIZE (5)
+#define TLS_EXPLICIT_SIZE (8)
+#define TLS_PLAINTEXT_MAX (16384)
+#define TLS_CIPHERTEXT_MAX (TLS_PLAINTEXT_MAX + 256)
+#define TLS_RECORD_MAX (TLS_HEADER_SIZE + TLS_CIPHERTEXT_MAX)
+
+#define TLS_TYPE_ALERT (21)
+#define TLS_TYPE_DATA (23)
+
+typedef struct _HevTaskIOTLS HevTaskIOTLS;
+typedef struct _HevTaskIOTLSDir HevTaskIOTLSDir;
+
+struct _HevTaskIOTLSDir
+{
+    HevAEAD aead;
+    unsigned char iv[HEV_AEAD_NONCE_SIZE];
+    uint64_t seq;
+
+    size_t rp;
+    size_t use;
+
+    /* rx: plaintext of the record at rp still to be written out */
+    size_t out;
+    size_t out_len;
+    size_t rec;
+
+    unsigned int eof : 1;
+    unsigned int done : 1;
+};
+
+struct _HevTaskIOTLS
+{
+    HevTaskIOPump base;
+
+    int tls13;
+    int explicit;
+
+    HevTaskIOTLSDir tx;
+    HevTaskIOTLSDir rx;
+
+    unsigned char tbuf[TLS_RECORD_MAX];
+    unsigned char rbuf[TLS_RECORD_MAX * 2];
+};
+
+static inline uint64_t
+load64_be (const unsigned char *p)
+{
+    uint64_t v = 0;
+    int i;
+
+    for (i = 0; i < 8; i++)
+        v = (v << 8) | p[i];
+
+    return v;
+}
+
+static inline void
+store64_be (unsigned char *p, uint64_t v)
+{
+    int i;
+
+    for (i = 7; i >= 0; i--, v >>= 8)
+        p[i] = v;
+}
+
+static int
+task_io_tls_dir_init (HevTaskIOTLSDir *d, const struct tls_crypto_info *ci)
+{
+    const struct tls12_crypto_info_aes_gcm_128 *g128 = (const void *)ci;
+    const struct tls12_crypto_info_aes_gcm_256 *g256 = (const void *)ci;
+    const struct tls12_crypto_info_chacha20_poly1305 *cc = (const void *)ci;
+
+    switch (ci->cipher_type) {
+    case TLS_CIPHER_AES_GCM_128:
+        memcpy (d->iv, g128->salt, sizeof (g128->salt));
+        memcpy (d->iv + sizeof (g128->salt), g128->iv, sizeof (g128->iv));
+        d->seq = load64_be (g128->rec_seq);
+        return hev_aead_init (&d->aead, HEV_AEAD_AES_128_GCM, g128->key);
+    case TLS_CIPHER_AES_GCM_256:
+        memcpy (d->iv, g256->salt, sizeof (g256->salt));
+        memcpy (d->iv + sizeof (g256->salt), g256->iv, sizeof (g256->iv));
+        d->seq = load64_be (g256->rec_seq);
+        return hev_aead_init (&d->aead, HEV_AEAD_AES_256_GCM, g256->key);
+    case TLS_CIPHER_CHACHA20_POLY1305:
+        memcpy (d->iv, cc->iv, sizeof (cc->iv));
+        d->seq = load64_be (cc->rec_seq);
+        return hev_aead_init (&d->aead, HEV_AEAD_CHACHA20_POLY1305, cc->key);
+    }
+
+    return -1;
+}
+
+/* TLS 1.3 and ChaCha20 nonce: the static iv xor the record sequence. */
+static void
+task_io_tls_nonce (HevTaskIOTLSDir *d, unsigned char *nonce)
+{
+    unsigned char seq[8];
+    int i;
+
+    store64_be (seq, d->seq);
+    memcpy (nonce, d->iv, HEV_AEAD_NONCE_SIZE);
+    for (i = 0; i < 8; i++)
+        nonce[4 + i] ^= seq[i];
+}
+
+/* TLS 1.2 additional data: seq, type, version and plaintext length. */
+static void
+task_io_tls_aad12 (HevTaskIOTLSDir *d, unsigned char *aad, size_t len)
+{
+    store64_be (aad, d->seq);
+    aad[8] = TLS_TYPE_DATA;
+    aad[9] = 3;
+    aad[10] = 3;
+    aad[11] = len >> 8;
+    aad[12] = len;
+}
+
+static void
+task_io_tls_seal (HevTaskIOTLS *self, size_t len)
+{
+    HevTaskIOTLSDir *d = &self->tx;
+    unsigned char nonce[HEV_AEAD_NONCE_SIZE];
+    unsigned char *rec = self->tbuf;
+    unsigned char *data = rec + TLS_HEADER_SIZE + self->explicit;
+    unsigned char aad[13];
+    size_t rec_len;
+
+    if (self->tls13)
+        data[len++] = TLS_TYPE_DATA;
+
+    rec_len = self->explicit + len + HEV_AEAD_TAG_SIZE;
+    rec[0] = TLS_TYPE_DATA;
+    rec[1] = 3;
+    rec[2] = 3;
+    rec[3] = rec_len >> 8;
+    rec[4] = rec_len;
+
+    if (self->tls13) {
+        task_io_tls_nonce (d, nonce);
+        hev_aead_seal (&d->aead, nonce, rec, TLS_HEADER_SIZE, data, len,
+                       data + len);
+    } else {
+        if (self->explicit) {
+            memcpy (nonce, d->iv, 4);
+            store64_be (nonce + 4, load64_be (d->iv + 4) + d->seq);
+            memcpy (rec + TLS_HEADER_SIZE, nonce + 4, TLS_EXPLICIT_SIZE);
+        } else {
+            task_io_tls_nonce (d, nonce);
+        }
+        task_io_tls_aad12 (d, aad, len);
+        hev_aead_seal (&d->aead, nonce, aad, sizeof (aad), data, len,
+                       data + len);
+    }
+
+    d->seq++;
+    d->rp = 0;
+    d->use = TLS_HEADER_SIZE + rec_len;
+}
+
+/* Decrypt the whole record at rx.rp in place; -1 on anything but data. */
+static int
+task_io_tls_open (HevTaskIOTLS *self, size_t rec_len)
+{
+    HevTaskIOTLSDir *d = &self->rx;
+    unsigned char nonce[HEV_AEAD_NONCE_SIZE];
+    unsigned char *rec = self->rbuf + d->rp;
+    unsigned char *data = rec + TLS_HEADER_SIZE + self->explicit;
+    size_t len = rec_len - self->explicit - HEV_AEAD_TAG_SIZE;
+    unsigned char aad[13];
+    int type = rec[0];
+    int res;
+
+    if (self->tls13) {
+        task_io_tls_nonce (d, nonce);
+        res = hev_aead_open (&d->aead, nonce, rec, TLS_HEADER_SIZE, data, len,
+                             data + len);
+        /* strip padding, then the inner content type */
+        while (res == 0 && len && !data[len - 1])
+            len--;
+        if (res == 0 && len)
+            type = data[--len];
+        else
+            res = -1;
+    } else {
+        if (self->explicit) {
+            memcpy (nonce, d->iv, 4);
+            memcpy (nonce + 4, rec + TLS_HEADER_SIZE, TLS_EXPLICIT_SIZE);
+        } else {
+            task_io_tls_nonce (d, nonce);
+        }
+        task_io_tls_aad12 (d, aad, len);
+        aad[8] = type;
+        res = hev_aead_open (&d->aead, nonce, aad, sizeof (aad), data, len,
+                             data + len);
+    }
+
+    if (res < 0) {
+        LOG_E ("%p task io tls bad record", self);
+        return -1;
+    }
+
+    d->seq++;
+    d->out = data - self->rbuf;
+    d->out_len = len;
+    d->rec = TLS_HEADER_SIZE + rec_len;
+
+    if (type == TLS_TYPE_ALERT) {
+        d->out_len = 0;
+        d->eof = 1;
+    } else if (type != TLS_TYPE_DATA) {
+        return -1;
+    }
+
+    return 0;
+}
+
+static int
+task_io_tls_tx (HevTaskIOTLS *self)
+{
+    HevTaskIOTLSDir *d = &self->tx;
+    unsigned char *data;
+    int progress = 0;
+    ssize_t s;
+
+    if (d->done)
+        return 0;
+
+    if (!d->use) {
+        if (d->eof) {
+            shutdown (self->base.fd, SHUT_WR);
+            d->done = 1;
+            return 1;
+        }
+
+        data = self->tbuf + TLS_HEADER_SIZE + self->explicit;
+        s = recv (self->base.pfd, data, TLS_PLAINTEXT_MAX, 0);
+        if (s == 0) {
+            d->eof = 1;
+            return 1;
+        }
+        if (s < 0)
+            return (errno == EAGAIN) ? 0 : -1;
+
+        task_io_tls_seal (self, s);
+        progress = 1;
+    }
+
+    s = send (self->base.fd, self->tbuf + d->rp, d->use, MSG_NOSIGNAL);
+    if (s < 0)
+        return (errno == EAGAIN) ? progress : -1;
+
+    d->rp += s;
+    d->use -= s;
+
+    return 1;
+}
+
+static int
+task_io_tls_rx (HevTaskIOTLS *self)
+{
+    HevTaskIOTLSDir *d = &self->rx;
+    const size_t overhead = self->explicit + HEV_AEAD_TAG_SIZE + self->tls13;
+    size_t rec_len;
+    ssize_t s;
+
+    if (d->done)
+        return 0;
+
+    if (d->out_len) {
+        s = send (self->base.pfd, self->rbuf + d->out, d->out_len,
+                  MSG_NOSIGNAL);
+        if (s < 0)
+            return (errno == EAGAIN) ? 0 : -1;
+        d->out += s;
+        d->out_len -= s;
+        if (d->out_len)
+            return 1;
+    }
+
+    if (d->rec) {
+        d->rp += d->rec;
+        d->use -= d->rec;
+        d->rec = 0;
+        return 1;
+    }
+
+    if (d->use >= TLS_HEADER_SIZE) {
+        unsigned char *rec = self->rbuf + d->rp;
+
+        rec_len = (rec[3] << 8) | rec[4];
+        if (rec_len < overhead || rec_len > TLS_CIPHERTEXT_MAX)
+            return -1;
+
+        if (d->use >= TLS_HEADER_SIZE + rec_len)
+            return (task_io_tls_open (self, rec_len) < 0) ? -1 : 1;
+    }
+
+    if (d->eof) {
+        if (d->use)
+            return -1;
+        shutdown (self->base.pfd, SHUT_WR);
+        d->done = 1;
+        return 1;
+    }
+
+    if (d->rp && (d->rp + TLS_RECORD_MAX > sizeof (self->rbuf))) {
+        memmove (self->rbuf, self->rbuf + d->rp, d->use);
+        d->rp = 0;
+    }
+
+    s = recv (self->base.fd, self->rbuf + d->rp + d->use,
+              sizeof (self->rbuf) - d->rp - d->use, 0);
+    if (s == 0) {
+        d->eof = 1;
+        return 1;
+    }
+    if (s < 0)
+        return (errno == EAGAIN) ? 0 : -1;
+
+    d->use += s;
+
+    return 1;
+}
+
+static int
+task_io_tls_step (HevTaskIOPump *base)
+{
+    HevTaskIOTLS *self = (HevTaskIOTLS *)base;
+    int tx, rx;
+
+    if (self->tx.done && self->rx.done)
+        return -1;
+
+    tx = task_io_tls_tx (self);
+    rx = task_io_tls_rx (self);
+    if ((tx < 0) || (rx < 0))
+        return -1;
+
+    return tx || rx;
+}
+
+static void
+task_io_tls_done (HevTaskIOPump *base)
+{
+    LOG_D ("%p task io tls done", base);
+
+    hev_free (base);
+}
+
+int
+hev_task_io_tls_supported (int cipher_type)
+{
+    switch (cipher_type) {
+    case TLS_CIPHER_AES_GCM_128:
+        return hev_aead_supported (HEV_AEAD_AES_128_GCM);
+    case TLS_CIPHER_AES_GCM_256:
+        return hev_aead_supported (HEV_AEAD_AES_256_GCM);
+    case TLS_CIPHER_CHACHA20_POLY1305:
+        return hev_aead_supported (HEV_AEAD_CHACHA20_POLY1305);
+    }
+
+    return 0;
+}
+
+int
+hev_task_io_tls_start (int fd, const void *tx, const void *rx,
+                       int stack_size, unsigned int timeout)
+{
+    const struct tls_crypto_info *ci = tx;
+    HevTaskIOTLS *self;
+    int pfd;
+
+    self = hev_malloc0 (sizeof (HevTaskIOTLS));
+    if (!self)
+        return -1;
+
+    if ((task_io_tls_dir_init (&self->tx, tx) < 0) ||
+        (task_io_tls_dir_init (&self->rx, rx) < 0))
+        goto exit;
+
+    self->tls13 = ci->version == TLS_1_3_VERSION;
+    if (!self->tls13 && (ci->cipher_type != TLS_CIPHER_CHACHA20_POLY1305))
+        self->explicit = TLS_EXPLICIT_SIZE;
+
+    self->base.step = task_io_tls_step;
+    self->base.done = task_io_tls_done;
+    pfd = hev_task_io_pump_start (&self->base, fd, stack_size, timeout);
+    if (pfd < 0)
+        goto exit;
+
+    LOG_D ("%p task io tls start %d", self, ci->cipher_type);
+
+    return pfd;
+
+exit:
+    hev_free (self);
+    return -1;
+}
+
+#else /* !__linux__ */
+
+int
+hev_task_io_tls_supported (int cipher_type)
+{
+    return 0;
+}
+
+int
+hev_task_io_tls_start (int fd, const void *tx, const void *rx,
+                       int stack_size, unsigned int timeout)
+{
+    return -1;
+}
+
+#endif /* __linux__ */
@@ -0,0 +1,34 @@
+/*
+ ============================================================================
+ Name        : hev-task-io-tls.h
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Task I/O operations (user-space TLS records)
+ ============================================================================
+ */
+
+#ifndef __HEV_TASK_IO_TLS_H__
+#define __HEV_TASK_IO_TLS_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Non-zero if cipher_type (TLS_CIPHER_*) can be done in user space here. */
+int hev_task_io_tls_supported (int cipher_type);
+
+/*
+ * Run the TLS record layer for fd in a task of its own, wire compatible with
+ * kTLS configured from the same tls12_crypto_info_* structs. Returns the
+ * plaintext end of a socket pair to use in place of fd, or -1. On success
+ * fd belongs to that task, which gives up after timeout ms without traffic;
+ * the caller must not have fd registered.
+ */
+int hev_task_io_tls_start (int fd, const void *tx, const void *rx,
+                           int stack_size, unsigned int timeout);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HEV_TASK_IO_TLS_H__ */
@@ -0,0 +1,994 @@
+/*
+ ============================================================================
+ Name        : hev-task-io-uring.c
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Task I/O operations (io_uring)
+ ============================================================================
+ */
+
+#include <errno.h>
+
+#include "hev-task-io-uring.h"
+
+#if defined(__linux__) && defined(ENABLE_IO_URING)
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include <hev-task.h>
+#include <hev-memory-allocator.h>
+
+#include "hev-logger.h"
+#include "hev-compiler.h"
+
+#define RING_ENTRIES (256)
+#define BUF_GROUP (0)
+#define QUEUE_HIGH (8)
+#define BUF_MAX (16384)
+
+typedef struct _HevTaskIOUring HevTaskIOUring;
+typedef struct _HevTaskIOUringOp HevTaskIOUringOp;
+typedef struct _HevTaskIOUringBuf HevTaskIOUringBuf;
+typedef struct _HevTaskIOUringSplicer HevTaskIOUringSplicer;
+typedef void (*HevTaskIOUringComplete) (HevTaskIOUringOp *op, int res,
+                                        unsigned int flags);
+
+struct _HevTaskIOUringOp
+{
+    HevTask *task;
+    HevTaskIOUringOp *next;
+    HevTaskIOUringComplete complete;
+
+    unsigned int armed : 1;
+    unsigned int starved : 1;
+};
+
+struct _HevTaskIOUringBuf
+{
+    int next;
+    unsigned int off;
+    unsigned int len;
+};
+
+struct _HevTaskIOUring
+{
+    int fd;
+    int fixed;
+    unsigned int users;
+    unsigned int splices;
+
+    unsigned int sq_tail;
+    unsigned int sq_mask;
+    unsigned int sq_entries;
+    unsigned int *sq_khead;
+    unsigned int *sq_ktail;
+    unsigned int *sq_kflags;
+    struct io_uring_sqe *sqes;
+
+    unsigned int cq_mask;
+    unsigned int *cq_khead;
+    unsigned int *cq_ktail;
+    struct io_uring_cqe *cqes;
+
+    void *sq_ptr;
+    void *cq_ptr;
+    size_t sq_len;
+    size_t cq_len;
+    size_t sqes_len;
+
+    HevTask *task;
+    HevTaskIOUringOp *starved;
+
+    unsigned char *arena;
+    HevTaskIOUringBuf *bufs;
+};
+
+struct _HevTaskIOUringSplicer
+{
+    HevTaskIOUringOp recv;
+    HevTaskIOUringOp send;
+
+    int fd_in;
+    int fd_out;
+    int head;
+    int tail;
+    unsigned int count;
+
+    unsigned int multishot : 1;
+    unsigned int cancel : 1;
+    unsigned int eof : 1;
+    unsigned int error : 1;
+    unsigned int shut : 1;
+};
+
+struct _HevTaskIOUringAccept
+{
+    HevTaskIOUringOp op;
+
+    int fd;
+    int error;
+    int *fds;
+    unsigned int r;
+    unsigned int w;
+    unsigned int size;
+};
+
+static size_t ring_buf_size;
+static unsigned int ring_buf_count;
+static int ring_enabled;
+static __thread HevTaskIOUring *ring;
+
+static void
+task_io_uring_destroy (HevTaskIOUring *self)
+{
+    if (self->bufs)
+        hev_free (self->bufs);
+    if (self->arena)
+        munmap (self->arena, ring_buf_size * ring_buf_count);
+    if (self->sqes)
+        munmap (self->sqes, self->sqes_len);
+    if (self->cq_ptr && self->cq_ptr != self->sq_ptr)
+        munmap (self->cq_ptr, self->cq_len);
+    if (self->sq_ptr)
+        munmap (self->sq_ptr, self->sq_len);
+    if (self->fd >= 0)
+        close (self->fd);
+    hev_free (self);
+}
+
+static void *
+task_io_uring_mmap (int fd, size_t len, off_t off)
+{
+    void *ptr;
+
+    ptr = mmap (NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                fd, off);
+    if (ptr == MAP_FAILED)
+        return NULL;
+
+    return ptr;
+}
+
+static int
+task_io_uring_enter (HevTaskIOUring *self, unsigned int submit,
+                     unsigned int wait, unsigned int flags)
+{
+    return syscall (__NR_io_uring_enter, self->fd, submit, wait, flags, NULL,
+                    0);
+}
+
+static struct io_uring_sqe *
+task_io_uring_get_sqe (HevTaskIOUring *self)
+{
+    struct io_uring_sqe *sqe;
+    unsigned int head;
+
+    head = __atomic_load_n (self->sq_khead, __ATOMIC_ACQUIRE);
+    if ((self->sq_tail - head) >= self->sq_entries) {
+        __atomic_store_n (self->sq_ktail, self->sq_tail, __ATOMIC_RELEASE);
+        task_io_uring_enter (self, self->sq_tail - head, 0, 0);
+        head = __atomic_load_n (self->sq_khead, __ATOMIC_ACQUIRE);
+        if ((self->sq_tail - head) >= self->sq_entries)
+            return NULL;
+    }
+
+    sqe = &self->sqes[self->sq_tail & self->sq_mask];
+    memset (sqe, 0, sizeof (struct io_uring_sqe));
+    self->sq_tail++;
+
+    /* submission is batched by the reactor task */
+    if (self->task)
+        hev_task_wakeup (self->task);
+
+    return sqe;
+}
+
+static void
+task_io_uring_submit (HevTaskIOUring *self)
+{
+    unsigned int pend;
+    int res;
+
+    __atomic_store_n (self->sq_ktail, self->sq_tail, __ATOMIC_RELEASE);
+    pend = self->sq_tail - __atomic_load_n (self->sq_khead, __ATOMIC_ACQUIRE);
+    if (!pend)
+        return;
+
+    res = task_io_uring_enter (self, pend, 0, 0);
+    if (res < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+        LOG_E ("%p io_uring submit", self);
+}
+
+static void
+task_io_uring_reap (HevTaskIOUring *self)
+{
+    unsigned int head;
+
+    if (*self->sq_kflags & IORING_SQ_CQ_OVERFLOW)
+        task_io_uring_enter (self, 0, 0, IORING_ENTER_GETEVENTS);
+
+    head = *self->cq_khead;
+    for (;;) {
+        struct io_uring_cqe *cqe;
+        HevTaskIOUringOp *op;
+        unsigned int flags;
+        int res;
+
+        if (head == __atomic_load_n (self->cq_ktail, __ATOMIC_ACQUIRE))
+            break;
+
+        cqe = &self->cqes[head & self->cq_mask];
+        op = (HevTaskIOUringOp *)(uintptr_t)cqe->user_data;
+        flags = cqe->flags;
+        res = cqe->res;
+
+        head++;
+        __atomic_store_n (self->cq_khead, head, __ATOMIC_RELEASE);
+
+        if (op)
+            op->complete (op, res, flags);
+        else if (res < 0 && res != -ENOENT && res != -EALREADY)
+            LOG_D ("%p io_uring op %d", self, res);
+    }
+}
+
+static void
+task_io_uring_buf_put (HevTaskIOUring *self, int bid)
+{
+    struct io_uring_sqe *sqe;
+
+    sqe = task_io_uring_get_sqe (self);
+    if (!sqe) {
+        LOG_E ("%p io_uring lost buffer %d", self, bid);
+        return;
+    }
+
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = 1;
+    sqe->addr = (uintptr_t)(self->arena + ring_buf_size * bid);
+    sqe->len = ring_buf_size;
+    sqe->off = bid;
+    sqe->buf_group = BUF_GROUP;
+
+    while (self->starved) {
+        HevTaskIOUringOp *op = self->starved;
+
+        self->starved = op->next;
+        op->starved = 0;
+        hev_task_wakeup (op->task);
+    }
+}
+
+static int
+task_io_uring_setup_buffers (HevTaskIOUring *self)
+{
+    struct io_uring_sqe *sqe;
+    struct io_uring_cqe *cqe;
+    struct iovec *iov;
+    unsigned int head;
+    size_t len;
+    unsigned int i;
+    int res;
+
+    len = ring_buf_size * ring_buf_count;
+    self->arena = mmap (NULL, len, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (self->arena == MAP_FAILED) {
+        self->arena = NULL;
+        return -1;
+    }
+
+    self->bufs = hev_malloc (sizeof (HevTaskIOUringBuf) * ring_buf_count);
+    if (!self->bufs)
+        return -1;
+
+    /* fixed buffers save the per-write page pinning, but are optional */
+    iov = hev_malloc (sizeof (struct iovec) * ring_buf_count);
+    if (iov) {
+        for (i = 0; i < ring_buf_count; i++) {
+            iov[i].iov_base = self->arena + ring_buf_size * i;
+            iov[i].iov_len = ring_buf_size;
+        }
+        res = syscall (__NR_io_uring_register, self->fd,
+                       IORING_REGISTER_BUFFERS, iov, ring_buf_count);
+        self->fixed = res == 0;
+        hev_free (iov);
+    }
+
+    sqe = task_io_uring_get_sqe (self);
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = ring_buf_count;
+    sqe->addr = (uintptr_t)self->arena;
+    sqe->len = ring_buf_size;
+    sqe->buf_group = BUF_GROUP;
+
+    __atomic_store_n (self->sq_ktail, self->sq_tail, __ATOMIC_RELEASE);
+    res = task_io_uring_enter (self, 1, 1, IORING_ENTER_GETEVENTS);
+    if (res < 0)
+        return -1;
+
+    /* a signal may cut the wait short: the completion is still due */
+    head = *self->cq_khead;
+    while (head == __atomic_load_n (self->cq_ktail, __ATOMIC_ACQUIRE)) {
+        res = task_io_uring_enter (self, 0, 1, IORING_ENTER_GETEVENTS);
+        if (res < 0 && errno != EINTR)
+            return -1;
+    }
+
+    cqe = &self->cqes[head & self->cq_mask];
+    res = cqe->res;
+    __atomic_store_n (self->cq_khead, head + 1, __ATOMIC_RELEASE);
+
+    return res < 0 ? -1 : 0;
+}
+
+static HevTaskIOUring *
+task_io_uring_new (void)
+{
+    struct io_uring_params p;
+    HevTaskIOUring *self;
+    unsigned int *array;
+    unsigned char *ptr;
+    unsigned int i;
+
+    self = hev_malloc0 (sizeof (HevTaskIOUring));
+    if (!self)
+        return NULL;
+
+    memset (&p, 0, sizeof (p));
+    self->fd = syscall (__NR_io_uring_setup, RING_ENTRIES, &p);
+    if (self->fd < 0)
+        goto exit;
+
+    /* multishot completions must never be dropped */
+    if (!(p.features & IORING_FEAT_NODROP))
+        goto exit;
+
+    self->sq_len = p.sq_off.array + p.sq_entries * sizeof (unsigned int);
+    self->cq_len = p.cq_off.cqes + p.cq_entries * sizeof (struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (self->cq_len > self->sq_len)
+            self->sq_len = self->cq_len;
+        self->cq_len = self->sq_len;
+    }
+
+    self->sq_ptr = task_io_uring_mmap (self->fd, self->sq_len,
+                                       IORING_OFF_SQ_RING);
+    if (!self->sq_ptr)
+        goto exit;
+
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+        self->cq_ptr = self->sq_ptr;
+    else
+        self->cq_ptr = task_io_uring_mmap (self->fd, self->cq_len,
+                                           IORING_OFF_CQ_RING);
+    if (!self->cq_ptr)
+        goto exit;
+
+    self->sqes_len = p.sq_entries * sizeof (struct io_uring_sqe);
+    self->sqes = task_io_uring_mmap (self->fd, self->sqes_len,
+                                     IORING_OFF_SQES);
+    if (!self->sqes)
+        goto exit;
+
+    ptr = self->sq_ptr;
+    self->sq_khead = (unsigned int *)(ptr + p.sq_off.head);
+    self->sq_ktail = (unsigned int *)(ptr + p.sq_off.tail);
+    self->sq_kflags = (unsigned int *)(ptr + p.sq_off.flags);
+    self->sq_mask = *(unsigned int *)(ptr + p.sq_off.ring_mask);
+    self->sq_entries = *(unsigned int *)(ptr + p.sq_off.ring_entries);
+    self->sq_tail = *self->sq_ktail;
+
+    /* identity mapping, so sqes can be filled in place */
+    array = (unsigned int *)(ptr + p.sq_off.array);
+    for (i = 0; i < self->sq_entries; i++)
+        array[i] = i;
+
+    ptr = self->cq_ptr;
+    self->cq_khead = (unsigned int *)(ptr + p.cq_off.head);
+    self->cq_ktail = (unsigned int *)(ptr + p.cq_off.tail);
+    self->cq_mask = *(unsigned int *)(ptr + p.cq_off.ring_mask);
+    self->cqes = (struct io_uring_cqe *)(ptr + p.cq_off.cqes);
+
+    if (task_io_uring_setup_buffers (self) < 0)
+        goto exit;
+
+    return self;
+
+exit:
+    task_io_uring_destroy (self);
+    return NULL;
+}
+
+static void
+task_io_uring_reactor (void *data)
+{
+    HevTaskIOUring *self = data;
+    HevTask *task = hev_task_self ();
+
+    hev_task_add_fd (task, self->fd, POLLIN);
+
+    for (;;) {
+        task_io_uring_submit (self);
+        task_io_uring_reap (self);
+
+        if (self->sq_tail != *self->sq_khead) {
+            hev_task_yield (HEV_TASK_YIELD);
+            continue;
+        }
+
+        if (!self->users)
+            break;
+
+        hev_task_yield (HEV_TASK_WAITIO);
+    }
+
+    hev_task_del_fd (task, self->fd);
+    self->task = NULL;
+}
+
+static HevTaskIOUring *
+task_io_uring_ref (void)
+{
+    HevTaskIOUring *self = ring;
+
+    if (!self) {
+        self = task_io_uring_new ();
+        if (!self)
+            return NULL;
+        ring = self;
+    }
+
+    if (!self->task) {
+        self->task = hev_task_new (16384);
+        if (!self->task)
+            return NULL;
+        hev_task_run (self->task, task_io_uring_reactor, self);
+    }
+
+    self->users++;
+    return self;
+}
+
+static void
+task_io_uring_unref (HevTaskIOUring *self)
+{
+    self->users--;
+    if (!self->users && self->task)
+        hev_task_wakeup (self->task);
+}
+
+static void
+task_io_uring_wait (HevTaskIOUringOp *op)
+{
+    while (op->armed)
+        hev_task_yield (HEV_TASK_WAITIO);
+}
+
+static void
+task_io_uring_cancel (HevTaskIOUring *self, HevTaskIOUringOp *op)
+{
+    struct io_uring_sqe *sqe;
+
+    sqe = task_io_uring_get_sqe (self);
+    if (!sqe)
+        return;
+
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = (uintptr_t)op;
+}
+
+int
+hev_task_io_uring_init (size_t buf_size, unsigned int tunnels)
+{
+    ring_buf_size = buf_size;
+    ring_buf_count = tunnels * 2 * QUEUE_HIGH;
+    if (ring_buf_count < 2 * QUEUE_HIGH)
+        ring_buf_count = 2 * QUEUE_HIGH;
+    if (ring_buf_count > BUF_MAX)
+        ring_buf_count = BUF_MAX;
+
+    if (!ring)
+        ring = task_io_uring_new ();
+    if (!ring)
+        return -1;
+
+    ring_enabled = 1;
+    return 0;
+}
+
+int
+hev_task_io_uring_enabled (void)
+{
+    return ring_enabled;
+}
+
+static void
+task_io_uring_splicer_push (HevTaskIOUringSplicer *self, int bid, int len)
+{
+    HevTaskIOUringBuf *b = &ring->bufs[bid];
+
+    b->next = -1;
+    b->off = 0;
+    b->len = len;
+
+    if (self->tail >= 0)
+        ring->bufs[self->tail].next = bid;
+    else
+        self->head = bid;
+    self->tail = bid;
+    self->count++;
+}
+
+static void
+task_io_uring_splicer_pop (HevTaskIOUringSplicer *self)
+{
+    int bid = self->head;
+
+    self->head = ring->bufs[bid].next;
+    if (self->head < 0)
+        self->tail = -1;
+    self->count--;
+
+    task_io_uring_buf_put (ring, bid);
+}
+
+static void
+task_io_uring_splicer_recv_complete (HevTaskIOUringOp *op, int res,
+                                     unsigned int flags)
+{
+    HevTaskIOUringSplicer *self;
+
+    self = container_of (op, HevTaskIOUringSplicer, recv);
+
+    if (flags & IORING_CQE_F_BUFFER) {
+        int bid = flags >> IORING_CQE_BUFFER_SHIFT;
+
+        if (res > 0)
+            task_io_uring_splicer_push (self, bid, res);
+        else
+            task_io_uring_buf_put (ring, bid);
+    }
+
+    if (!(flags & IORING_CQE_F_MORE))
+        op->armed = 0;
+
+    if (res == 0) {
+        self->eof = 1;
+    } else if (res < 0) {
+        switch (-res) {
+        case ENOBUFS:
+            /* rearmed once a buffer comes back */
+            if (!op->starved) {
+                op->starved = 1;
+                op->next = ring->starved;
+                ring->starved = op;
+            }
+            break;
+        case EINVAL:
+            /* no multishot recv, fall back to one read per buffer */
+            if (self->multishot) {
+                self->multishot = 0;
+                break;
+            }
+            self->error = 1;
+            break;
+        case ECANCELED:
+        case EAGAIN:
+        case EINTR:
+            break;
+        default:
+            self->error = 1;
+        }
+    }
+
+    hev_task_wakeup (op->task);
+}
+
+static void
+task_io_uring_splicer_send_complete (HevTaskIOUringOp *op, int res,
+                                     unsigned int flags)
+{
+    HevTaskIOUringSplicer *self;
+
+    self = container_of (op, HevTaskIOUringSplicer, send);
+    op->armed = 0;
+
+    if (res > 0) {
+        HevTaskIOUringBuf *b = &ring->bufs[self->head];
+
+        b->off += res;
+        if (b->off >= b->len)
+            task_io_uring_splicer_pop (self);
+    } else if (res != -EAGAIN && res != -EINTR) {
+        self->error = 1;
+    }
+
+    hev_task_wakeup (op->task);
+}
+
+static void
+task_io_uring_splicer_init (HevTaskIOUringSplicer *self, int fd_in,
+                            int fd_out)
+{
+    struct stat st;
+
+    memset (self, 0, sizeof (HevTaskIOUringSplicer));
+    self->recv.task = hev_task_self ();
+    self->recv.complete = task_io_uring_splicer_recv_complete;
+    self->send.task = self->recv.task;
+    self->send.complete = task_io_uring_splicer_send_complete;
+    self->fd_in = fd_in;
+    self->fd_out = fd_out;
+    self->head = -1;
+    self->tail = -1;
+
+    if (fstat (fd_in, &st) == 0 && S_ISSOCK (st.st_mode))
+        self->multishot = 1;
+}
+
+static void
+task_io_uring_splicer_arm (HevTaskIOUringSplicer *self)
+{
+    struct io_uring_sqe *sqe;
+
+    sqe = task_io_uring_get_sqe (ring);
+    if (!sqe)
+        return;
+
+    if (self->multishot) {
+        sqe->opcode = IORING_OP_RECV;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+    } else {
+        sqe->opcode = IORING_OP_READ;
+        sqe->off = -1;
+        sqe->len = ring_buf_size;
+    }
+    sqe->fd = self->fd_in;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUF_GROUP;
+    sqe->user_data = (uintptr_t)&self->recv;
+
+    self->recv.armed = 1;
+    self->cancel = 0;
+}
+
+static void
+task_io_uring_splicer_write (HevTaskIOUringSplicer *self)
+{
+    struct io_uring_sqe *sqe;
+    HevTaskIOUringBuf *b;
+
+    sqe = task_io_uring_get_sqe (ring);
+    if (!sqe)
+        return;
+
+    b = &ring->bufs[self->head];
+    if (ring->fixed) {
+        sqe->opcode = IORING_OP_WRITE_FIXED;
+        sqe->buf_index = self->head;
+    } else {
+        sqe->opcode = IORING_OP_WRITE;
+    }
+    sqe->fd = self->fd_out;
+    sqe->addr = (uintptr_t)(ring->arena + ring_buf_size * self->head + b->off);
+    sqe->len = b->len - b->off;
+    sqe->off = -1;
+    sqe->user_data = (uintptr_t)&self->send;
+
+    self->send.armed = 1;
+}
+
+/*
+ * Buffers a direction may hold: an even share of the pool, so that stalled
+ * tunnels cannot starve the others however many there are.
+ */
+static unsigned int
+task_io_uring_splicer_high (void)
+{
+    unsigned int high = ring_buf_count / (2 * ring->splices);
+
+    if (high > QUEUE_HIGH)
+        return QUEUE_HIGH;
+    if (high < 1)
+        return 1;
+
+    return high;
+}
+
+static int
+task_io_uring_splicer_step (HevTaskIOUringSplicer *self)
+{
+    unsigned int high = task_io_uring_splicer_high ();
+    int stop;
+
+    if (self->error) {
+        while (self->head >= 0 && !self->send.armed)
+            task_io_uring_splicer_pop (self);
+        self->eof = 1;
+    }
+
+    stop = self->eof || self->error;
+
+    if (!stop && !self->recv.armed && !self->recv.starved &&
+        self->count < high)
+        task_io_uring_splicer_arm (self);
+
+    if (self->recv.armed && !self->cancel &&
+        (stop || (self->multishot && self->count >= high))) {
+        task_io_uring_cancel (ring, &self->recv);
+        self->cancel = 1;
+    }
+
+    if (!self->error && !self->send.armed && self->head >= 0)
+        task_io_uring_splicer_write (self);
+
+    if (stop && self->head < 0 && !self->send.armed && !self->shut) {
+        shutdown (self->fd_out, SHUT_WR);
+        self->shut = 1;
+    }
+
+    return self->shut && !self->recv.armed;
+}
+
+static void
+task_io_uring_splicer_fini (HevTaskIOUringSplicer *self)
+{
+    HevTaskIOUringOp **p;
+
+    if (self->recv.armed && !self->cancel)
+        task_io_uring_cancel (ring, &self->recv);
+    if (self->send.armed)
+        task_io_uring_cancel (ring, &self->send);
+
+    task_io_uring_wait (&self->recv);
+    task_io_uring_wait (&self->send);
+
+    while (self->head >= 0)
+        task_io_uring_splicer_pop (self);
+
+    for (p = &ring->starved; *p; p = &(*p)->next) {
+        if (*p == &self->recv) {
+            *p = self->recv.next;
+            break;
+        }
+    }
+}
+
+static void
+task_io_uring_set_blocking (int fds[4], int flags[4])
+{
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        flags[i] = fcntl (fds[i], F_GETFL);
+        if (flags[i] >= 0)
+            fcntl (fds[i], F_SETFL, flags[i] & ~O_NONBLOCK);
+    }
+}
+
+static void
+task_io_uring_restore_flags (int fds[4], int flags[4])
+{
+    int i;
+
+    for (i = 3; i >= 0; i--)
+        if (flags[i] >= 0)
+            fcntl (fds[i], F_SETFL, flags[i]);
+}
+
+void
+hev_task_io_uring_splice (int fd_a_i, int fd_a_o, int fd_b_i, int fd_b_o,
+                          HevTaskIOYielder yielder, void *yielder_data)
+{
+    HevTaskIOUringSplicer f;
+    HevTaskIOUringSplicer b;
+    HevTask *task = hev_task_self ();
+    int fds[4] = { fd_a_i, fd_a_o, fd_b_i, fd_b_o };
+    int flags[4];
+    int i;
+
+    if (!task_io_uring_ref ())
+        return;
+    ring->splices++;
+
+    /*
+     * The ring waits for readiness itself, so the fds leave the task's
+     * poll set and are made blocking to keep io_uring off the -EAGAIN
+     * retry path.
+     */
+    for (i = 0; i < 4; i++)
+        hev_task_del_fd (task, fds[i]);
+    task_io_uring_set_blocking (fds, flags);
+
+    task_io_uring_splicer_init (&f, fd_a_i, fd_b_o);
+    task_io_uring_splicer_init (&b, fd_b_i, fd_a_o);
+
+    for (;;) {
+        int df = task_io_uring_splicer_step (&f);
+        int db = task_io_uring_splicer_step (&b);
+
+        if (df && db)
+            break;
+
+        if (yielder) {
+            if (yielder (HEV_TASK_WAITIO, yielder_data))
+                break;
+        } else {
+            hev_task_yield (HEV_TASK_WAITIO);
+        }
+    }
+
+    task_io_uring_splicer_fini (&f);
+    task_io_uring_splicer_fini (&b);
+
+    task_io_uring_restore_flags (fds, flags);
+    ring->splices--;
+    task_io_uring_unref (ring);
+}
+
+static void
+task_io_uring_accept_complete (HevTaskIOUringOp *op, int res,
+                               unsigned int flags)
+{
+    HevTaskIOUringAccept *self;
+
+    self = container_of (op, HevTaskIOUringAccept, op);
+
+    if (!(flags & IORING_CQE_F_MORE))
+        op->armed = 0;
+
+    if (res >= 0) {
+        if (self->w == self->size) {
+            if (self->r) {
+                memmove (self->fds, self->fds + self->r,
+                         sizeof (int) * (self->w - self->r));
+                self->w -= self->r;
+                self->r = 0;
+            } else {
+                int *fds;
+
+                fds = hev_realloc (self->fds, sizeof (int) * self->size * 2);
+                if (!fds) {
+                    close (res);
+                    return;
+                }
+                self->fds = fds;
+                self->size *= 2;
+            }
+        }
+        self->fds[self->w++] = res;
+    } else if (res != -ECANCELED) {
+        self->error = res;
+    }
+
+    hev_task_wakeup (op->task);
+}
+
+HevTaskIOUringAccept *
+hev_task_io_uring_accept_new (int fd)
+{
+    HevTaskIOUringAccept *self;
+
+    self = hev_malloc0 (sizeof (HevTaskIOUringAccept));
+    if (!self)
+        return NULL;
+
+    self->size = 16;
+    self->fds = hev_malloc (sizeof (int) * self->size);
+    if (!self->fds) {
+        hev_free (self);
+        return NULL;
+    }
+
+    if (!task_io_uring_ref ()) {
+        hev_free (self->fds);
+        hev_free (self);
+        return NULL;
+    }
+
+    self->fd = fd;
+    self->op.complete = task_io_uring_accept_complete;
+
+    return self;
+}
+
+void
+hev_task_io_uring_accept_destroy (HevTaskIOUringAccept *self)
+{
+    if (self->op.armed) {
+        self->op.task = hev_task_self ();
+        task_io_uring_cancel (ring, &self->op);
+        task_io_uring_wait (&self->op);
+    }
+
+    while (self->r < self->w)
+        close (self->fds[self->r++]);
+
+    task_io_uring_unref (ring);
+    hev_free (self->fds);
+    hev_free (self);
+}
+
+int
+hev_task_io_uring_accept (HevTaskIOUringAccept *self)
+{
+    self->op.task = hev_task_self ();
+
+    for (;;) {
+        struct io_uring_sqe *sqe;
+
+        if (self->r < self->w)
+            return self->fds[self->r++];
+
+        if (self->error) {
+            int res = self->error;
+
+            self->error = 0;
+            return res;
+        }
+
+        if (!self->op.armed) {
+            sqe = task_io_uring_get_sqe (ring);
+            if (!sqe)
+                return -EAGAIN;
+
+            sqe->opcode = IORING_OP_ACCEPT;
+            sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+            sqe->fd = self->fd;
+            sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+            sqe->user_data = (uintptr_t)&self->op;
+            self->op.armed = 1;
+        }
+
+        hev_task_yield (HEV_TASK_WAITIO);
+    }
+}
+
+#else /* !ENABLE_IO_URING */
+
+int
+hev_task_io_uring_init (size_t buf_size, unsigned int buf_count)
+{
+    return -1;
+}
+
+int
+hev_task_io_uring_enabled (void)
+{
+    return 0;
+}
+
+void
+hev_task_io_uring_splice (int fd_a_i, int fd_a_o, int fd_b_i, int fd_b_o,
+                          HevTaskIOYielder yielder, void *yielder_data)
+{
+}
+
+HevTaskIOUringAccept *
+hev_task_io_uring_accept_new (int fd)
+{
+    return NULL;
+}
+
+void
+hev_task_io_uring_accept_destroy (HevTaskIOUringAccept *self)
+{
+}
+
+int
+hev_task_io_uring_accept (HevTaskIOUringAccept *self)
+{
+    return -ENOSYS;
+}
+
+#endif /* ENABLE_IO_URING */
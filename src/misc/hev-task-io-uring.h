@@ -0,0 +1,42 @@
+/*
+ ============================================================================
+ Name        : hev-task-io-uring.h
+ Author      : hev <r@hev.cc>
+ Copyright   : Copyright (c) 2026 xyz
+ Description : Task I/O operations (io_uring)
+ ============================================================================
+ */
+
+#ifndef __HEV_TASK_IO_URING_H__
+#define __HEV_TASK_IO_URING_H__
+
+#include <stddef.h>
+
+#include <hev-task-io.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct _HevTaskIOUringAccept HevTaskIOUringAccept;
+
+/*
+ * Sets up the ring of the calling thread, with provided buffers of buf_size
+ * for about tunnels splices at full speed; more share them.
+ */
+int hev_task_io_uring_init (size_t buf_size, unsigned int tunnels);
+int hev_task_io_uring_enabled (void);
+
+void hev_task_io_uring_splice (int fd_a_i, int fd_a_o, int fd_b_i, int fd_b_o,
+                               HevTaskIOYielder yielder, void *yielder_data);
+
+HevTaskIOUringAccept *hev_task_io_uring_accept_new (int fd);
+void hev_task_io_uring_accept_destroy (HevTaskIOUringAccept *self);
+
+int hev_task_io_uring_accept (HevTaskIOUringAccept *self);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HEV_TASK_IO_URING_H__ */
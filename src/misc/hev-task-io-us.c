@@ -7,99 +7,614 @@
  ============================================================================
  */
 
+#define _GNU_SOURCE
 #include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
+#ifdef __linux__
+#include <linux/errqueue.h>
+#endif
 
 #include <hev-task.h>
 #include <hev-task-io.h>
 #include <hev-task-io-socket.h>
-#include <hev-circular-buffer.h>
+
+#include "hev-logger.h"
+#include "hev-object-pool.h"
 
 #include "hev-task-io-us.h"
 
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+
+#ifndef SO_EE_CODE_ZEROCOPY_COPIED
+#define SO_EE_CODE_ZEROCOPY_COPIED 1
+#endif
+
+/* below this, page pinning and the completion cost more than a copy */
+#define TASK_IO_ZEROCOPY_MIN (16384)
+
+/* passes a blocked fd is left alone while the other direction runs */
+#define TASK_IO_BLOCK_PASSES (8)
+
+typedef struct _HevTaskIOBuffer HevTaskIOBuffer;
 typedef struct _HevTaskIOSplicer HevTaskIOSplicer;
+typedef enum _HevTaskIOStall HevTaskIOStall;
+
+enum _HevTaskIOStall
+{
+    TASK_IO_STALL_READ,  /* source drained */
+    TASK_IO_STALL_WRITE, /* sink full */
+    TASK_IO_STALL_MARK,  /* both buffers full (high watermark) */
+    TASK_IO_STALL_ZC,    /* buffer space pinned by zerocopy sends */
+    TASK_IO_STALL_MAX,
+};
+
+struct _HevTaskIOBuffer
+{
+    size_t rp;
+    size_t wp;
+    size_t size;
+    uint32_t zc_id;
+    unsigned int zc_busy : 1;
+    unsigned char data[0];
+};
 
+/*
+ * One direction: a FIFO of at most two linear buffers. Reads append to the
+ * tail while the head drains, so reading goes on while writes are blocked
+ * until both are full, and a head pinned by MSG_ZEROCOPY is never touched.
+ */
 struct _HevTaskIOSplicer
 {
-    HevCircularBuffer *buf;
+    HevTaskIOBuffer *q[2];
+    size_t buf_size;
+    size_t buf_min;
+    size_t buf_max;
+    size_t bytes;
+
+    /* splice(2) through a pipe instead of buffers, when pfd[0] >= 0 */
+    int pfd[2];
+    size_t pipe_use;
+
+    int zc;
+    uint32_t zc_next;
+    uint32_t zc_done;
+
+    unsigned int rblock;
+    unsigned int wblock;
+    unsigned int eof : 1;
+    unsigned int shut : 1;
+    unsigned int rhead : 1;
+
+    unsigned int stalls[TASK_IO_STALL_MAX];
 };
 
+static HevTaskIOBuffer *
+task_io_buffer_new (size_t size)
+{
+    HevTaskIOBuffer *self;
+
+    self = hev_object_pool_malloc (sizeof (HevTaskIOBuffer) + size);
+    if (!self)
+        return NULL;
+
+    self->rp = 0;
+    self->wp = 0;
+    self->size = size;
+    self->zc_busy = 0;
+
+    return self;
+}
+
+static void
+task_io_buffer_destroy (HevTaskIOBuffer *self)
+{
+    hev_object_pool_free (self);
+}
+
+static void
+task_io_splicer_init (HevTaskIOSplicer *self, size_t buf_min, size_t buf_max)
+{
+    if (buf_max < buf_min)
+        buf_max = buf_min;
+
+    memset (self, 0, sizeof (HevTaskIOSplicer));
+    self->buf_size = buf_min;
+    self->buf_min = buf_min;
+    self->buf_max = buf_max;
+    self->pfd[0] = -1;
+    self->pfd[1] = -1;
+}
+
 static int
-task_io_splicer_init (HevTaskIOSplicer *self, size_t buf_size)
+task_io_splicer_pipe_init (HevTaskIOSplicer *self)
 {
-    self->buf = hev_circular_buffer_new (buf_size);
-    if (!self->buf)
+#ifdef __linux__
+    if (pipe2 (self->pfd, O_NONBLOCK | O_CLOEXEC) < 0)
         return -1;
 
+    /* pipe capacity is charged to the user whether used or not */
+    fcntl (self->pfd[1], F_SETPIPE_SZ, self->buf_min);
+
     return 0;
+#else
+    return -1;
+#endif
+}
+
+static int
+task_io_splicer_zc_busy (HevTaskIOSplicer *self)
+{
+    return (self->q[0] && self->q[0]->zc_busy) ||
+           (self->q[1] && self->q[1]->zc_busy);
 }
 
 static void
-task_io_splicer_fini (HevTaskIOSplicer *self)
+task_io_splicer_zc_reap (HevTaskIOSplicer *self, int fd)
 {
-    if (self->buf)
-        hev_circular_buffer_unref (self->buf);
+#ifdef __linux__
+    char control[CMSG_SPACE (sizeof (struct sock_extended_err))];
+    int i;
+
+    for (;;) {
+        struct sock_extended_err *serr;
+        struct msghdr msg = { 0 };
+        struct cmsghdr *cm;
+
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof (control);
+        if (recvmsg (fd, &msg, MSG_ERRQUEUE) < 0)
+            break;
+
+        cm = CMSG_FIRSTHDR (&msg);
+        if (!cm)
+            continue;
+
+        serr = (struct sock_extended_err *)CMSG_DATA (cm);
+        if ((serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY) || serr->ee_errno)
+            continue;
+
+        /* TCP completes in order: [ee_info, ee_data] are all done */
+        self->zc_done = serr->ee_data + 1;
+
+        /* the kernel had to copy (loopback, no SG): stop pinning pages */
+        if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+            self->zc = -1;
+    }
+
+    for (i = 0; i < 2; i++) {
+        HevTaskIOBuffer *buf = self->q[i];
+
+        if (buf && buf->zc_busy && ((int32_t)(self->zc_done - buf->zc_id) > 0))
+            buf->zc_busy = 0;
+    }
+#endif
+}
+
+/* Drop or recycle buffers whose data is out and no longer pinned. */
+static void
+task_io_splicer_settle (HevTaskIOSplicer *self)
+{
+    HevTaskIOBuffer *head = self->q[0];
+
+    if (!head || (head->rp < head->wp) || head->zc_busy)
+        return;
+
+    if (self->q[1]) {
+        /* a mostly idle head: shrink what the next buffers get */
+        if ((head->wp < (head->size / 4)) && (self->buf_size > self->buf_min))
+            self->buf_size /= 2;
+        task_io_buffer_destroy (head);
+        self->q[0] = self->q[1];
+        self->q[1] = NULL;
+        return;
+    }
+
+    head->rp = 0;
+    head->wp = 0;
+}
+
+static void
+task_io_splicer_release (HevTaskIOSplicer *self)
+{
+    int i;
+
+    /* borrow buffers from the pool only while data is in flight */
+    for (i = 1; i >= 0; i--) {
+        HevTaskIOBuffer *buf = self->q[i];
+
+        if (buf && (buf->wp == 0) && !buf->zc_busy) {
+            task_io_buffer_destroy (buf);
+            self->q[i] = NULL;
+        }
+    }
+
+    if (!self->q[0] && self->q[1]) {
+        self->q[0] = self->q[1];
+        self->q[1] = NULL;
+    }
+}
+
+static void
+task_io_splicer_fini (HevTaskIOSplicer *self, int fd)
+{
+    int i;
+
+    if (task_io_splicer_zc_busy (self))
+        task_io_splicer_zc_reap (self, fd);
+
+    for (i = 0; i < 2; i++) {
+        HevTaskIOBuffer *buf = self->q[i];
+
+        if (!buf)
+            continue;
+
+        /*
+         * The kernel may still send from pages pinned by zerocopy once fd
+         * is closed: leaked, they are never refilled with other data.
+         */
+        if (buf->zc_busy)
+            continue;
+
+        task_io_buffer_destroy (buf);
+    }
+    if (self->pfd[0] >= 0) {
+        close (self->pfd[0]);
+        close (self->pfd[1]);
+    }
+}
+
+static int
+task_io_splicer_reading (HevTaskIOSplicer *self, struct iovec *iov)
+{
+    HevTaskIOBuffer *head = self->q[0];
+    HevTaskIOBuffer *tail = self->q[1];
+    int iovc = 0;
+
+    if (!head) {
+        head = task_io_buffer_new (self->buf_size);
+        if (!head)
+            return -1;
+        self->q[0] = head;
+    }
+
+    /* the head may only grow while nothing is queued behind it */
+    self->rhead = (!tail || !tail->wp) && (head->wp < head->size);
+    if (self->rhead) {
+        iov[iovc].iov_base = head->data + head->wp;
+        iov[iovc].iov_len = head->size - head->wp;
+        iovc++;
+    }
+
+    if (!tail && head->wp) {
+        tail = task_io_buffer_new (self->buf_size);
+        self->q[1] = tail;
+    }
+
+    if (tail && (tail->wp < tail->size)) {
+        iov[iovc].iov_base = tail->data + tail->wp;
+        iov[iovc].iov_len = tail->size - tail->wp;
+        iovc++;
+    }
+
+    return iovc;
+}
+
+static void
+task_io_splicer_read_finish (HevTaskIOSplicer *self, struct iovec *iov,
+                             int iovc, size_t size)
+{
+    HevTaskIOBuffer *head = self->q[0];
+    size_t total = size;
+    size_t room = 0;
+    int i;
+
+    for (i = 0; i < iovc; i++)
+        room += iov[i].iov_len;
+
+    if (self->rhead) {
+        size_t n = (size < iov[0].iov_len) ? size : iov[0].iov_len;
+
+        head->wp += n;
+        size -= n;
+    }
+    if (size)
+        self->q[1]->wp += size;
+
+    /* all offered room taken: the socket likely has more queued */
+    if ((total == room) && (self->buf_size < self->buf_max)) {
+        self->buf_size *= 2;
+        if (self->buf_size > self->buf_max)
+            self->buf_size = self->buf_max;
+    }
+}
+
+static int
+task_io_splicer_writing (HevTaskIOSplicer *self, struct iovec *iov)
+{
+    int iovc = 0;
+    int i;
+
+    for (i = 0; i < 2; i++) {
+        HevTaskIOBuffer *buf = self->q[i];
+
+        if (buf && (buf->rp < buf->wp)) {
+            iov[iovc].iov_base = buf->data + buf->rp;
+            iov[iovc].iov_len = buf->wp - buf->rp;
+            iovc++;
+        }
+    }
+
+    return iovc;
+}
+
+static void
+task_io_splicer_write_finish (HevTaskIOSplicer *self, size_t size, int zc)
+{
+    int i;
+
+    self->bytes += size;
+
+    for (i = 0; (i < 2) && size; i++) {
+        HevTaskIOBuffer *buf = self->q[i];
+        size_t n;
+
+        if (!buf || (buf->rp == buf->wp))
+            continue;
+
+        n = buf->wp - buf->rp;
+        if (n > size)
+            n = size;
+        buf->rp += n;
+        size -= n;
+
+        if (zc) {
+            buf->zc_id = self->zc_next;
+            buf->zc_busy = 1;
+        }
+    }
+
+    if (zc)
+        self->zc_next++;
+}
+
+static ssize_t
+task_io_splicer_send (HevTaskIOSplicer *self, int fd, struct iovec *iov,
+                      int iovc, size_t len, int *zc)
+{
+    struct msghdr msg = { 0 };
+    ssize_t s;
+    int one = 1;
+
+    *zc = 0;
+    if ((len < TASK_IO_ZEROCOPY_MIN) || (self->zc < 0))
+        return writev (fd, iov, iovc);
+
+    if (!self->zc) {
+        /* TCP only; pipes and unix sockets take the copy below */
+        if (setsockopt (fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof (one)) < 0) {
+            self->zc = -1;
+            return writev (fd, iov, iovc);
+        }
+        self->zc = 1;
+    }
+
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovc;
+    s = sendmsg (fd, &msg, MSG_ZEROCOPY | MSG_NOSIGNAL);
+    if (s >= 0) {
+        *zc = 1;
+        return s;
+    }
+
+    switch (errno) {
+    case EOPNOTSUPP: /* e.g. a kTLS socket */
+    case EINVAL:
+        self->zc = -1;
+        return writev (fd, iov, iovc);
+    case ENOBUFS: /* optmem limit: copy this time */
+        return writev (fd, iov, iovc);
+    }
+
+    return s;
 }
 
 static int
 task_io_splice (HevTaskIOSplicer *self, int fd_in, int fd_out)
 {
     struct iovec iov[2];
+    HevTaskIOStall stall = TASK_IO_STALL_MAX;
     int res = 1, iovc;
 
-    iovc = hev_circular_buffer_writing (self->buf, iov);
-    if (iovc) {
-        ssize_t s = readv (fd_in, iov, iovc);
+    if (task_io_splicer_zc_busy (self)) {
+        task_io_splicer_zc_reap (self, fd_out);
+        task_io_splicer_settle (self);
+    }
+
+    if (self->eof) {
+        res = -1;
+    } else if (self->rblock) {
+        self->rblock--;
+        res = 0;
+        stall = TASK_IO_STALL_READ;
+    } else {
+        iovc = task_io_splicer_reading (self, iov);
+        if (iovc < 0)
+            return -1;
+        if (iovc) {
+            ssize_t s = readv (fd_in, iov, iovc);
+            if (0 >= s) {
+                if ((0 > s) && (EAGAIN == errno)) {
+                    self->rblock = TASK_IO_BLOCK_PASSES;
+                    stall = TASK_IO_STALL_READ;
+                    res = 0;
+                } else {
+                    self->eof = 1;
+                    res = -1;
+                }
+            } else {
+                task_io_splicer_read_finish (self, iov, iovc, s);
+            }
+        } else {
+            int zc = task_io_splicer_zc_busy (self);
+
+            stall = zc ? TASK_IO_STALL_ZC : TASK_IO_STALL_MARK;
+            res = 0;
+        }
+    }
+
+    iovc = task_io_splicer_writing (self, iov);
+    if (iovc && self->wblock) {
+        self->wblock--;
+        if (res < 0)
+            res = 0;
+        stall = TASK_IO_STALL_WRITE;
+    } else if (iovc) {
+        size_t len = iov[0].iov_len + ((iovc > 1) ? iov[1].iov_len : 0);
+        ssize_t s;
+        int zc;
+
+        s = task_io_splicer_send (self, fd_out, iov, iovc, len, &zc);
+        if (0 >= s) {
+            if ((0 > s) && (EAGAIN == errno)) {
+                self->wblock = TASK_IO_BLOCK_PASSES;
+                stall = TASK_IO_STALL_WRITE;
+                res = 0;
+            } else {
+                res = -1;
+            }
+        } else {
+            res = 1;
+            task_io_splicer_write_finish (self, s, zc);
+            task_io_splicer_settle (self);
+        }
+    } else if ((res < 0) && !self->shut) {
+        shutdown (fd_out, SHUT_WR);
+        self->shut = 1;
+    }
+
+    if ((res == 0) && (stall < TASK_IO_STALL_MAX))
+        self->stalls[stall]++;
+
+    if (res == 0)
+        task_io_splicer_release (self);
+
+    /* unsent data or pinned pages keep the direction alive */
+    if ((res < 0) && self->eof && task_io_splicer_zc_busy (self))
+        res = 0;
+
+    return res;
+}
+
+#ifdef __linux__
+static int
+task_io_splice_pipe (HevTaskIOSplicer *self, int fd_in, int fd_out)
+{
+    int flags = SPLICE_F_MOVE | SPLICE_F_NONBLOCK;
+    HevTaskIOStall stall = TASK_IO_STALL_MARK;
+    int res = 1;
+    ssize_t s;
+
+    if (self->pipe_use < self->buf_min) {
+        s = splice (fd_in, NULL, self->pfd[1], NULL,
+                    self->buf_min - self->pipe_use, flags);
         if (0 >= s) {
-            if ((0 > s) && (EAGAIN == errno))
+            if ((0 > s) && (EAGAIN == errno)) {
+                stall = TASK_IO_STALL_READ;
                 res = 0;
-            else
+            } else {
                 res = -1;
+            }
         } else {
-            hev_circular_buffer_write_finish (self->buf, s);
+            self->pipe_use += s;
         }
     }
 
-    iovc = hev_circular_buffer_reading (self->buf, iov);
-    if (iovc) {
-        ssize_t s = writev (fd_out, iov, iovc);
+    if (self->pipe_use) {
+        s = splice (self->pfd[0], NULL, fd_out, NULL, self->pipe_use, flags);
         if (0 >= s) {
-            if ((0 > s) && (EAGAIN == errno))
+            if ((0 > s) && (EAGAIN == errno)) {
+                stall = TASK_IO_STALL_WRITE;
                 res = 0;
-            else
+            } else {
                 res = -1;
+            }
         } else {
             res = 1;
-            hev_circular_buffer_read_finish (self->buf, s);
+            self->pipe_use -= s;
+            self->bytes += s;
         }
     } else if (res < 0) {
         shutdown (fd_out, SHUT_WR);
     }
 
+    if (res == 0)
+        self->stalls[stall]++;
+
     return res;
 }
+#endif
 
-void
-hev_task_io_us_splice (int fd_a_i, int fd_a_o, int fd_b_i, int fd_b_o,
-                       size_t buf_size, HevTaskIOYielder yielder,
-                       void *yielder_data)
+static int
+task_io_splicer_run (HevTaskIOSplicer *self, int fd_in, int fd_out)
+{
+#ifdef __linux__
+    if (self->pfd[0] >= 0)
+        return task_io_splice_pipe (self, fd_in, fd_out);
+#endif
+
+    return task_io_splice (self, fd_in, fd_out);
+}
+
+static void
+task_io_splicer_report (HevTaskIOSplicer *self, void *data, const char *dir)
+{
+    unsigned int *st = self->stalls;
+
+    LOG_D ("%p task io us %s %zu bytes, stalls read %u write %u mark %u zc %u",
+           data, dir, self->bytes, st[TASK_IO_STALL_READ],
+           st[TASK_IO_STALL_WRITE], st[TASK_IO_STALL_MARK],
+           st[TASK_IO_STALL_ZC]);
+}
+
+static void
+task_io_us_splice (int fd_a_i, int fd_a_o, int fd_b_i, int fd_b_o,
+                   size_t buf_min, size_t buf_max, int pipe_f,
+                   HevTaskIOYielder yielder, void *yielder_data)
 {
     HevTaskIOSplicer splicer_f;
     HevTaskIOSplicer splicer_b;
     int res_f = 1;
     int res_b = 1;
 
-    if (task_io_splicer_init (&splicer_f, buf_size) < 0)
-        return;
-    if (task_io_splicer_init (&splicer_b, buf_size) < 0)
-        goto exit;
+    task_io_splicer_init (&splicer_f, buf_min, buf_max);
+    task_io_splicer_init (&splicer_b, buf_min, buf_max);
+
+    /* without a pipe, a -> b falls back to the buffers like b -> a */
+    if (pipe_f)
+        task_io_splicer_pipe_init (&splicer_f);
 
     for (;;) {
         HevTaskYieldType type;
 
         if (res_f >= 0)
-            res_f = task_io_splice (&splicer_f, fd_a_i, fd_b_o);
+            res_f = task_io_splicer_run (&splicer_f, fd_a_i, fd_b_o);
         if (res_b >= 0)
-            res_b = task_io_splice (&splicer_b, fd_b_i, fd_a_o);
+            res_b = task_io_splicer_run (&splicer_b, fd_b_i, fd_a_o);
 
         if (res_f > 0 || res_b > 0)
             type = HEV_TASK_YIELD;
@@ -108,6 +623,12 @@ hev_task_io_us_splice (int fd_a_i, int fd_a_o, int fd_b_i, int fd_b_o,
         else
             break;
 
+        /* woken by I/O: blocked fds are worth another try */
+        if (type == HEV_TASK_WAITIO) {
+            splicer_f.rblock = splicer_f.wblock = 0;
+            splicer_b.rblock = splicer_b.wblock = 0;
+        }
+
         if (yielder) {
             if (yielder (type, yielder_data))
                 break;
@@ -116,7 +637,29 @@ hev_task_io_us_splice (int fd_a_i, int fd_a_o, int fd_b_i, int fd_b_o,
         }
     }
 
-    task_io_splicer_fini (&splicer_b);
-exit:
-    task_io_splicer_fini (&splicer_f);
+    if (LOG_ON_D ()) {
+        task_io_splicer_report (&splicer_f, yielder_data, "a->b");
+        task_io_splicer_report (&splicer_b, yielder_data, "b->a");
+    }
+
+    task_io_splicer_fini (&splicer_b, fd_a_o);
+    task_io_splicer_fini (&splicer_f, fd_b_o);
+}
+
+void
+hev_task_io_us_splice (int fd_a_i, int fd_a_o, int fd_b_i, int fd_b_o,
+                       size_t buf_min, size_t buf_max,
+                       HevTaskIOYielder yielder, void *yielder_data)
+{
+    task_io_us_splice (fd_a_i, fd_a_o, fd_b_i, fd_b_o, buf_min, buf_max, 0,
+                       yielder, yielder_data);
+}
+
+void
+hev_task_io_us_splice_tx (int fd_a_i, int fd_a_o, int fd_b_i, int fd_b_o,
+                          size_t buf_min, size_t buf_max,
+                          HevTaskIOYielder yielder, void *yielder_data)
+{
+    task_io_us_splice (fd_a_i, fd_a_o, fd_b_i, fd_b_o, buf_min, buf_max, 1,
+                       yielder, yielder_data);
 }
@@ -15,8 +15,17 @@ extern "C" {
 #endif
 
 void hev_task_io_us_splice (int fd_a_i, int fd_a_o, int fd_b_i, int fd_b_o,
-                            size_t buf_size, HevTaskIOYielder yielder,
-                            void *yielder_data);
+                            size_t buf_min, size_t buf_max,
+                            HevTaskIOYielder yielder, void *yielder_data);
+
+/*
+ * As above, but a -> b goes through a pipe with splice(2): kTLS encrypts
+ * spliced pages on TX, so fd_b_o may be a kTLS socket whose RX must not be
+ * spliced from (older kernels). b -> a still copies through the buffer.
+ */
+void hev_task_io_us_splice_tx (int fd_a_i, int fd_a_o, int fd_b_i, int fd_b_o,
+                               size_t buf_min, size_t buf_max,
+                               HevTaskIOYielder yielder, void *yielder_data);
 
 #ifdef __cplusplus
 }